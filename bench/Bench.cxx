@@ -0,0 +1,630 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+// Headless benchmark for the raster kernels. Nothing here opens a window,
+// the progress bar is disabled and everything works on synthetic images.
+//
+// Each workload is run a number of times and printed as one JSON object per
+// line, so results can be collected by scripts and compared between builds.
+
+#ifndef PACKAGE_STRING
+#  include "config.h"
+#endif
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "BlendSimd.H"
+#include "Brush.H"
+#include "File.H"
+#include "Fractal.H"
+#include "FX/Bloom.H"
+#include "FX/Desaturate.H"
+#include "FX/Equalize.H"
+#include "FX/GaussianBlur.H"
+#include "FX/Painting.H"
+#include "FX/Restore.H"
+#include "FX/RotateHue.H"
+#include "FX/Sharpen.H"
+#include "FX/Sobel.H"
+#include "FX/StainedGlass.H"
+#include "FX/UnsharpMask.H"
+#include "Gamma.H"
+#include "Inline.H"
+#include "KDtree.H"
+#include "Map.H"
+#include "Palette.H"
+#include "Progress.H"
+#include "Quantize.H"
+#include "Threads.H"
+
+#include "Check.H"
+
+namespace
+{
+  enum
+  {
+    OPTION_SIZE,
+    OPTION_ITERATIONS,
+    OPTION_FILTER,
+    OPTION_TEMP_DIR,
+    OPTION_LIST,
+    OPTION_CHECK,
+    OPTION_HELP
+  };
+
+  int verbose_flag;
+
+  struct option long_options[] =
+  {
+    { "size", required_argument, &verbose_flag, OPTION_SIZE },
+    { "iterations", required_argument, &verbose_flag, OPTION_ITERATIONS },
+    { "filter", required_argument, &verbose_flag, OPTION_FILTER },
+    { "temp-dir", required_argument, &verbose_flag, OPTION_TEMP_DIR },
+    { "list", no_argument, &verbose_flag, OPTION_LIST },
+    { "check", no_argument, &verbose_flag, OPTION_CHECK },
+    { "help", no_argument, &verbose_flag, OPTION_HELP },
+    { 0, 0, 0, 0 }
+  };
+
+  struct bench_type
+  {
+    const char *name;
+
+    // called before each run, not timed
+    std::function<void ()> setup;
+
+    // the work being measured
+    std::function<void ()> run;
+  };
+
+  int width = 2048;
+  int height = 2048;
+  int iterations = 5;
+  const char *filter = 0;
+  const char *temp_dir = "/tmp";
+
+  // repeatable noise
+  unsigned int hash(unsigned int x)
+  {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+
+    return x;
+  }
+
+  // smooth gradients with some noise and a few flat areas, so kernels
+  // that depend on content (quantization, fills, png) see something like
+  // a real image
+  void makeImage(Bitmap *bmp)
+  {
+    for (int y = 0; y < bmp->h; y++)
+    {
+      int *p = bmp->row[y];
+
+      for (int x = 0; x < bmp->w; x++)
+      {
+        const unsigned int n = hash(y * bmp->w + x);
+        const int r = (x * 255) / bmp->w;
+        const int g = (y * 255) / bmp->h;
+        const int b = ((x + y) * 127) / (bmp->w + bmp->h) + (n & 31);
+        const int a = 192 + ((n >> 8) & 63);
+
+        if (((x >> 6) + (y >> 6)) % 7 == 0)
+          p[x] = makeRgba(32, 64, 160, 255);
+        else
+          p[x] = makeRgba(r, g, std::min(b, 255), a);
+      }
+    }
+  }
+
+  void printHelp()
+  {
+    printf("Usage: rendera_bench [OPTIONS]\n\n");
+    printf("--size=<w>x<h>\t\t image size (default 2048x2048)\n");
+    printf("--iterations=<value>\t runs of each workload (default 5)\n");
+    printf("--filter=<text>\t\t only run workloads with this in the name\n");
+    printf("--temp-dir=<path>\t where to write files (default /tmp)\n");
+    printf("--list\t\t\t list workloads\n");
+    printf("--check\t\t\t compare fast paths with reference code\n\n");
+    printf("Results are printed as one JSON object per line.\n\n");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  int option_index = 0;
+  bool list = false;
+  bool check = false;
+
+  while (true)
+  {
+    const int c = getopt_long(argc, argv, "", long_options, &option_index);
+    if (c < 0)
+      break;
+
+    if (c != 0)
+    {
+      printHelp();
+      return 1;
+    }
+
+    switch (option_index)
+    {
+      case OPTION_SIZE:
+        if (sscanf(optarg, "%dx%d", &width, &height) != 2 ||
+            width < 16 || height < 16)
+        {
+          printHelp();
+          return 1;
+        }
+
+        break;
+
+      case OPTION_ITERATIONS:
+        iterations = std::max(atoi(optarg), 1);
+        break;
+
+      case OPTION_FILTER:
+        filter = optarg;
+        break;
+
+      case OPTION_TEMP_DIR:
+        temp_dir = optarg;
+        break;
+
+      case OPTION_LIST:
+        list = true;
+        break;
+
+      case OPTION_CHECK:
+        check = true;
+        break;
+
+      default:
+        printHelp();
+        return 0;
+    }
+  }
+
+  Gamma::init();
+  BlendSimd::init();
+  Threads::init();
+  Progress::enable(false);
+
+  // exit status tells scripts whether anything failed
+  if (check)
+    return Check::run(filter) > 0 ? 1 : 0;
+
+  Bitmap source(width, height);
+  Bitmap bmp(width, height);
+  Map map(width, height);
+
+  makeImage(&source);
+
+  auto restore = [&]()
+  {
+    source.blit(&bmp, 0, 0, 0, 0, width, height);
+  };
+
+  std::vector<bench_type> benches;
+
+  // rasterization
+  benches.push_back(bench_type { "line", restore, [&]()
+  {
+    for (int i = 0; i < 10000; i++)
+    {
+      const unsigned int n = hash(i);
+
+      bmp.line(n % width, (n >> 8) % height,
+               (n >> 4) % width, (n >> 12) % height,
+               makeRgb(255, 0, 0), 0);
+    }
+  }});
+
+  benches.push_back(bench_type { "map_line_aa", [&]() { map.clear(0); }, [&]()
+  {
+    for (int i = 0; i < 10000; i++)
+    {
+      const unsigned int n = hash(i);
+
+      map.lineAA(n % width, (n >> 8) % height,
+                 (n >> 4) % width, (n >> 12) % height, 255);
+    }
+  }});
+
+  benches.push_back(bench_type { "map_oval", [&]() { map.clear(0); }, [&]()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      const unsigned int n = hash(i);
+      const int x = n % width;
+      const int y = (n >> 8) % height;
+      const int r = 1 + (n >> 20) % 256;
+
+      map.oval(x - r, y - r, x + r, y + r, 255);
+    }
+  }});
+
+  benches.push_back(bench_type { "map_ovalfill", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      const unsigned int n = hash(i);
+      const int x = n % width;
+      const int y = (n >> 8) % height;
+      const int r = 1 + (n >> 20) % 256;
+
+      map.ovalfill(x - r, y - r, x + r, y + r, 255);
+    }
+  }});
+
+  benches.push_back(bench_type { "map_ovalfill_aa", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      const unsigned int n = hash(i);
+      const int x = n % width;
+      const int y = (n >> 8) % height;
+      const int r = 1 + (n >> 20) % 256;
+
+      map.ovalfillAA(x - r, y - r, x + r, y + r, 255);
+    }
+  }});
+
+  // freehand brushstroke made of short segments, like a mouse drag
+  static Brush brush;
+  brush.make(64, 1.0);
+
+  benches.push_back(bench_type { "brush_sweep", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      const int x = (i * 7) % width;
+      const int y = height / 2 + (i % 64) - 32;
+
+      map.sweep(x, y, x + 7, y + 3, brush.spanx1, brush.spanx2,
+                brush.span_y, brush.span_count, 255);
+    }
+  }});
+
+  benches.push_back(bench_type { "brush_sweep_aa", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      const int x = (i * 7) % width;
+      const int y = height / 2 + (i % 64) - 32;
+
+      map.sweepAA(x, y, x + 7, y + 3, brush.spanx1, brush.spanx2,
+                  brush.span_y, brush.span_count, 255);
+    }
+  }});
+
+  // lasso-style polygon with many vertices
+  static std::vector<int> lasso_x, lasso_y;
+
+  for (int i = 0; i < 4000; i++)
+  {
+    const double angle = i * 6.283185307 / 4000;
+    const double radius = (0.4 + 0.05 * std::sin(angle * 37)) *
+                          std::min(width, height);
+
+    lasso_x.push_back(width / 2 + radius * std::cos(angle));
+    lasso_y.push_back(height / 2 + radius * std::sin(angle));
+  }
+
+  benches.push_back(bench_type { "polyfill", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    map.polyfill(&lasso_x[0], &lasso_y[0], lasso_x.size(),
+                 0, height - 1, 255);
+  }});
+
+  benches.push_back(bench_type { "polyfill_aa", [&]() { map.clear(0); },
+                                 [&]()
+  {
+    map.polyfillAA(&lasso_x[0], &lasso_y[0], lasso_x.size(),
+                   0, height - 1, 255);
+  }});
+
+  // blending, one full-image span pass per mode
+  const char *blend_names[] =
+  {
+    "blend_trans", "blend_gamma_correct", "blend_lighten", "blend_darken",
+    "blend_colorize", "blend_luminosity", "blend_alpha_add",
+    "blend_alpha_sub", "blend_smooth", "blend_trans_alpha",
+    "blend_trans_no_alpha"
+  };
+
+  std::vector<unsigned char> coverage(width, 255);
+
+  for (int mode = Blend::TRANS; mode <= Blend::TRANS_NO_ALPHA; mode++)
+  {
+    benches.push_back(bench_type { blend_names[mode], restore, [&, mode]()
+    {
+      Blend::set(mode);
+
+      for (int y = 0; y < height; y++)
+      {
+        Blend::span(&bmp, &coverage[0], 0, width - 1, y,
+                    makeRgb(200, 120, 40), 96, false);
+      }
+
+      Blend::set(Blend::TRANS);
+    }});
+  }
+
+  // filters
+  const int radii[] = { 1, 3, 8, 32 };
+  const char *blur_names[] =
+  {
+    "gaussian_blur_1", "gaussian_blur_3", "gaussian_blur_8", "gaussian_blur_32"
+  };
+
+  for (int i = 0; i < 4; i++)
+  {
+    const int radius = radii[i];
+
+    benches.push_back(bench_type { blur_names[i], restore, [&, radius]()
+    {
+      GaussianBlur::apply(bmp, bmp, { (float)radius, 0, 0 });
+    }});
+  }
+
+  benches.push_back(bench_type { "sharpen", restore, [&]()
+  {
+    Sharpen::apply(bmp, bmp, { 10 });
+  }});
+
+  benches.push_back(bench_type { "unsharp_mask", restore, [&]()
+  {
+    UnsharpMask::apply(bmp, bmp, { 2, 1.5, 0 });
+  }});
+
+  benches.push_back(bench_type { "sobel", restore, [&]()
+  {
+    Sobel::apply(bmp, bmp, { 0 });
+  }});
+
+  benches.push_back(bench_type { "bloom", restore, [&]()
+  {
+    Bloom::apply(bmp, bmp, { 8, 128, 0 });
+  }});
+
+  benches.push_back(bench_type { "equalize", restore, [&]()
+  {
+    Equalize::apply(bmp, bmp, {});
+  }});
+
+  benches.push_back(bench_type { "desaturate", restore, [&]()
+  {
+    Desaturate::apply(bmp, bmp, {});
+  }});
+
+  benches.push_back(bench_type { "rotate_hue", restore, [&]()
+  {
+    RotateHue::apply(bmp, bmp, { 90, true, true });
+  }});
+
+  benches.push_back(bench_type { "restore", restore, [&]()
+  {
+    Restore::apply(bmp, bmp, { true });
+  }});
+
+  benches.push_back(bench_type { "painting", restore, [&]()
+  {
+    Painting::apply(bmp, bmp, { 3 });
+  }});
+
+  benches.push_back(bench_type { "stained_glass", restore, [&]()
+  {
+    StainedGlass::apply(bmp, bmp, { 25, false, true, 12345 });
+  }});
+
+  benches.push_back(bench_type { "plasma", [&]() { map.clear(0); }, [&]()
+  {
+    Fractal::plasma(&map, 8);
+  }});
+
+  // edge distance, as used by the fine airbrush and fill feathering
+  auto edgeMap = [&]()
+  {
+    map.clear(0);
+
+    for (int i = 0; i < 64; i++)
+    {
+      const unsigned int n = hash(i + 12345);
+      const int x = n % width;
+      const int y = (n >> 8) % height;
+      const int r = 16 + (n >> 20) % 256;
+
+      map.ovalfill(x - r, y - r, x + r, y + r, 255);
+    }
+  };
+
+  std::vector<int> dist;
+
+  benches.push_back(bench_type { "map_distance", edgeMap, [&]()
+  {
+    map.distance(dist, 0, 0, width - 1, height - 1);
+  }});
+
+  // blurry airbrush at the largest edge setting
+  benches.push_back(bench_type { "map_blur", edgeMap, [&]()
+  {
+    map.blur(0, 0, width - 1, height - 1, 41 * 0.44f);
+  }});
+
+  // the method map_distance replaced
+  benches.push_back(bench_type { "kdtree_distance", edgeMap, [&]()
+  {
+    std::vector<KDtree::node_type> points;
+
+    for (int y = 0; y < height; y++)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        if (map.isEdge(x, y))
+        {
+          KDtree::node_type node;
+
+          node.x[0] = x;
+          node.x[1] = y;
+          points.push_back(node);
+        }
+      }
+    }
+
+    if (points.size() == 0)
+      return;
+
+    KDtree::build(&points[0], points.size());
+    dist.resize(width * height);
+
+    KDtree::node_type test_node;
+    int best_distance;
+
+    for (int y = 0; y < height; y++)
+    {
+      int found = -1;
+
+      for (int x = 0; x < width; x++)
+      {
+        test_node.x[0] = x;
+        test_node.x[1] = y;
+        KDtree::nearest(&points[0], points.size(), &test_node,
+                        &found, &best_distance);
+        dist[y * width + x] = best_distance;
+      }
+    }
+  }});
+
+  // palettes
+  Palette pal;
+  int palette_seed = 0;
+
+  benches.push_back(bench_type { "palette_table", [&]()
+  {
+    // all new colors, so the whole table is rebuilt
+    pal.max = 256;
+
+    for (int i = 0; i < 256; i++)
+    {
+      const unsigned int n = hash(palette_seed++);
+      pal.data[i] = makeRgb(n & 255, (n >> 8) & 255, (n >> 16) & 255);
+    }
+  }, [&]()
+  {
+    pal.fillTable();
+  }});
+
+  benches.push_back(bench_type { "quantize_256", restore, [&]()
+  {
+    Quantize::pca(&bmp, &pal, 256, 3000);
+  }});
+
+  benches.push_back(bench_type { "quantize_256_sampled", restore, [&]()
+  {
+    Quantize::pca(&bmp, &pal, 256, 3000, true);
+  }});
+
+  // files
+  const std::string png_name = std::string(temp_dir) + "/rendera_bench.png";
+
+  benches.push_back(bench_type { "png_save", restore, [&]()
+  {
+    File::writePng(&bmp, png_name.c_str(), 0, false, true, 2);
+  }});
+
+  benches.push_back(bench_type { "png_load", [&]()
+  {
+    File::writePng(&source, png_name.c_str(), 0, false, true, 2);
+  }, [&]()
+  {
+    delete File::loadPng(png_name.c_str());
+  }});
+
+  if (list)
+  {
+    for (auto &bench : benches)
+      printf("%s\n", bench.name);
+
+    return 0;
+  }
+
+  for (auto &bench : benches)
+  {
+    if (filter && strstr(bench.name, filter) == 0)
+      continue;
+
+    double best = 0;
+    double total = 0;
+
+    for (int i = 0; i < iterations; i++)
+    {
+      bench.setup();
+
+      const auto start = std::chrono::steady_clock::now();
+      bench.run();
+      const auto end = std::chrono::steady_clock::now();
+
+      const double ms =
+        std::chrono::duration<double, std::milli>(end - start).count();
+
+      if (i == 0 || ms < best)
+        best = ms;
+
+      total += ms;
+    }
+
+    const double mean = total / iterations;
+    const double mpix = (double)width * height / 1e6;
+
+    printf("{\"name\": \"%s\", \"width\": %d, \"height\": %d, "
+           "\"threads\": %d, \"iterations\": %d, \"best_ms\": %.3f, "
+           "\"mean_ms\": %.3f, \"mpix_per_s\": %.2f}\n",
+           bench.name, width, height, Threads::count(), iterations,
+           best, mean, best > 0 ? mpix / (best / 1000) : 0);
+    fflush(stdout);
+  }
+
+  unlink(png_name.c_str());
+
+  return 0;
+}
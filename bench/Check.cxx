@@ -0,0 +1,864 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+// Correctness checks for kernels that have more than one implementation.
+// Each check compares the fast path against a plain reference over sampled
+// inputs and prints one JSON object per line. Run with "rendera_bench
+// --check", the exit status is non-zero if anything differs.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "BlendSimd.H"
+#include "Brush.H"
+#include "Inline.H"
+#include "Map.H"
+#include "Render.H"
+
+#include "Check.H"
+
+namespace
+{
+  struct check_type
+  {
+    const char *name;
+    int (*run)();
+  };
+
+  // repeatable noise
+  unsigned int seed = 1;
+
+  unsigned int noise()
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return seed;
+  }
+
+  // mostly random colors, with the extremes the blend math is most
+  // likely to get wrong
+  int sampleColor()
+  {
+    switch (noise() & 7)
+    {
+      case 0:
+        return makeRgba(0, 0, 0, 0);
+      case 1:
+        return makeRgba(255, 255, 255, 255);
+      case 2:
+        return makeRgba(noise() & 255, noise() & 255, noise() & 255, 255);
+      case 3:
+        return makeRgba(noise() & 255, noise() & 255, noise() & 255, 0);
+      default:
+        return (int)noise();
+    }
+  }
+
+  int sampleTrans()
+  {
+    static const int edges[] = { 0, 1, 127, 128, 254, 255 };
+
+    if (noise() & 1)
+      return edges[noise() % 6];
+
+    return noise() & 255;
+  }
+
+  // runs of empty, solid and partial coverage like a rasterized shape,
+  // with some pure noise rows mixed in
+  void sampleCoverage(unsigned char *coverage, const int w)
+  {
+    if ((noise() & 3) == 0)
+    {
+      for (int x = 0; x < w; x++)
+        coverage[x] = noise() & 255;
+
+      return;
+    }
+
+    int x = 0;
+
+    while (x < w)
+    {
+      const int len = 1 + noise() % 24;
+      int value;
+
+      switch (noise() % 3)
+      {
+        case 0:
+          value = 0;
+          break;
+        case 1:
+          value = 255;
+          break;
+        default:
+          value = noise() & 255;
+          break;
+      }
+
+      for (int i = 0; i < len && x < w; i++)
+        coverage[x++] = value;
+    }
+  }
+
+  const char *levelName(const int level)
+  {
+    switch (level)
+    {
+      case BlendSimd::SSE2:
+        return "sse2";
+      case BlendSimd::AVX2:
+        return "avx2";
+      default:
+        return "none";
+    }
+  }
+
+  // a few filled shapes, some touching the sides, and stray pixels
+  // (254 counts as empty once the edge passes mask the map)
+  void sampleShapes(Map *map)
+  {
+    map->clear(0);
+
+    const int count = 1 + noise() % 8;
+
+    for (int i = 0; i < count; i++)
+    {
+      const int cx = noise() % map->w;
+      const int cy = noise() % map->h;
+      const int r = 1 + noise() % 40;
+
+      if (noise() & 1)
+        map->ovalfill(cx - r, cy - r, cx + r, cy + r, 255);
+      else
+        map->rectfill(cx - r, cy - r / 3, cx + r / 2, cy + r, 255);
+    }
+
+    const int stray = noise() % 50;
+
+    for (int i = 0; i < stray; i++)
+    {
+      map->setpixel(noise() % map->w, noise() % map->h,
+                    (noise() % 3) == 0 ? 254 : 255);
+    }
+  }
+
+  // the multi-pass edge loops the coarse, chalk and watercolor modes used
+  // before Map::shrinkDepth() and Map::distance(), kept as they were
+  // (less the viewport updates) to check the current ones against
+  namespace Reference
+  {
+    struct stroke_type
+    {
+      int x1, y1, x2, y2;
+    };
+
+    Bitmap *bmp;
+    Map *map;
+    stroke_type *stroke;
+    int color;
+    int trans;
+
+    void span(const int y, const int t, const bool antialiased)
+    {
+      if (y < 0 || y >= map->h)
+        return;
+
+      Blend::span(bmp, map->row[y], std::max(stroke->x1, 0),
+                  std::min(stroke->x2, map->w - 1), y, color, t, antialiased);
+    }
+
+    void coarse(const int edge)
+    {
+      float soft_trans = 255;
+      const int j = (3 << edge);
+      float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+      bool found = false;
+
+      for (int i = 0; i < j; i++)
+      {
+        for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
+        {
+          for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
+          {
+            unsigned char *s0 = map->row[y] + x;
+            unsigned char *s1 = map->row[y] + x + 1;
+            unsigned char *s2 = map->row[y + 1] + x;
+            unsigned char *s3 = map->row[y + 1] + x + 1;
+
+            *s0 &= 1;
+            *s1 &= 1;
+            *s2 &= 1;
+            *s3 &= 1;
+
+            if (*s0 | *s1 | *s2 | *s3)
+              found = true;
+
+            const unsigned char d0 = *s0;
+            const unsigned char d1 = *s1;
+            const unsigned char d2 = *s2;
+            const unsigned char d3 = *s3;
+
+            map->shrinkBlock(s0, s1, s2, s3);
+
+            if (!*s0 && d0)
+              bmp->setpixel(x, y, color, soft_trans);
+            if (!*s1 && d1)
+              bmp->setpixel(x + 1, y, color, soft_trans);
+            if (!*s2 && d2)
+              bmp->setpixel(x, y + 1, color, soft_trans);
+            if (!*s3 && d3)
+              bmp->setpixel(x + 1, y + 1, color, soft_trans);
+          }
+        }
+
+        if (!found)
+          break;
+
+        soft_trans -= soft_step;
+
+        if (soft_trans < trans)
+        {
+          soft_trans = trans;
+
+          for (int y = stroke->y1; y <= stroke->y2; y++)
+            span(y, soft_trans, false);
+
+          return;
+        }
+      }
+    }
+
+    int jitter(const float soft_trans)
+    {
+      int t = (int)soft_trans + (rnd() & 63) - 32;
+
+      if (t < 0)
+        t = 0;
+
+      if (t > 255)
+        t = 255;
+
+      return t;
+    }
+
+    void chalk(const int edge)
+    {
+      float soft_trans = 255;
+      int j = (3 << edge);
+      float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+      bool found = false;
+
+      if (edge == 0)
+      {
+        j = 1;
+        soft_trans = trans;
+      }
+
+      for (int i = 0; i < j; i++)
+      {
+        for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
+        {
+          for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
+          {
+            unsigned char *s0 = map->row[y] + x;
+            unsigned char *s1 = map->row[y] + x + 1;
+            unsigned char *s2 = map->row[y + 1] + x;
+            unsigned char *s3 = map->row[y + 1] + x + 1;
+
+            *s0 &= 1;
+            *s1 &= 1;
+            *s2 &= 1;
+            *s3 &= 1;
+
+            if (*s0 | *s1 | *s2 | *s3)
+              found = true;
+
+            unsigned char d0 = *s0;
+            unsigned char d1 = *s1;
+            unsigned char d2 = *s2;
+            unsigned char d3 = *s3;
+
+            map->shrinkBlock(s0, s1, s2, s3);
+
+            if (!*s0 && d0)
+              bmp->setpixel(x, y, color, jitter(soft_trans));
+
+            if (!*s1 && d1)
+              bmp->setpixel(x + 1, y, color, jitter(soft_trans));
+
+            if (!*s2 && d2)
+              bmp->setpixel(x, y + 1, color, jitter(soft_trans));
+
+            if (!*s3 && d3)
+              bmp->setpixel(x + 1, y + 1, color, jitter(soft_trans));
+          }
+        }
+
+        if (!found)
+          break;
+
+        soft_trans -= soft_step;
+
+        if (soft_trans < trans)
+        {
+          soft_trans = trans;
+
+          for (int y = stroke->y1; y <= stroke->y2; y++)
+          {
+            for (int x = stroke->x1; x <= stroke->x2; x++)
+            {
+              if (map->getpixel(x, y))
+                bmp->setpixel(x, y, color, jitter(soft_trans));
+            }
+          }
+
+          return;
+        }
+      }
+    }
+
+    void watercolor(const int edge)
+    {
+      float soft_trans = trans;
+      const int j = (2 << edge);
+      float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+      bool found = false;
+      int inc = 0;
+
+      for (int y = stroke->y1; y <= stroke->y2; y++)
+        span(y, trans, false);
+
+      for (int i = 0; i < j; i++)
+      {
+        inc++;
+
+        for (int y = stroke->y1 + (inc & 1); y < stroke->y2 - 1; y += 2)
+        {
+          for (int x = stroke->x1 + (inc & 1); x < stroke->x2 - 1; x += 2)
+          {
+            int yy = y + !(rnd() & 3);
+
+            unsigned char *s0 = map->row[yy] + x;
+            unsigned char *s1 = map->row[yy] + x + 1;
+            unsigned char *s2 = map->row[yy + 1] + x;
+            unsigned char *s3 = map->row[yy + 1] + x + 1;
+
+            *s0 &= 1;
+            *s1 &= 1;
+            *s2 &= 1;
+            *s3 &= 1;
+
+            if (*s0 | *s1 | *s2 | *s3)
+              found = true;
+
+            const unsigned char d0 = *s0;
+            const unsigned char d1 = *s1;
+            const unsigned char d2 = *s2;
+            const unsigned char d3 = *s3;
+
+            map->growBlock(s0, s1, s2, s3);
+
+            if (*s0 & (!(rnd() & 15)))
+            {
+              *s0 = 1;
+              *s1 = 1;
+              *s2 = 1;
+              *s3 = 1;
+              inc--;
+              inc--;
+            }
+
+            if (*s0 && !d0)
+              bmp->setpixel(x, yy, color, soft_trans);
+
+            if (*s1 && !d1)
+              bmp->setpixel(x + 1, yy, color, soft_trans);
+
+            if (*s2 && !d2)
+              bmp->setpixel(x, yy + 1, color, soft_trans);
+
+            if (*s3 && !d3)
+              bmp->setpixel(x + 1, yy + 1, color, soft_trans);
+          }
+        }
+
+        if (!found)
+          break;
+
+        soft_trans += soft_step;
+
+        if (soft_trans > 255)
+          break;
+      }
+    }
+  }
+
+  // renders the same shapes with the reference loop and with Render,
+  // the maps are left as each one finished with them
+  void renderBoth(const int mode, const int edge, const int trans,
+                  Bitmap *ref_bmp, Map *ref_map, Bitmap *bmp, Map *map)
+  {
+    Reference::stroke_type stroke =
+    {
+      (int)(noise() % 5), (int)(noise() % 5),
+      map->w - 1 - (int)(noise() % 5), map->h - 1 - (int)(noise() % 5)
+    };
+
+    const int color = makeRgba(0, 0, 0, 255);
+
+    ref_bmp->clear(makeRgba(255, 255, 255, 255));
+    bmp->clear(makeRgba(255, 255, 255, 255));
+    memcpy(ref_map->data, map->data, map->w * map->h);
+
+    Reference::bmp = ref_bmp;
+    Reference::map = ref_map;
+    Reference::stroke = &stroke;
+    Reference::color = color;
+    Reference::trans = trans;
+
+    Brush brush;
+
+    brush.coarse_edge = edge;
+    brush.chalk_edge = edge;
+    brush.watercolor_edge = edge;
+
+    Render::bmp = bmp;
+    Render::map = map;
+    Render::brush = &brush;
+    Render::color = color;
+    Render::trans = trans;
+    Render::x1 = stroke.x1;
+    Render::y1 = stroke.y1;
+    Render::x2 = stroke.x2;
+    Render::y2 = stroke.y2;
+    Render::update_callback = 0;
+
+    switch (mode)
+    {
+      case Render::COARSE:
+        Reference::coarse(edge);
+        break;
+      case Render::CHALK:
+        Reference::chalk(edge);
+        break;
+      case Render::WATERCOLOR:
+        Reference::watercolor(edge);
+        break;
+    }
+
+    Render::draw(mode);
+  }
+
+  // coarse and chalk must give the same pixels and leave the same map
+  int renderExact(const char *name, const int mode)
+  {
+    const int samples = 400;
+    int mismatches = 0;
+
+    seed = 9;
+    Blend::set(Blend::TRANS);
+
+    for (int i = 0; i < samples; i++)
+    {
+      const int w = 20 + noise() % 200;
+      const int h = 20 + noise() % 200;
+      const int trans = noise() & 255;
+      const int edge = noise() % 6;
+
+      Bitmap ref_bmp(w, h);
+      Bitmap bmp(w, h);
+      Map ref_map(w, h);
+      Map map(w, h);
+
+      sampleShapes(&map);
+
+      // a zero seed makes rnd() return zero every time, which holds the
+      // chalk jitter at the same value in both versions
+      rnd_seed = 0;
+      Render::seed(0);
+
+      renderBoth(mode, edge, trans, &ref_bmp, &ref_map, &bmp, &map);
+
+      if (memcmp(ref_bmp.data, bmp.data, w * h * sizeof(int)) != 0 ||
+          memcmp(ref_map.data, map.data, w * h) != 0)
+      {
+        mismatches++;
+      }
+    }
+
+    // zero would stay zero for the next stroke
+    Render::seed(12345);
+
+    printf("{\"check\": \"%s\", \"samples\": %d, \"mismatches\": %d}\n",
+           name, samples, mismatches);
+    fflush(stdout);
+
+    return mismatches > 0 ? 1 : 0;
+  }
+
+  // sums of the transparency left at each distance from the shape
+  struct ring_type
+  {
+    double ref_sum;
+    double ref_squares;
+    double sum;
+    double squares;
+    int count;
+  };
+
+  // paints sampled circles with both versions and collects ring sums,
+  // for modes whose edges are random and can't match pixel for pixel,
+  // inward counts the rings inside the shape instead of around it
+  std::vector<ring_type> renderRings(const int mode, const int edge,
+                                     const int trans, const int samples,
+                                     const bool inward)
+  {
+    const int w = 300;
+    const int h = 300;
+    const int rings = (3 << edge) + 2;
+
+    Bitmap ref_bmp(w, h);
+    Bitmap bmp(w, h);
+    Map ref_map(w, h);
+    Map map(w, h);
+    std::vector<ring_type> result(rings, ring_type { 0, 0, 0, 0, 0 });
+
+    for (int i = 0; i < samples; i++)
+    {
+      map.clear(0);
+
+      for (int j = 0; j < 4; j++)
+      {
+        const int cx = 60 + noise() % 180;
+        const int cy = 60 + noise() % 180;
+        const int r = 3 + noise() % 25;
+
+        map.ovalfill(cx - r, cy - r, cx + r, cy + r, 255);
+      }
+
+      std::vector<int> dist;
+      std::vector<unsigned char> inside(map.data, map.data + w * h);
+
+      map.distance(dist, 0, 0, w - 1, h - 1);
+      renderBoth(mode, edge, trans, &ref_bmp, &ref_map, &bmp, &map);
+
+      // painting black over white leaves the transparency in each channel
+      for (int y = 0; y < h; y++)
+      {
+        for (int x = 0; x < w; x++)
+        {
+          const int ring = std::sqrt(dist[y * w + x]);
+
+          if ((inside[y * w + x] != 0) != inward || ring >= rings)
+            continue;
+
+          const double ref_value = getr(ref_bmp.getpixel(x, y));
+          const double value = getr(bmp.getpixel(x, y));
+
+          result[ring].ref_sum += ref_value;
+          result[ring].ref_squares += ref_value * ref_value;
+          result[ring].sum += value;
+          result[ring].squares += value * value;
+          result[ring].count++;
+        }
+      }
+    }
+
+    return result;
+  }
+
+  double deviation(const double sum, const double squares, const int count)
+  {
+    const double mean = sum / count;
+
+    return std::sqrt(std::max(squares / count - mean * mean, 0.0));
+  }
+}
+
+// compares each vectorized blend mode with the scalar span path
+int Check::blendSpan()
+{
+  struct mode_type
+  {
+    const char *name;
+    int mode;
+  };
+
+  static const mode_type modes[] =
+  {
+    { "trans", Blend::TRANS },
+    { "trans_alpha", Blend::TRANS_ALPHA },
+    { "trans_no_alpha", Blend::TRANS_NO_ALPHA },
+    { "lighten", Blend::LIGHTEN },
+    { "darken", Blend::DARKEN }
+  };
+
+  static const int levels[] = { BlendSimd::SSE2, BlendSimd::AVX2 };
+
+  const int w = 301;
+  const int samples = 20000;
+  const int cpu_level = BlendSimd::level();
+
+  Bitmap ref(w, 1);
+  Bitmap simd(w, 1);
+  unsigned char coverage[w];
+  int failed = 0;
+
+  for (auto level : levels)
+  {
+    if (level > cpu_level)
+    {
+      printf("{\"check\": \"blend_span\", \"level\": \"%s\", "
+             "\"skipped\": true}\n", levelName(level));
+      continue;
+    }
+
+    for (auto &mode : modes)
+    {
+      int mismatches = 0;
+      int first_x = -1;
+      int first_ref = 0;
+      int first_simd = 0;
+
+      seed = 1;
+      Blend::set(mode.mode);
+
+      for (int i = 0; i < samples; i++)
+      {
+        for (int x = 0; x < w; x++)
+          ref.row[0][x] = sampleColor();
+
+        memcpy(simd.row[0], ref.row[0], w * sizeof(int));
+        sampleCoverage(coverage, w);
+
+        // short spans and odd offsets reach the tails of each vector loop
+        const int x1 = noise() % w;
+        const int x2 = (noise() & 1) ? x1 + noise() % 19 : x1 + noise() % (w - x1);
+        const int c = sampleColor();
+        const int t = sampleTrans();
+        const bool antialiased = noise() & 1;
+
+        BlendSimd::force(BlendSimd::NONE);
+        Blend::span(&ref, coverage, x1, x2, 0, c, t, antialiased);
+        BlendSimd::force(level);
+        Blend::span(&simd, coverage, x1, x2, 0, c, t, antialiased);
+
+        for (int x = 0; x < w; x++)
+        {
+          if (ref.row[0][x] != simd.row[0][x])
+          {
+            if (mismatches == 0)
+            {
+              first_x = x;
+              first_ref = ref.row[0][x];
+              first_simd = simd.row[0][x];
+            }
+
+            mismatches++;
+          }
+        }
+      }
+
+      printf("{\"check\": \"blend_span\", \"level\": \"%s\", "
+             "\"mode\": \"%s\", \"samples\": %d, \"mismatches\": %d",
+             levelName(level), mode.name, samples, mismatches);
+
+      if (mismatches > 0)
+      {
+        printf(", \"x\": %d, \"expected\": \"%08x\", \"got\": \"%08x\"",
+               first_x, (unsigned int)first_ref, (unsigned int)first_simd);
+        failed++;
+      }
+
+      printf("}\n");
+      fflush(stdout);
+    }
+  }
+
+  BlendSimd::force(cpu_level);
+  Blend::set(Blend::TRANS);
+
+  return failed;
+}
+
+// the coarse airbrush must match the multi-pass version exactly
+int Check::renderCoarse()
+{
+  return renderExact("render_coarse", Render::COARSE);
+}
+
+// chalk is the coarse airbrush with random transparency, so it has to
+// match exactly once the randomness is taken out
+int Check::renderChalk()
+{
+  return renderExact("render_chalk", Render::CHALK);
+}
+
+// watercolor edges are random in both versions, so compare the average
+// transparency at each distance from the shape instead
+int Check::renderWatercolor()
+{
+  const int samples = 20;
+
+  // the old edge was a little lighter right next to the shape at the
+  // smallest setting, about five levels, the rest is noise
+  const int tolerance = 10;
+  int failed = 0;
+
+  seed = 5;
+  rnd_seed = 12345;
+  Render::seed(12345);
+  Blend::set(Blend::TRANS);
+
+  for (int edge = 1; edge <= 4; edge++)
+  {
+    std::vector<ring_type> rings =
+      renderRings(Render::WATERCOLOR, edge, 0, samples, false);
+
+    int worst = 0;
+    int worst_ring = 0;
+
+    for (int ring = 1; ring < (int)rings.size(); ring++)
+    {
+      const ring_type &r = rings[ring];
+
+      if (r.count == 0)
+        continue;
+
+      const int diff = std::abs((int)std::lround(r.ref_sum / r.count) -
+                                (int)std::lround(r.sum / r.count));
+
+      if (diff > worst)
+      {
+        worst = diff;
+        worst_ring = ring;
+      }
+    }
+
+    printf("{\"check\": \"render_watercolor\", \"edge\": %d, "
+           "\"samples\": %d, \"worst_ring\": %d, \"worst_diff\": %d, "
+           "\"tolerance\": %d}\n",
+           edge, samples, worst_ring, worst, tolerance);
+    fflush(stdout);
+
+    if (worst > tolerance)
+      failed++;
+  }
+
+  return failed;
+}
+
+// the exact chalk check holds rnd() at zero, so this one runs with a real
+// seed and compares the mean and spread of the jitter at each distance
+int Check::renderChalkJitter()
+{
+  const int samples = 20;
+  const int trans = 64;
+  const int tolerance = 3;
+  int failed = 0;
+
+  seed = 7;
+  rnd_seed = 12345;
+  Render::seed(12345);
+  Blend::set(Blend::TRANS);
+
+  for (int edge = 1; edge <= 4; edge++)
+  {
+    std::vector<ring_type> rings =
+      renderRings(Render::CHALK, edge, trans, samples, true);
+
+    int worst_mean = 0;
+    int worst_deviation = 0;
+    int least_deviation = 255;
+
+    for (int ring = 0; ring < (int)rings.size(); ring++)
+    {
+      const ring_type &r = rings[ring];
+
+      // the middle of the bigger circles is too few pixels to average
+      if (r.count < 500)
+        continue;
+
+      const double ref_dev = deviation(r.ref_sum, r.ref_squares, r.count);
+      const double dev = deviation(r.sum, r.squares, r.count);
+
+      worst_mean = std::max(worst_mean,
+                            std::abs((int)std::lround(r.ref_sum / r.count) -
+                                     (int)std::lround(r.sum / r.count)));
+      worst_deviation = std::max(worst_deviation,
+                                 std::abs((int)std::lround(ref_dev) -
+                                          (int)std::lround(dev)));
+
+      if (r.sum / r.count < 255)
+        least_deviation = std::min(least_deviation, (int)std::lround(dev));
+    }
+
+    printf("{\"check\": \"render_chalk_jitter\", \"edge\": %d, "
+           "\"samples\": %d, \"worst_mean_diff\": %d, "
+           "\"worst_deviation_diff\": %d, \"least_deviation\": %d, "
+           "\"tolerance\": %d}\n",
+           edge, samples, worst_mean, worst_deviation, least_deviation,
+           tolerance);
+    fflush(stdout);
+
+    // a painted ring with no spread means the jitter went missing
+    if (worst_mean > tolerance || worst_deviation > tolerance ||
+        least_deviation == 0)
+    {
+      failed++;
+    }
+  }
+
+  return failed;
+}
+
+// runs the checks with filter in their name, returns the number of failures
+int Check::run(const char *filter)
+{
+  static const check_type checks[] =
+  {
+    { "blend_span", blendSpan },
+    { "render_coarse", renderCoarse },
+    { "render_chalk", renderChalk },
+    { "render_chalk_jitter", renderChalkJitter },
+    { "render_watercolor", renderWatercolor }
+  };
+
+  int failed = 0;
+
+  for (auto &check : checks)
+  {
+    if (filter && strstr(check.name, filter) == 0)
+      continue;
+
+    failed += check.run();
+  }
+
+  return failed;
+}
@@ -0,0 +1,653 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+// Batch mode applies a list of operations to many images without opening
+// any windows. Operations are separated by semicolons or newlines, with the
+// name first followed by its settings, for example:
+//
+//   rendera --batch="normalize; scale 50% 50%; quantize 64; dither floyd"
+//
+// A list starting with '@' is read from a file instead, where '#' starts a
+// comment. Settings use the same units as the filter dialogs. The random
+// filters take a seed (the same one for every file), so output repeats.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Batch.H"
+#include "Bitmap.H"
+#include "File.H"
+#include "FileSP.H"
+#include "Inline.H"
+#include "Palette.H"
+#include "Quantize.H"
+#include "Threads.H"
+#include "Transform.H"
+
+#include "FX/AlphaClear.H"
+#include "FX/AlphaInvert.H"
+#include "FX/Bloom.H"
+#include "FX/BoxFilters.H"
+#include "FX/Desaturate.H"
+#include "FX/Dither.H"
+#include "FX/Equalize.H"
+#include "FX/GaussianBlur.H"
+#include "FX/Invert.H"
+#include "FX/Normalize.H"
+#include "FX/Painting.H"
+#include "FX/Randomize.H"
+#include "FX/RemoveDust.H"
+#include "FX/Restore.H"
+#include "FX/RotateHue.H"
+#include "FX/Saturate.H"
+#include "FX/Sharpen.H"
+#include "FX/SideAbsorptions.H"
+#include "FX/Sobel.H"
+#include "FX/StainedGlass.H"
+#include "FX/UnsharpMask.H"
+#include "FX/ValueStretch.H"
+
+namespace
+{
+  struct operation_type
+  {
+    const char *name;
+    int min_args;
+    int max_args;
+    const char *usage;
+  };
+
+  const operation_type operations[] =
+  {
+    { "normalize", 0, 0, "" },
+    { "equalize", 0, 0, "" },
+    { "value_stretch", 0, 0, "" },
+    { "saturate", 0, 0, "" },
+    { "desaturate", 0, 0, "" },
+    { "invert", 0, 0, "" },
+    { "alpha_invert", 0, 0, "" },
+    { "alpha_clear", 0, 0, "" },
+    { "side_absorptions", 0, 0, "" },
+    { "randomize", 0, 1, "[seed]" },
+    { "rotate_hue", 1, 2, "<degrees> [preserve_lum]" },
+    { "gaussian_blur", 1, 3, "<size> [blend%] [mode]" },
+    { "sharpen", 0, 1, "[amount%]" },
+    { "unsharp_mask", 0, 3, "[radius] [amount] [threshold]" },
+    { "box_filter", 1, 2, "<mode> [amount%]" },
+    { "sobel", 0, 1, "[amount]" },
+    { "bloom", 0, 3, "[radius] [threshold] [blend%]" },
+    { "restore", 0, 1, "[preserve_lum]" },
+    { "remove_dust", 0, 1, "[amount]" },
+    { "painting", 0, 1, "[amount]" },
+    { "stained_glass", 0, 4, "[detail] [sat_alpha] [edges] [seed]" },
+    { "scale", 2, 4, "<width[%]> <height[%]> [mode] [wrap]" },
+    { "flip_horizontal", 0, 0, "" },
+    { "flip_vertical", 0, 0, "" },
+    { "rotate", 1, 1, "<90|180|270>" },
+    { "quantize", 0, 2, "[colors] [sampled]" },
+    { "palette", 1, 1, "<file.gpl>" },
+    { "dither", 0, 3, "[none|floyd|atkinson] [palette|bw] [bias]" },
+  };
+
+  const operation_type *findOperation(const std::string &name)
+  {
+    for (const operation_type &op : operations)
+    {
+      if (name == op.name)
+        return &op;
+    }
+
+    return 0;
+  }
+
+  int getInt(const std::vector<std::string> &args, const int index,
+             const int value)
+  {
+    if (index < (int)args.size())
+      return atoi(args[index].c_str());
+    else
+      return value;
+  }
+
+  double getFloat(const std::vector<std::string> &args, const int index,
+                  const double value)
+  {
+    if (index < (int)args.size())
+      return atof(args[index].c_str());
+    else
+      return value;
+  }
+
+  // size in pixels, or relative to the current size with a '%' suffix
+  int getSize(const std::string &arg, const int size)
+  {
+    if (!arg.empty() && arg.back() == '%')
+      return size * atof(arg.c_str()) / 100;
+    else
+      return atoi(arg.c_str());
+  }
+
+  bool hasAlpha(Bitmap *bmp)
+  {
+    for (int i = 0; i < bmp->w * bmp->h; i++)
+    {
+      if (geta(bmp->data[i]) < 255)
+        return true;
+    }
+
+    return false;
+  }
+
+  // input name with the new extension, in the output directory if given
+  std::string outputName(const char *fn, const char *dir, const char *ext)
+  {
+    std::string name = fn;
+    std::string path;
+
+    const size_t slash = name.find_last_of("/\\");
+
+    if (slash != std::string::npos)
+    {
+      path = name.substr(0, slash + 1);
+      name = name.substr(slash + 1);
+    }
+
+    const size_t dot = name.find_last_of('.');
+
+    if (dot != std::string::npos && dot > 0)
+      name = name.substr(0, dot);
+
+    if (dir)
+    {
+      path = dir;
+
+      if (!path.empty() && path.back() != '/' && path.back() != '\\')
+        path += '/';
+    }
+
+    return path + name + "." + ext;
+  }
+}
+
+void Batch::printOperations()
+{
+  printf("Batch operations:\n");
+
+  for (const operation_type &op : operations)
+    printf("  %s %s\n", op.name, op.usage);
+
+  printf("\n");
+}
+
+// split the operation list into steps and check them before any
+// images are loaded
+bool Batch::parse(const char *text, std::vector<step_type> &steps)
+{
+  std::string list;
+
+  if (text[0] == '@')
+  {
+    FileSP in(text + 1, "r");
+
+    if (!in.get())
+    {
+      fprintf(stderr, "Could not open batch file: %s\n", text + 1);
+      return false;
+    }
+
+    char buf[1024];
+
+    while (fgets(buf, sizeof(buf), in.get()))
+    {
+      char *comment = strchr(buf, '#');
+
+      if (comment)
+        *comment = '\0';
+
+      list += buf;
+      list += '\n';
+    }
+  }
+    else
+  {
+    list = text;
+  }
+
+  for (char &c : list)
+  {
+    if (c == ';')
+      c = '\n';
+  }
+
+  std::istringstream lines(list);
+  std::string line;
+
+  while (std::getline(lines, line))
+  {
+    std::istringstream words(line);
+    step_type step;
+
+    if (!(words >> step.name))
+      continue;
+
+    std::string arg;
+
+    while (words >> arg)
+      step.args.push_back(arg);
+
+    const operation_type *op = findOperation(step.name);
+
+    if (!op)
+    {
+      fprintf(stderr, "Unknown batch operation: %s\n", step.name.c_str());
+      return false;
+    }
+
+    const int count = step.args.size();
+
+    if (count < op->min_args || count > op->max_args)
+    {
+      fprintf(stderr, "Usage: %s %s\n", op->name, op->usage);
+      return false;
+    }
+
+    steps.push_back(step);
+  }
+
+  if (steps.empty())
+  {
+    fprintf(stderr, "No batch operations given.\n");
+    return false;
+  }
+
+  return true;
+}
+
+// apply one step, operations that make a new image replace *bmp
+bool Batch::apply(const step_type &step, Bitmap **bmp, Palette *pal,
+                  bool *has_palette)
+{
+  const std::string &name = step.name;
+  const std::vector<std::string> &args = step.args;
+  Bitmap *b = *bmp;
+
+  if (name == "normalize")
+  {
+    Normalize::apply(*b, *b, {});
+  }
+  else if (name == "equalize")
+  {
+    Equalize::apply(*b, *b, {});
+  }
+  else if (name == "value_stretch")
+  {
+    ValueStretch::apply(*b, *b, {});
+  }
+  else if (name == "saturate")
+  {
+    Saturate::apply(*b, *b, {});
+  }
+  else if (name == "desaturate")
+  {
+    Desaturate::apply(*b, *b, {});
+  }
+  else if (name == "invert")
+  {
+    Invert::apply(*b, *b, {});
+  }
+  else if (name == "alpha_invert")
+  {
+    AlphaInvert::apply(*b, *b, {});
+  }
+  else if (name == "alpha_clear")
+  {
+    AlphaClear::apply(*b, *b, {});
+  }
+  else if (name == "side_absorptions")
+  {
+    SideAbsorptions::apply(*b, *b, {});
+  }
+  else if (name == "randomize")
+  {
+    Randomize::params_type params;
+
+    params.random_seed = getInt(args, 0, 12345);
+    Randomize::apply(*b, *b, params);
+  }
+  else if (name == "rotate_hue")
+  {
+    RotateHue::params_type params;
+
+    params.angle = getInt(args, 0, 0) % 360;
+    params.keep_lum = getInt(args, 1, 0);
+    params.show_progress = false;
+    RotateHue::apply(*b, *b, params);
+  }
+  else if (name == "gaussian_blur")
+  {
+    GaussianBlur::params_type params;
+
+    params.size = getInt(args, 0, 1);
+    params.blend = 255 - getInt(args, 1, 100) * 2.55;
+    params.mode = getInt(args, 2, 0);
+    GaussianBlur::apply(*b, *b, params);
+  }
+  else if (name == "sharpen")
+  {
+    Sharpen::params_type params;
+
+    params.amount = getInt(args, 0, 10);
+    Sharpen::apply(*b, *b, params);
+  }
+  else if (name == "unsharp_mask")
+  {
+    UnsharpMask::params_type params;
+
+    params.radius = getInt(args, 0, 1);
+    params.amount = getFloat(args, 1, 1.5);
+    params.threshold = getInt(args, 2, 0);
+    UnsharpMask::apply(*b, *b, params);
+  }
+  else if (name == "box_filter")
+  {
+    BoxFilters::params_type params;
+
+    params.amount = getInt(args, 1, 50);
+    params.mode = getInt(args, 0, 0);
+    BoxFilters::apply(*b, *b, params);
+  }
+  else if (name == "sobel")
+  {
+    Sobel::params_type params;
+
+    params.amount = getInt(args, 0, 100);
+    Sobel::apply(*b, *b, params);
+  }
+  else if (name == "bloom")
+  {
+    Bloom::params_type params;
+
+    params.radius = getInt(args, 0, 16);
+    params.threshold = getInt(args, 1, 128);
+    params.blend = 255 - getInt(args, 2, 25) * 2.55;
+    Bloom::apply(*b, *b, params);
+  }
+  else if (name == "restore")
+  {
+    Restore::params_type params;
+
+    params.keep_lum = getInt(args, 0, 0);
+    Normalize::apply(*b, *b, {});
+    Restore::apply(*b, *b, params);
+  }
+  else if (name == "remove_dust")
+  {
+    RemoveDust::params_type params;
+
+    params.amount = getInt(args, 0, 4);
+    RemoveDust::apply(*b, *b, params);
+  }
+  else if (name == "painting")
+  {
+    Painting::params_type params;
+
+    params.amount = getInt(args, 0, 3);
+    Painting::apply(*b, *b, params);
+  }
+  else if (name == "stained_glass")
+  {
+    StainedGlass::params_type params;
+
+    params.detail = getInt(args, 0, 25);
+    params.sat_alpha = getInt(args, 1, 0);
+    params.draw_edges = getInt(args, 2, 0);
+    params.random_seed = getInt(args, 3, 12345);
+    StainedGlass::apply(*b, *b, params);
+  }
+  else if (name == "scale")
+  {
+    const int w = getSize(args[0], b->w);
+    const int h = getSize(args[1], b->h);
+
+    Bitmap *temp = Transform::scaleImage(b, w, h, getInt(args, 2, 2),
+                                         getInt(args, 3, 0));
+
+    if (!temp)
+      return false;
+
+    delete b;
+    *bmp = temp;
+  }
+  else if (name == "flip_horizontal")
+  {
+    b->flipHorizontal();
+  }
+  else if (name == "flip_vertical")
+  {
+    b->flipVertical();
+  }
+  else if (name == "rotate")
+  {
+    switch (getInt(args, 0, 0))
+    {
+      case 90:
+        b->rotate90(false);
+        break;
+      case 180:
+        b->rotate180();
+        break;
+      case 270:
+        b->rotate90(true);
+        break;
+      default:
+        return false;
+    }
+  }
+  else if (name == "quantize")
+  {
+    const int colors = getInt(args, 0, 256);
+
+    if (colors < 1 || colors > 256)
+      return false;
+
+    Quantize::pca(b, pal, colors, 3000, getInt(args, 1, 0));
+    pal->fillTable();
+    *has_palette = true;
+  }
+  else if (name == "palette")
+  {
+    if (pal->load(args[0].c_str()) < 0)
+      return false;
+
+    *has_palette = true;
+  }
+  else if (name == "dither")
+  {
+    int mode = Dither::THRESHOLD;
+    int color_mode = Dither::MODE_PALETTE;
+
+    if (args.size() > 0)
+    {
+      if (args[0] == "floyd")
+        mode = Dither::FLOYD;
+      else if (args[0] == "atkinson")
+        mode = Dither::ATKINSON;
+      else if (args[0] != "none")
+        return false;
+    }
+
+    if (args.size() > 1)
+    {
+      if (args[1] == "bw")
+        color_mode = Dither::MODE_BW;
+      else if (args[1] != "palette")
+        return false;
+    }
+
+    // default palette is black and white
+    if (*has_palette == false)
+    {
+      pal->fillTable();
+      *has_palette = true;
+    }
+
+    Dither::params_type params;
+
+    params.palette = pal;
+    params.dither_mode = mode;
+    params.color_mode = color_mode;
+    params.bias = getFloat(args, 2, 0);
+    Dither::apply(*b, *b, params);
+  }
+    else
+  {
+    return false;
+  }
+
+  return true;
+}
+
+// format is png, jpg, bmp or tga, jpeg quality may follow as "jpg:85"
+int Batch::save(Bitmap *bmp, Palette *pal, const bool has_palette,
+                const char *fn, const char *format)
+{
+  if (strncmp(format, "png", 3) == 0)
+  {
+    const bool use_alpha = hasAlpha(bmp);
+
+    // indexed with two alpha levels if the palette has room for them
+    if (has_palette)
+    {
+      if (use_alpha && pal->max * 2 > 256)
+        return File::writePng(bmp, fn, pal, true, false, 2);
+      else
+        return File::writePng(bmp, fn, pal, true, use_alpha, 2);
+    }
+
+    return File::writePng(bmp, fn, pal, false, use_alpha, 256);
+  }
+  else if (strncmp(format, "jpg", 3) == 0 || strncmp(format, "jpeg", 4) == 0)
+  {
+    const char *quality = strchr(format, ':');
+
+    return File::writeJpeg(bmp, fn, quality ? atoi(quality + 1) : 90);
+  }
+  else if (strncmp(format, "bmp", 3) == 0)
+  {
+    return File::saveBmp(bmp, fn);
+  }
+  else if (strncmp(format, "tga", 3) == 0)
+  {
+    return File::saveTarga(bmp, fn);
+  }
+
+  return -1;
+}
+
+// returns the number of images that failed, files are processed
+// concurrently with each image's filters running on a single thread
+int Batch::run(const char *list, const char *output_dir, const char *format,
+               char **files, const int count)
+{
+  std::vector<step_type> steps;
+
+  if (!parse(list, steps))
+    return -1;
+
+  if (count < 1)
+  {
+    fprintf(stderr, "No input files given.\n");
+    return -1;
+  }
+
+  std::string ext = format;
+  const size_t colon = ext.find(':');
+
+  if (colon != std::string::npos)
+    ext = ext.substr(0, colon);
+
+  if (ext != "png" && ext != "jpg" && ext != "jpeg" &&
+      ext != "bmp" && ext != "tga")
+  {
+    fprintf(stderr, "Unknown output format: %s\n", format);
+    return -1;
+  }
+
+  std::atomic<int> failed(0);
+
+  auto process = [&](const int i)
+  {
+    const char *fn = files[i];
+    const std::string out = outputName(fn, output_dir, ext.c_str());
+
+    if (out == fn)
+    {
+      fprintf(stderr, "%s: output would replace the input\n", fn);
+      failed++;
+      return;
+    }
+
+    Bitmap *bmp = File::loadImage(fn);
+
+    if (!bmp)
+    {
+      fprintf(stderr, "Could not load image: %s\n", fn);
+      failed++;
+      return;
+    }
+
+    Palette pal;
+    bool has_palette = false;
+
+    for (const step_type &step : steps)
+    {
+      if (!apply(step, &bmp, &pal, &has_palette))
+      {
+        fprintf(stderr, "%s: %s failed\n", fn, step.name.c_str());
+        delete bmp;
+        failed++;
+        return;
+      }
+    }
+
+    if (save(bmp, &pal, has_palette, out.c_str(), format) < 0)
+    {
+      fprintf(stderr, "Could not save image: %s\n", out.c_str());
+      failed++;
+    }
+      else
+    {
+      printf("%s -> %s\n", fn, out.c_str());
+    }
+
+    delete bmp;
+  };
+
+  // filters called from inside a job run serially, so each thread
+  // works on its own image
+  Threads::run(0, count - 1, process);
+
+  return failed;
+}
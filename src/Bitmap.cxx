@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "Bitmap.H"
@@ -28,7 +29,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Gamma.H"
 #include "Inline.H"
 #include "Palette.H"
-#include "Project.H"
 #include "Stroke.H"
 
 static inline int xorValue(const int x, const int y)
@@ -56,7 +56,6 @@ Bitmap::Bitmap(int width, int height)
   y = 0;
   w = width;
   h = height;
-  undo_mode = 0;
 
   setClip(0, 0, w - 1, h - 1);
 
@@ -84,7 +83,6 @@ Bitmap::Bitmap(int width, int height, int *image_data)
   y = 0;
   w = width;
   h = height;
-  undo_mode = 0;
 
   for (int i = 0; i < height; i++)
     row[i] = &data[width * i];
@@ -129,6 +127,19 @@ void Bitmap::clear(const int c)
     data[i] = c;
 }
 
+// makes this a copy of src, clip area included
+void Bitmap::copy(const Bitmap *src)
+{
+  if (src == this)
+    return;
+
+  if (w != src->w || h != src->h)
+    resize(src->w, src->h);
+
+  memcpy(data, src->data, sizeof(int) * w * h);
+  setClip(src->cl, src->ct, src->cr, src->cb);
+}
+
 void Bitmap::hline(int x1, int y, int x2, int c, int t)
 {
   if (x1 > x2)
@@ -548,7 +559,7 @@ void Bitmap::setpixelClone(const int x, const int y, const int, const int t)
   int x1 = x - Clone::dx;
   int y1 = y - Clone::dy;
 
-  Stroke *stroke = Project::stroke;
+  Stroke *stroke = Clone::stroke;
 
   int c2;
 
@@ -565,7 +576,7 @@ void Bitmap::setpixelClone(const int x, const int y, const int, const int t)
   *c1 = Blend::current(*c1, c2, t);
 }
 
-int Bitmap::getpixel(int x, int y)
+int Bitmap::getpixel(int x, int y) const
 {
   if (x < cl)
     x = cl;
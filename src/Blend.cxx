@@ -23,11 +23,14 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 
 #include "Bitmap.H"
 #include "Blend.H"
+#include "BlendSimd.H"
+#include "Clone.H"
 #include "Gamma.H"
 #include "Inline.H"
 #include "Palette.H"
 
 int (*Blend::current_blend)(const int, const int, const int) = &Blend::trans;
+int Blend::current_mode = Blend::TRANS;
 Bitmap *Blend::bmp;
 int Blend::xpos;
 int Blend::ypos;
@@ -35,6 +38,8 @@ int Blend::ypos;
 // sets the blending mode for future operations
 void Blend::set(const int mode)
 {
+  current_mode = mode;
+
   switch (mode)
   {
     case TRANS:
@@ -71,6 +76,7 @@ void Blend::set(const int mode)
       current_blend = transNoAlpha;
       break;
     default:
+      current_mode = TRANS;
       current_blend = trans;
       break;
   }
@@ -90,6 +96,126 @@ int Blend::current(const int c1, const int c2, const int t)
   return (*current_blend)(c1, c2, t);
 }
 
+// blends color c into row y from x1 to x2, skipping pixels where the
+// coverage row (a map row, indexed by x) is zero
+// if antialiased is set, coverage also scales the transparency like
+// scaleVal(255 - coverage, t), otherwise any nonzero value uses t as-is
+// the blending mode is resolved here once per span instead of per pixel
+void Blend::span(Bitmap *b, const unsigned char *coverage, int x1, int x2,
+                 const int y, const int c, const int t,
+                 const bool antialiased)
+{
+  if (y < b->ct || y > b->cb)
+    return;
+
+  x1 = std::max(x1, b->cl);
+  x2 = std::min(x2, b->cr);
+
+  if (x1 > x2)
+    return;
+
+  // clone source changes per pixel, use the regular path
+  if (Clone::active)
+  {
+    for (int x = x1; x <= x2; x++)
+    {
+      const int s = coverage[x];
+
+      if (s > 0)
+        b->setpixel(x, y, c, antialiased ? scaleVal(255 - s, t) : t);
+    }
+
+    return;
+  }
+
+  // vectorized modes do what they can, the rest is finished below
+  x1 += BlendSimd::span(current_mode, b->row[y] + x1, coverage + x1,
+                        x2 - x1 + 1, c, t, antialiased);
+
+  if (x1 > x2)
+    return;
+
+  switch (current_mode)
+  {
+    case TRANS:
+      spanMode<trans, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case GAMMA_CORRECT:
+      spanMode<gammaCorrect, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case LIGHTEN:
+      spanMode<lighten, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case DARKEN:
+      spanMode<darken, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case COLORIZE:
+      spanMode<colorize, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case LUMINOSITY:
+      spanMode<luminosity, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case ALPHA_ADD:
+      spanMode<alphaAdd, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case ALPHA_SUB:
+      spanMode<alphaSub, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case SMOOTH:
+      // reads neighboring pixels, so needs the blend target
+      spanMode<smooth, true>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case TRANS_ALPHA:
+      spanMode<transAlpha, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+    case TRANS_NO_ALPHA:
+      spanMode<transNoAlpha, false>(b, coverage, x1, x2, y, c, t, antialiased);
+      break;
+  }
+}
+
+template <int (*blend)(const int, const int, const int), bool use_target>
+void Blend::spanMode(Bitmap *b, const unsigned char *coverage,
+                     const int x1, const int x2, const int y,
+                     const int c, const int t, const bool antialiased)
+{
+  int *p = b->row[y] + x1;
+  const unsigned char *s = coverage + x1;
+
+  if (antialiased)
+  {
+    for (int x = x1; x <= x2; x++)
+    {
+      if (*s > 0)
+      {
+        if (use_target)
+          target(b, x, y);
+
+        *p = blend(*p, c, scaleVal(255 - *s, t));
+      }
+
+      p++;
+      s++;
+    }
+  }
+    else
+  {
+    for (int x = x1; x <= x2; x++)
+    {
+      if (*s > 0)
+      {
+        if (use_target)
+          target(b, x, y);
+
+        *p = blend(*p, c, t);
+      }
+
+      p++;
+      s++;
+    }
+  }
+}
+
 int Blend::transAlpha(const int c1, const int c2, const int t)
 {
   const rgba_type rgba1 = getRgba(c1);
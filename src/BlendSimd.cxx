@@ -0,0 +1,352 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+// Vectorized versions of the Blend::span() inner loop for the trans,
+// transAlpha, transNoAlpha, lighten and darken modes.
+//
+// Channels are widened to 16 bits so t * channel (at most 255 * 255) fits
+// without overflow, and x / 255 is computed as (x + 1 + (x >> 8)) >> 8,
+// which is exact for 0 <= x <= 65025. Signed differences are divided as
+// sign * (|x| / 255) to match C++ truncation, so results are identical to
+// the scalar functions in Blend.cxx.
+
+#include <cstring>
+
+#include "Blend.H"
+#include "BlendSimd.H"
+#include "Inline.H"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLEND_SIMD_X86
+#include <immintrin.h>
+#endif
+
+int BlendSimd::simd_level = BlendSimd::NONE;
+int BlendSimd::cpu_level = BlendSimd::NONE;
+
+namespace
+{
+  enum
+  {
+    OP_TRANS,
+    OP_TRANS_ALPHA,
+    OP_TRANS_NO_ALPHA,
+    OP_LIGHTEN,
+    OP_DARKEN
+  };
+
+#ifdef BLEND_SIMD_X86
+  // 128-bit versions, two pixels per register
+
+  __attribute__((target("sse2")))
+  inline __m128i div255(const __m128i x)
+  {
+    const __m128i one = _mm_set1_epi16(1);
+
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one),
+                                        _mm_srli_epi16(x, 8)), 8);
+  }
+
+  // c1 is the destination, c2 the color (or darken operand),
+  // f the per-channel transparency factor
+  template <int op>
+  __attribute__((target("sse2")))
+  inline __m128i blend(const __m128i c1, const __m128i c2, const __m128i f)
+  {
+    const __m128i alpha = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+    if (op == OP_LIGHTEN)
+    {
+      return _mm_add_epi16(c1, div255(_mm_mullo_epi16(c2, f)));
+    }
+    else if (op == OP_DARKEN)
+    {
+      // subtract from color channels, add to alpha
+      const __m128i neg = _mm_andnot_si128(alpha, _mm_set1_epi16(-1));
+      const __m128i q = div255(_mm_mullo_epi16(c2, f));
+
+      return _mm_add_epi16(c1, _mm_sub_epi16(_mm_xor_si128(q, neg), neg));
+    }
+
+    const __m128i d = _mm_sub_epi16(c1, c2);
+    const __m128i m = _mm_srai_epi16(d, 15);
+    const __m128i ad = _mm_sub_epi16(_mm_xor_si128(d, m), m);
+    const __m128i q = div255(_mm_mullo_epi16(ad, f));
+    const __m128i r = _mm_add_epi16(c2, _mm_sub_epi16(_mm_xor_si128(q, m), m));
+
+    if (op == OP_TRANS_ALPHA)
+      return _mm_or_si128(_mm_and_si128(alpha, r), _mm_andnot_si128(alpha, c1));
+    else if (op == OP_TRANS_NO_ALPHA)
+      return _mm_or_si128(_mm_and_si128(alpha, c1), _mm_andnot_si128(alpha, r));
+    else
+      return r;
+  }
+
+  // per-pixel transparency for four pixels, in the low four 16-bit lanes
+  template <int op>
+  __attribute__((target("sse2")))
+  inline __m128i factor(const __m128i cov16, const int t, const bool aa)
+  {
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i t16 = _mm_set1_epi16(t);
+    __m128i tt = t16;
+
+    // scaleVal(255 - coverage, t)
+    if (aa)
+    {
+      tt = _mm_add_epi16(div255(_mm_mullo_epi16(_mm_sub_epi16(full, cov16),
+                                                _mm_sub_epi16(full, t16))),
+                         t16);
+    }
+
+    if (op == OP_LIGHTEN || op == OP_DARKEN)
+      tt = _mm_sub_epi16(full, tt);
+
+    return tt;
+  }
+
+  template <int op>
+  __attribute__((target("sse2")))
+  int spanSse2(int *p, const unsigned char *s, const int count,
+               const int operand, const int t, const bool aa)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c2 = _mm_unpacklo_epi8(_mm_set1_epi32(operand), zero);
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+      int cov;
+
+      std::memcpy(&cov, s + i, 4);
+
+      if (cov == 0)
+        continue;
+
+      const __m128i cov16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(cov), zero);
+      const __m128i t32 = _mm_unpacklo_epi16(factor<op>(cov16, t, aa), zero);
+      const __m128i pair = _mm_or_si128(t32, _mm_slli_epi32(t32, 16));
+      const __m128i px = _mm_loadu_si128((const __m128i *)(p + i));
+
+      const __m128i lo = blend<op>(_mm_unpacklo_epi8(px, zero), c2,
+                                   _mm_unpacklo_epi32(pair, pair));
+      const __m128i hi = blend<op>(_mm_unpackhi_epi8(px, zero), c2,
+                                   _mm_unpackhi_epi32(pair, pair));
+
+      // leave pixels with no coverage alone
+      const __m128i skip =
+        _mm_cmpeq_epi32(_mm_unpacklo_epi16(cov16, zero), zero);
+      const __m128i res = _mm_packus_epi16(lo, hi);
+
+      _mm_storeu_si128((__m128i *)(p + i),
+                       _mm_or_si128(_mm_and_si128(skip, px),
+                                    _mm_andnot_si128(skip, res)));
+    }
+
+    return i;
+  }
+
+  // 256-bit versions, four pixels per register
+
+  __attribute__((target("avx2")))
+  inline __m256i div255(const __m256i x)
+  {
+    const __m256i one = _mm256_set1_epi16(1);
+
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one),
+                                              _mm256_srli_epi16(x, 8)), 8);
+  }
+
+  template <int op>
+  __attribute__((target("avx2")))
+  inline __m256i blend(const __m256i c1, const __m256i c2, const __m256i f)
+  {
+    const __m256i alpha = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0,
+                                           -1, 0, 0, 0, -1, 0, 0, 0);
+
+    if (op == OP_LIGHTEN)
+    {
+      return _mm256_add_epi16(c1, div255(_mm256_mullo_epi16(c2, f)));
+    }
+    else if (op == OP_DARKEN)
+    {
+      const __m256i neg = _mm256_andnot_si256(alpha, _mm256_set1_epi16(-1));
+      const __m256i q = div255(_mm256_mullo_epi16(c2, f));
+
+      return _mm256_add_epi16(c1, _mm256_sub_epi16(_mm256_xor_si256(q, neg),
+                                                   neg));
+    }
+
+    const __m256i d = _mm256_sub_epi16(c1, c2);
+    const __m256i m = _mm256_srai_epi16(d, 15);
+    const __m256i ad = _mm256_sub_epi16(_mm256_xor_si256(d, m), m);
+    const __m256i q = div255(_mm256_mullo_epi16(ad, f));
+    const __m256i r = _mm256_add_epi16(c2, _mm256_sub_epi16(
+                                             _mm256_xor_si256(q, m), m));
+
+    if (op == OP_TRANS_ALPHA)
+      return _mm256_blendv_epi8(c1, r, alpha);
+    else if (op == OP_TRANS_NO_ALPHA)
+      return _mm256_blendv_epi8(r, c1, alpha);
+    else
+      return r;
+  }
+
+  template <int op>
+  __attribute__((target("avx2")))
+  int spanAvx2(int *p, const unsigned char *s, const int count,
+               const int operand, const int t, const bool aa)
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c2 = _mm256_unpacklo_epi8(_mm256_set1_epi32(operand), zero);
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+      long long cov;
+
+      std::memcpy(&cov, s + i, 8);
+
+      if (cov == 0)
+        continue;
+
+      const __m128i cov8 = _mm_loadl_epi64((const __m128i *)(s + i));
+      const __m128i cov16 = _mm_unpacklo_epi8(cov8, _mm_setzero_si128());
+
+      // lane order matches the pixel unpack below: pixels 0-3 in the
+      // low 128 bits, 4-7 in the high 128 bits
+      const __m256i t32 = _mm256_cvtepu16_epi32(factor<op>(cov16, t, aa));
+      const __m256i pair = _mm256_or_si256(t32, _mm256_slli_epi32(t32, 16));
+      const __m256i px = _mm256_loadu_si256((const __m256i *)(p + i));
+
+      const __m256i lo = blend<op>(_mm256_unpacklo_epi8(px, zero), c2,
+                                   _mm256_unpacklo_epi32(pair, pair));
+      const __m256i hi = blend<op>(_mm256_unpackhi_epi8(px, zero), c2,
+                                   _mm256_unpackhi_epi32(pair, pair));
+
+      const __m256i skip =
+        _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(cov8), zero);
+      const __m256i res = _mm256_packus_epi16(lo, hi);
+
+      _mm256_storeu_si256((__m256i *)(p + i),
+                          _mm256_blendv_epi8(res, px, skip));
+    }
+
+    // remaining group of four, if any
+    return i + spanSse2<op>(p + i, s + i, count - i, operand, t, aa);
+  }
+
+  template <int op>
+  int spanLevel(const int level, int *p, const unsigned char *s,
+                const int count, const int operand, const int t,
+                const bool aa)
+  {
+    if (level == BlendSimd::AVX2)
+      return spanAvx2<op>(p, s, count, operand, t, aa);
+    else
+      return spanSse2<op>(p, s, count, operand, t, aa);
+  }
+#endif
+}
+
+// detects the best supported instruction set
+void BlendSimd::init()
+{
+#ifdef BLEND_SIMD_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    cpu_level = AVX2;
+  else if (__builtin_cpu_supports("sse2"))
+    cpu_level = SSE2;
+  else
+    cpu_level = NONE;
+#endif
+
+  simd_level = cpu_level;
+}
+
+int BlendSimd::level()
+{
+  return simd_level;
+}
+
+// limits the instruction set used (for testing), cannot exceed the CPU's
+void BlendSimd::force(const int level)
+{
+  simd_level = level < cpu_level ? level : cpu_level;
+}
+
+// blends as many leading pixels of a span as possible, see Blend::span()
+// returns the number of pixels done, the caller finishes the rest
+int BlendSimd::span(const int mode, int *p, const unsigned char *s,
+                    const int count, const int c, const int t,
+                    const bool antialiased)
+{
+#ifdef BLEND_SIMD_X86
+  if (simd_level == NONE || t < 0 || t > 255)
+    return 0;
+
+  switch (mode)
+  {
+    case Blend::TRANS:
+      return spanLevel<OP_TRANS>(simd_level, p, s, count, c, t, antialiased);
+    case Blend::TRANS_ALPHA:
+      return spanLevel<OP_TRANS_ALPHA>(simd_level, p, s, count,
+                                       c, t, antialiased);
+    case Blend::TRANS_NO_ALPHA:
+      return spanLevel<OP_TRANS_NO_ALPHA>(simd_level, p, s, count,
+                                          c, t, antialiased);
+    case Blend::LIGHTEN:
+      return spanLevel<OP_LIGHTEN>(simd_level, p, s, count,
+                                   c, t, antialiased);
+    case Blend::DARKEN:
+    {
+      // same for every pixel, so do the hue rotation once
+      const rgba_type rgba = getRgba(c);
+      int r, g, b, h, sat, v;
+
+      Blend::rgbToHsv(rgba.r, rgba.g, rgba.b, &h, &sat, &v);
+      h += 768;
+
+      if (h >= 1536)
+        h -= 1536;
+
+      Blend::hsvToRgb(h, sat, v, &r, &g, &b);
+
+      return spanLevel<OP_DARKEN>(simd_level, p, s, count,
+                                  makeRgba(r, g, b, rgba.a), t, antialiased);
+    }
+    default:
+      return 0;
+  }
+#else
+  (void)mode;
+  (void)p;
+  (void)s;
+  (void)count;
+  (void)c;
+  (void)t;
+  (void)antialiased;
+
+  return 0;
+#endif
+}
+
@@ -18,6 +18,8 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <algorithm>
+
 #include "Brush.H"
 #include "Inline.H"
 #include "Map.H"
@@ -28,8 +30,12 @@ Brush::Brush()
   solidy = new int[max * max];
   hollowx = new int[max * max];
   hollowy = new int[max * max];
+  spanx1 = new int[max];
+  spanx2 = new int[max];
   solid_count = 0;
   hollow_count = 0;
+  span_y = 0;
+  span_count = 0;
   size = 1;
   shape = 0;
   coarse_edge = 0;
@@ -55,6 +61,8 @@ Brush::~Brush()
   delete[] solidy;
   delete[] hollowx;
   delete[] hollowy;
+  delete[] spanx1;
+  delete[] spanx2;
 }
 
 void Brush::make(int s, float round)
@@ -71,6 +79,8 @@ void Brush::make(int s, float round)
 
   solid_count = 0;
   hollow_count = 0;
+  span_y = 0;
+  span_count = 0;
 
   Map map(max, max);
   Map map2(max, max);
@@ -117,6 +127,32 @@ void Brush::make(int s, float round)
     }
   }
 
+  // spans (the shapes are convex, so each row is a single span)
+  for (int y = 0; y < max; y++)
+  {
+    int sx1 = max;
+    int sx2 = -1;
+
+    for (int x = 0; x < max; x++)
+    {
+      if (map.getpixel(x, y))
+      {
+        sx1 = std::min(sx1, x);
+        sx2 = std::max(sx2, x);
+      }
+    }
+
+    if (sx2 < 0)
+      continue;
+
+    if (span_count == 0)
+      span_y = y - max / 2;
+
+    spanx1[span_count] = sx1 - max / 2;
+    spanx2[span_count] = sx2 - max / 2;
+    span_count++;
+  }
+
   // hollow
   for (int y = 0; y < max; y++)
   {
@@ -18,17 +18,8 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
-#include <FL/Fl_Double_Window.H>
-
 #include "Bitmap.H"
-#include "Brush.H"
 #include "Clone.H"
-#include "Inline.H"
-#include "Map.H"
-#include "Project.H"
-#include "Stroke.H"
-#include "View.H"
-#include "Widget.H"
 
 int Clone::x = 0;
 int Clone::y = 0;
@@ -38,6 +29,7 @@ int Clone::state = 0;
 bool Clone::active = false;
 bool Clone::moved = false;
 Bitmap *Clone::buffer_bmp = 0;
+Stroke *Clone::stroke = 0;
 
 // change the clone target
 void Clone::move(int xx, int yy)
@@ -51,13 +43,13 @@ void Clone::move(int xx, int yy)
 }
 
 // set clone buffer bitmap to the correct size
-void Clone::refresh(int x1, int y1, int x2, int y2)
+void Clone::refresh(Bitmap *bmp, int x1, int y1, int x2, int y2)
 {
   const int w = x2 - x1;
   const int h = y2 - y1;
 
   delete buffer_bmp;
   buffer_bmp = new Bitmap(w, h);
-  Project::bmp->blit(buffer_bmp, x1, y1, 0, 0, w, h);
+  bmp->blit(buffer_bmp, x1, y1, 0, 0, w, h);
 }
 
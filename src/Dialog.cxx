@@ -41,6 +41,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "ColorOptions.H"
 #include "Dialog.H"
 #include "DialogWindow.H"
+#include "Editor.H"
 #include "File.H"
 #include "Group.H"
 #include "Gui.H"
@@ -376,6 +377,7 @@ namespace MakePalette
   {
     DialogWindow *dialog;
     InputInt *colors;
+    CheckBox *sampled;
     Fl_Button *ok;
     Fl_Button *cancel;
   }
@@ -392,8 +394,9 @@ namespace MakePalette
 
     const int samples = 3000;
 
+    Editor::push();
     Quantize::pca(Project::bmp, Project::palette,
-                  Items::colors->value(), samples);
+                  Items::colors->value(), samples, Items::sampled->value());
     Gui::colors->paletteDraw();
     Project::palette->fillTable();
   }
@@ -413,6 +416,10 @@ namespace MakePalette
     Items::colors->center();
     y1 += 32 + 16;
 
+    Items::sampled = new CheckBox(Items::dialog, 0, y1, 16, 16, "Sample Large Images", 0);
+    Items::sampled->center();
+    y1 += 16 + 16;
+
     Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
     Items::ok->callback((Fl_Callback *)close);
     Items::cancel->callback((Fl_Callback *)quit);
@@ -589,6 +596,13 @@ void Dialog::makePalette()
 
 void Dialog::message(const char *title, const char *message)
 {
+  // print instead when running without a window (batch mode)
+  if (Message::Items::dialog == 0)
+  {
+    fprintf(stderr, "%s: %s\n", title, message);
+    return;
+  }
+
   Message::begin(title, message);
 }
 
@@ -19,12 +19,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include "AlphaClear.H"
+#include "Bitmap.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void AlphaClear::apply(Bitmap *bmp)
+void AlphaClear::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -32,17 +39,10 @@ void AlphaClear::apply(Bitmap *bmp)
     {
       *p++ |= 0xff000000;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void AlphaClear::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
@@ -19,12 +19,23 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include "AlphaColor.H"
-
-void AlphaColor::apply(Bitmap *bmp, int color)
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
+
+void AlphaColor::apply(const Bitmap &src, Bitmap &dest,
+                       const params_type &params)
 {
+  Bitmap *bmp = &dest;
+  int color = params.color;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -37,17 +48,10 @@ void AlphaColor::apply(Bitmap *bmp, int color)
       *p |= c;
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void AlphaColor::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp, Project::brush->color);
-}
-
@@ -0,0 +1,32 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "AlphaColor.H"
+#include "AlphaColorDialog.H"
+
+void AlphaColorDialog::begin()
+{
+  Project::undo->push();
+  AlphaColor::params_type params;
+
+  params.color = Project::brush->color;
+  AlphaColor::apply(*Project::bmp, *Project::bmp, params);
+}
@@ -19,12 +19,20 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include "AlphaInvert.H"
+#include "Bitmap.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void AlphaInvert::apply(Bitmap *bmp)
+void AlphaInvert::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -34,17 +42,10 @@ void AlphaInvert::apply(Bitmap *bmp)
       *p = makeRgba(rgba.r, rgba.g, rgba.b, 255 - rgba.a);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void AlphaInvert::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
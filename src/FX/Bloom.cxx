@@ -18,23 +18,25 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <cmath>
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
 #include "Bloom.H"
+#include "Gamma.H"
+#include "Inline.H"
+#include "Progress.H"
 
-namespace
+void Bloom::apply(const Bitmap &src, Bitmap &dest, const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *radius;
-    InputInt *blend;
-    InputInt *threshold;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  int radius = params.radius;
+  int threshold = params.threshold;
+  int blend = params.blend;
+
+  bmp->copy(&src);
 
-void Bloom::apply(Bitmap *bmp, int radius, int threshold, int blend)
-{
   radius = (radius + 1) * 2;
 
   std::vector<int> kernel(radius);
@@ -135,56 +137,3 @@ void Bloom::apply(Bitmap *bmp, int radius, int threshold, int blend)
 
   Progress::hide();
 }
-
-void Bloom::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  const int radius = Items::radius->value();
-  const int threshold = Items::threshold->value();
-  const int blend = 255 - Items::blend->value() * 2.55;
-
-  apply(Project::bmp, radius, threshold, blend);
-}
-
-void Bloom::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void Bloom::begin()
-{
-  Items::dialog->show();
-}
-
-void Bloom::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Bloom");
-
-  Items::radius = new InputInt(Items::dialog, 0, y1, 128, 32, "Radius (0-100)", 0, 1, 100);
-  Items::radius->value(16);
-  Items::radius->center();
-  y1 += 32 + 16;
-
-  Items::threshold = new InputInt(Items::dialog, 0, y1, 128, 32, "Threshold (0-255)", 0, 0, 255);
-  Items::threshold->value(128);
-  Items::threshold->center();
-  y1 += 32 + 16;
-
-  Items::blend = new InputInt(Items::dialog, 0, y1, 128, 32, "Blend %", 0, 0, 100);
-  Items::blend->value(25);
-  Items::blend->center();
-  y1 += 32 + 16;
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
@@ -18,7 +18,13 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
 #include "BoxFilters.H"
+#include "FilterMatrix.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
 
 enum
 {
@@ -32,15 +38,6 @@ enum
 
 namespace
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    Fl_Choice *mode;
-    InputInt *amount;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-
   void copyMatrix(const int src[3][3], int dest[3][3])
   {
     for (int j = 0; j < 3; j++) 
@@ -53,8 +50,15 @@ namespace
   }
 }
 
-void BoxFilters::apply(Bitmap *bmp, int amount, int mode)
+void BoxFilters::apply(const Bitmap &src, Bitmap &dest,
+                       const params_type &params)
 {
+  Bitmap *bmp = &dest;
+  int amount = params.amount;
+  int mode = params.mode;
+
+  bmp->copy(&src);
+
   int div = 1;
   int matrix[3][3];
 
@@ -89,9 +93,9 @@ void BoxFilters::apply(Bitmap *bmp, int amount, int mode)
   Bitmap temp(bmp->cw, bmp->ch);
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
-    int *p = temp.row[y - bmp->cl];
+    int *p = temp.row[y - bmp->ct];
 
     for (int x = bmp->cl; x <= bmp->cr; x++)
     {
@@ -124,70 +128,13 @@ void BoxFilters::apply(Bitmap *bmp, int amount, int mode)
       *p = Blend::trans(c, makeRgba(r, g, b, geta(c)), 255 - amount * 2.55);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   temp.blit(bmp, 0, 0, bmp->cl, bmp->ct, temp.w, temp.h);
 
   Progress::hide();
 
 }
-
-void BoxFilters::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  const int amount = Items::amount->value();
-  const int mode = Items::mode->value();
-
-  apply(Project::bmp, amount, mode);
-}
-
-void BoxFilters::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void BoxFilters::begin()
-{
-  Items::dialog->show();
-}
-
-void BoxFilters::init()
-{
-  int y1 = 16;
-  int ww = 0;
-  int hh = 0;
-
-  Items::dialog = new DialogWindow(400, 0, "Box Filters");
-
-  Items::mode = new Fl_Choice(0, y1, 128, 32, "Filter:");
-  Items::mode->textsize(16);
-  Items::mode->labelsize(16);
-  Items::mode->add("Box Blur");
-  Items::mode->add("Gaussian Blur");
-  Items::mode->add("Sharpen");
-  Items::mode->add("Edge Detect");
-  Items::mode->add("Emboss");
-  Items::mode->add("Emboss (Inverse)");
-  Items::mode->value(0);
-  Items::mode->measure_label(ww, hh);
-  Items::mode->resize(Items::dialog->x() + Items::dialog->w() / 2 - (Items::mode->w() + ww) / 2 + ww, Items::mode->y(), Items::mode->w(), Items::mode->h());
-  y1 += 32 + 16;
-
-  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount %", 0, 0, 100);
-  Items::amount->value(50);
-  Items::amount->center();
-  y1 += 32 + 16;
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "BoxFilters.H"
+#include "BoxFiltersDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    Fl_Choice *mode;
+    InputInt *amount;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void BoxFiltersDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  BoxFilters::params_type params;
+
+  params.amount = Items::amount->value();
+  params.mode = Items::mode->value();
+
+  BoxFilters::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void BoxFiltersDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void BoxFiltersDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void BoxFiltersDialog::init()
+{
+  int y1 = 16;
+  int ww = 0;
+  int hh = 0;
+
+  Items::dialog = new DialogWindow(400, 0, "Box Filters");
+
+  Items::mode = new Fl_Choice(0, y1, 128, 32, "Filter:");
+  Items::mode->textsize(16);
+  Items::mode->labelsize(16);
+  Items::mode->add("Box Blur");
+  Items::mode->add("Gaussian Blur");
+  Items::mode->add("Sharpen");
+  Items::mode->add("Edge Detect");
+  Items::mode->add("Emboss");
+  Items::mode->add("Emboss (Inverse)");
+  Items::mode->value(0);
+  Items::mode->measure_label(ww, hh);
+  Items::mode->resize(Items::dialog->x() + Items::dialog->w() / 2 - (Items::mode->w() + ww) / 2 + ww, Items::mode->y(), Items::mode->w(), Items::mode->h());
+  y1 += 32 + 16;
+
+  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount %", 0, 0, 100);
+  Items::amount->value(50);
+  Items::amount->center();
+  y1 += 32 + 16;
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
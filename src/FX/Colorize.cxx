@@ -18,15 +18,26 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
 #include "Colorize.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void Colorize::apply(Bitmap *bmp, int color)
+void Colorize::apply(const Bitmap &src, Bitmap &dest,
+                     const params_type &params)
 {
+  Bitmap *bmp = &dest;
+  int color = params.color;
+
+  bmp->copy(&src);
+
   rgba_type rgba_color = getRgba(color);
 
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -55,17 +66,10 @@ void Colorize::apply(Bitmap *bmp, int color)
       *p = Blend::colorize(*p, makeRgba(r, g, b, rgba.a), 0);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Colorize::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp, Project::brush->color);
-}
-
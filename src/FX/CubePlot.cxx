@@ -18,35 +18,30 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <cmath>
+#include <vector>
+
+#include "Bitmap.H"
 #include "CubePlot.H"
+#include "Inline.H"
+#include "Palette.H"
+#include "Progress.H"
 
-namespace
+// plots the colors of src (or the palette) onto a 512x512 dest
+void CubePlot::apply(const Bitmap &src, Bitmap &dest,
+                     const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    CheckBox *pal_colors;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Palette *pal = params.palette;
+  const bool use_palette = params.use_palette;
 
-void CubePlot::apply(const bool use_palette)
-{
-  Palette *pal = Project::palette;
-  Bitmap *src = Project::bmp;
-  Project::newImage(512, 512);
-  Bitmap *dest = Project::bmp;
-  Gui::images->addFile("cube_plot");
-  Project::undo->reset();
   Progress::show(256);
   std::vector<char> histogram(16777216, 0);
 
-  for (int j = src->ct; j <= src->cb; j++)
+  for (int j = src.ct; j <= src.cb; j++)
   {
-    for (int i = src->cl; i <= src->cr; i++)
+    for (int i = src.cl; i <= src.cr; i++)
     {
-      rgba_type rgba = getRgba(src->getpixel(i, j));
+      rgba_type rgba = getRgba(src.getpixel(i, j));
       histogram[makeRgb24(rgba.r, rgba.g, rgba.b)] = 1;
     }
   }
@@ -67,13 +62,13 @@ void CubePlot::apply(const bool use_palette)
 
         if (tr + tg + tb == 2)
         {
-          dest->setpixel(256 + x, 256 + y, c1, 128);
+          dest.setpixel(256 + x, 256 + y, c1, 128);
         }
 
         if (((r & 15) == 0) && ((g & 15) == 0) && ((b & 15) == 0))
         {
-          dest->setpixel(256 + x, 256 + y, c1, 208);
-          dest->rect(256 + x - 1, 256 + y - 1,
+          dest.setpixel(256 + x, 256 + y, c1, 208);
+          dest.rect(256 + x - 1, 256 + y - 1,
                      256 + x + 1, 256 + y + 1, c1, 240);
         }
 
@@ -84,15 +79,15 @@ void CubePlot::apply(const bool use_palette)
 
           if (d < 8)
           {
-            dest->setpixel(256 + x, 256 + y, c2, 96);
+            dest.setpixel(256 + x, 256 + y, c2, 96);
           }
         }
           else
         {
           if (histogram[c1 & 0xffffff] > 0)
           {
-            dest->setpixel(256 + x, 256 + y, c1, 96);
-            dest->rect(256 + x - 1, 256 + y - 1,
+            dest.setpixel(256 + x, 256 + y, c1, 96);
+            dest.rect(256 + x - 1, 256 + y - 1,
                        256 + x + 1, 256 + y + 1, c1, 240);
           }
         }
@@ -104,44 +99,3 @@ void CubePlot::apply(const bool use_palette)
 
   Progress::hide();
 }
-
-void CubePlot::close()
-{
-  Items::dialog->hide();
-
-  if (Items::pal_colors->value())
-    apply(true);
-  else
-    apply(false);
-}
-
-void CubePlot::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void CubePlot::begin()
-{
-  Items::dialog->show();
-}
-
-void CubePlot::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Cube Plot");
-
-  Items::pal_colors = new CheckBox(Items::dialog, 0, y1, 16, 16,
-                                   "Palette Colors", 0);
-  y1 += 16 + 16;
-  Items::pal_colors->center();
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "CubePlot.H"
+#include "CubePlotDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    CheckBox *pal_colors;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void CubePlotDialog::close()
+{
+  Items::dialog->hide();
+
+  Bitmap *src = Project::bmp;
+
+  if (Project::newImage(512, 512) < 0)
+    return;
+
+  Gui::images->addFile("cube_plot");
+  Project::undo->reset();
+
+  CubePlot::params_type params;
+
+  params.palette = Project::palette;
+  params.use_palette = Items::pal_colors->value();
+  CubePlot::apply(*src, *Project::bmp, params);
+}
+
+void CubePlotDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void CubePlotDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void CubePlotDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Cube Plot");
+
+  Items::pal_colors = new CheckBox(Items::dialog, 0, y1, 16, 16,
+                                   "Palette Colors", 0);
+  y1 += 16 + 16;
+  Items::pal_colors->center();
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
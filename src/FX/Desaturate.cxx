@@ -18,13 +18,21 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
 #include "Desaturate.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void Desaturate::apply(Bitmap *bmp)
+void Desaturate::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -35,17 +43,10 @@ void Desaturate::apply(Bitmap *bmp)
       *p = makeRgba(l, l, l, geta(*p));
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Desaturate::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
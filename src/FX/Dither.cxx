@@ -18,34 +18,18 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <algorithm>
+#include <vector>
+
+#include "Bitmap.H"
 #include "Dither.H"
+#include "Gamma.H"
+#include "Inline.H"
+#include "Palette.H"
+#include "Progress.H"
 
-enum
-{
-  THRESHOLD,
-  FLOYD,
-  ATKINSON
-};
- 
-enum
-{
-  MODE_PALETTE,
-  MODE_BW
-};
- 
 namespace
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    Fl_Choice *dither_mode;
-    InputFloat *bias;
-    Fl_Choice *color_mode;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-    Fl_Button *reset;
-  }
-
   int range(const int value, const int floor, const int ceiling)
   {
     if(value < floor)
@@ -56,16 +40,15 @@ namespace
       return value;
   }
 
-  int match(const int color_mode, const int c)
+  int match(Palette *pal, const int color_mode, const int c)
   {
     const int l = getl(c);
-    Palette *pal = Project::palette;
 
     switch (color_mode)
     {
-      case MODE_PALETTE:
+      case Dither::MODE_PALETTE:
         return pal->data[pal->lookup(c)];
-      case MODE_BW:
+      case Dither::MODE_BW:
         if (l < 128)
           return makeRgb(0, 0, 0);
         else
@@ -74,13 +57,6 @@ namespace
         return makeRgb(0, 0, 0);
     }
   }
-
-  void cb_reset()
-  {
-    Items::dither_mode->value(0);
-    Items::bias->value(0);
-    Items::color_mode->value(0);
-  }
 }
 
 namespace Floyd
@@ -107,9 +83,16 @@ namespace Atkinson
   int div = 8;
 }
 
-void Dither::apply(Bitmap *bmp, const int dither_mode,
-                   const int color_mode, const double bias)
+void Dither::apply(const Bitmap &src, Bitmap &dest, const params_type &params)
 {
+  Bitmap *bmp = &dest;
+  Palette *pal = params.palette;
+  const int dither_mode = params.dither_mode;
+  const int color_mode = params.color_mode;
+  const double bias = params.bias;
+
+  bmp->copy(&src);
+
   if (dither_mode == THRESHOLD)
   {
     Progress::show(bmp->h);
@@ -123,7 +106,7 @@ void Dither::apply(Bitmap *bmp, const int dither_mode,
         const int c = *p++;
 
         bmp->setpixel(x, y,
-                     (c & 0xff000000) | (match(color_mode, c) & 0xffffff));
+                     (c & 0xff000000) | (match(pal, color_mode, c) & 0xffffff));
       }
 
       if (Progress::update(y) < 0)
@@ -182,7 +165,7 @@ void Dither::apply(Bitmap *bmp, const int dither_mode,
                              Gamma::unfix(old_g),
                              Gamma::unfix(old_b));
 
-      const int pal_color = match(color_mode, c2);
+      const int pal_color = match(pal, color_mode, c2);
 
       const rgba_type pal_rgba = getRgba(pal_color);
       bmp->setpixel(x, y, makeRgba(pal_rgba.r, pal_rgba.g, pal_rgba.b, alpha));
@@ -259,81 +242,3 @@ void Dither::apply(Bitmap *bmp, const int dither_mode,
 
   Progress::hide();
 }
-
-void Dither::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  const int dither_mode = Items::dither_mode->value();
-  const int color_mode = Items::color_mode->value();
-  const double div = Items::bias->value();
-
-  apply(Project::bmp, dither_mode, color_mode, div);
-}
-
-void Dither::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void Dither::begin()
-{
-  Items::dialog->show();
-}
-
-void Dither::init()
-{
-  int y1 = 16;
-  int ww = 0;
-  int hh = 0;
-
-  Items::dialog = new DialogWindow(400, 0, "Apply Colors");
-
-  Items::dither_mode = new Fl_Choice(0, y1, 192, 32, "Dither Mode:");
-  Items::dither_mode->textsize(16);
-  Items::dither_mode->labelsize(16);
-  Items::dither_mode->add("No Dithering");
-  Items::dither_mode->add("Floyd-Steinberg");
-  Items::dither_mode->add("Atkinson");
-  Items::dither_mode->value(0);
-  Items::dither_mode->measure_label(ww, hh);
-  Items::dither_mode->resize(Items::dialog->x() + Items::dialog->w() / 2
-                             - (Items::dither_mode->w() + ww) / 2 + ww,
-                             Items::dither_mode->y(),
-                             Items::dither_mode->w(), Items::dither_mode->h());
-  y1 += 32 + 16;
-
-  Items::bias = new InputFloat(Items::dialog, 0, y1, 128, 32,
-                                "Bias (-2 to 2)", 0, -2, 2);
-  Items::bias->value(0);
-  Items::bias->center();
-
-  y1 += 32 + 16;
-
-  Items::color_mode = new Fl_Choice(0, y1, 192, 32, "Color Mode:");
-  Items::color_mode->textsize(16);
-  Items::color_mode->labelsize(16);
-  Items::color_mode->add("Use Palette");
-  Items::color_mode->add("Black && White");
-  Items::color_mode->value(0);
-  Items::color_mode->measure_label(ww, hh);
-  Items::color_mode->resize(Items::dialog->x() + Items::dialog->w() / 2
-                            - (Items::color_mode->w() + ww) / 2 + ww,
-                            Items::color_mode->y(),
-                            Items::color_mode->w(), Items::color_mode->h());
-  y1 += 32 + 16;
-
-  Items::reset = new Fl_Button(8, y1 + 12, 96, 40, "Reset");
-  Items::reset->labelsize(18);
-  Items::reset->callback((Fl_Callback *)cb_reset);
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
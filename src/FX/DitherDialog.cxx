@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "Dither.H"
+#include "DitherDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    Fl_Choice *dither_mode;
+    InputFloat *bias;
+    Fl_Choice *color_mode;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+    Fl_Button *reset;
+  }
+
+  void cb_reset()
+  {
+    Items::dither_mode->value(0);
+    Items::bias->value(0);
+    Items::color_mode->value(0);
+  }
+}
+
+void DitherDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  Dither::params_type params;
+
+  params.palette = Project::palette;
+  params.dither_mode = Items::dither_mode->value();
+  params.color_mode = Items::color_mode->value();
+  params.bias = Items::bias->value();
+
+  Dither::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void DitherDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void DitherDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void DitherDialog::init()
+{
+  int y1 = 16;
+  int ww = 0;
+  int hh = 0;
+
+  Items::dialog = new DialogWindow(400, 0, "Apply Colors");
+
+  Items::dither_mode = new Fl_Choice(0, y1, 192, 32, "Dither Mode:");
+  Items::dither_mode->textsize(16);
+  Items::dither_mode->labelsize(16);
+  Items::dither_mode->add("No Dithering");
+  Items::dither_mode->add("Floyd-Steinberg");
+  Items::dither_mode->add("Atkinson");
+  Items::dither_mode->value(0);
+  Items::dither_mode->measure_label(ww, hh);
+  Items::dither_mode->resize(Items::dialog->x() + Items::dialog->w() / 2
+                             - (Items::dither_mode->w() + ww) / 2 + ww,
+                             Items::dither_mode->y(),
+                             Items::dither_mode->w(), Items::dither_mode->h());
+  y1 += 32 + 16;
+
+  Items::bias = new InputFloat(Items::dialog, 0, y1, 128, 32,
+                                "Bias (-2 to 2)", 0, -2, 2);
+  Items::bias->value(0);
+  Items::bias->center();
+
+  y1 += 32 + 16;
+
+  Items::color_mode = new Fl_Choice(0, y1, 192, 32, "Color Mode:");
+  Items::color_mode->textsize(16);
+  Items::color_mode->labelsize(16);
+  Items::color_mode->add("Use Palette");
+  Items::color_mode->add("Black && White");
+  Items::color_mode->value(0);
+  Items::color_mode->measure_label(ww, hh);
+  Items::color_mode->resize(Items::dialog->x() + Items::dialog->w() / 2
+                            - (Items::color_mode->w() + ww) / 2 + ww,
+                            Items::color_mode->y(),
+                            Items::color_mode->w(), Items::color_mode->h());
+  y1 += 32 + 16;
+
+  Items::reset = new Fl_Button(8, y1 + 12, 96, 40, "Reset");
+  Items::reset->labelsize(18);
+  Items::reset->callback((Fl_Callback *)cb_reset);
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
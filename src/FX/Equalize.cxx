@@ -18,10 +18,20 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <vector>
+
+#include "Bitmap.H"
 #include "Equalize.H"
+#include "Inline.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void Equalize::apply(Bitmap *bmp)
+void Equalize::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   std::vector<int> list_r(256, 0);
   std::vector<int> list_g(256, 0);
   std::vector<int> list_b(256, 0);
@@ -61,7 +71,7 @@ void Equalize::apply(Bitmap *bmp)
 
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -80,17 +90,10 @@ void Equalize::apply(Bitmap *bmp)
       *p = makeRgba(r, g, b, rgba.a);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Equalize::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
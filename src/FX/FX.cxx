@@ -23,9 +23,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 
 #include "FX.H"
 
-// most filters may be used internally by calling Gui::progressEnable(false)
-// first to disable the progress bar, then calling apply() with the target
-// bitmap and other parameters
+// each filter's apply() is in its own file, which doesn't use fltk, so
+// filters can be built and used without the gui by including their header
+// and calling apply(src, dest, params) with the filter's params_type. dest
+// is made a copy of src first, passing the same bitmap for both works in
+// place. the dialogs are the *Dialog classes in the matching *Dialog files.
+// the progress bar only shows once the gui has set its callbacks,
+// Progress::enable(false) turns it off while the gui is running
 
 void FX::drawPreview(Bitmap *src, Bitmap *dest)
 {
@@ -58,19 +62,19 @@ void FX::drawPreview(Bitmap *src, Bitmap *dest)
 void FX::init()
 {
   // call init functions for filters with dialogs
-  RotateHue::init();
-  GaussianBlur::init();
-  Sharpen::init();
-  UnsharpMask::init();
-  BoxFilters::init();
-  Sobel::init();
-  Bloom::init();
-  Restore::init();
-  RemoveDust::init();
-  StainedGlass::init();
-  Painting::init();
-  Marble::init();
-  Dither::init();
-  CubePlot::init();
+  RotateHueDialog::init();
+  GaussianBlurDialog::init();
+  SharpenDialog::init();
+  UnsharpMaskDialog::init();
+  BoxFiltersDialog::init();
+  SobelDialog::init();
+  BloomDialog::init();
+  RestoreDialog::init();
+  RemoveDustDialog::init();
+  StainedGlassDialog::init();
+  PaintingDialog::init();
+  MarbleDialog::init();
+  DitherDialog::init();
+  CubePlotDialog::init();
 }
 
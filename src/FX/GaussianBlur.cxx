@@ -26,7 +26,14 @@ My implementation only works for sizes >= 3, so a box filter is used
 for 1 & 2 instead.
 */
 
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Gamma.H"
 #include "GaussianBlur.H"
+#include "Inline.H"
+#include "Progress.H"
 
 namespace
 {
@@ -70,31 +77,26 @@ namespace
   }
 }
 
-namespace
+void GaussianBlur::apply(const Bitmap &src, Bitmap &dest,
+                         const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *size;
-    InputInt *blend;
-    Fl_Choice *mode;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  float size = params.size;
+  int blend = params.blend;
+  int mode = params.mode;
+
+  bmp->copy(&src);
 
-void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
-{
   const int border = 128;
   const int matrix[9] = { 0, 1, 0, 1, 2, 1, 0, 1, 0 };
 
   // make copy, extend borders
-  Bitmap src(bmp->w + border * 2, bmp->h + border * 2);
-  bmp->blit(&src, 0, 0, border, border, bmp->w, bmp->h);
-  extendBorders(&src, border);
+  Bitmap padded(bmp->w + border * 2, bmp->h + border * 2);
+  bmp->blit(&padded, 0, 0, border, border, bmp->w, bmp->h);
+  extendBorders(&padded, border);
 
-  Bitmap temp(src.w, src.h);
-  src.blit(&temp, 0, 0, 0, 0, src.w, src.h);
+  Bitmap temp(padded.w, padded.h);
+  padded.blit(&temp, 0, 0, 0, 0, padded.w, padded.h);
 
   // use alternative blur for sizes 1 & 2
   if (size < 3)
@@ -132,7 +134,7 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
           g = Gamma::unfix(g);
           b = Gamma::unfix(b);
 
-          const int c1 = src.getpixel(x + border, y + border);
+          const int c1 = padded.getpixel(x + border, y + border);
           const int c2 = makeRgba(r, g, b, a);
 
           switch (mode)
@@ -176,7 +178,7 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
   if (((int)size & 1) == 0)
     size += 1;
 
-  int larger = src.w > src.h ? src.w : src.h;
+  int larger = padded.w > padded.h ? padded.w : padded.h;
 
   std::vector<int> buf_r(larger, 0);
   std::vector<int> buf_g(larger, 0);
@@ -193,11 +195,11 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
     if (Progress::update(pass_count++))
       break;
 
-    for (int y = src.ct; y <= src.cb; y++)
+    for (int y = padded.ct; y <= padded.cb; y++)
     {
-      for (int x = 0; x < src.w; x++)
+      for (int x = 0; x < padded.w; x++)
       {
-        rgba_type rgba = getRgba(src.getpixel(x, y));
+        rgba_type rgba = getRgba(padded.getpixel(x, y));
         buf_r[x] = Gamma::fix(rgba.r);
         buf_g[x] = Gamma::fix(rgba.g);
         buf_b[x] = Gamma::fix(rgba.b);
@@ -210,7 +212,7 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
       int accum_a = 0;
       int div = 1;
 
-      for (int x = src.cl; x <= src.cr; x++)
+      for (int x = padded.cl; x <= padded.cr; x++)
       {
         const int mx = x - div;
 
@@ -245,9 +247,9 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
     if (Progress::update(pass_count++))
       break;
 
-    for (int x = src.cl; x <= src.cr; x++)
+    for (int x = padded.cl; x <= padded.cr; x++)
     {
-      for (int y = 0; y < src.h; y++)
+      for (int y = 0; y < padded.h; y++)
       {
         rgba_type rgba = getRgba(temp.getpixel(x, y));
         buf_r[y] = Gamma::fix(rgba.r);
@@ -262,7 +264,7 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
       int accum_a = 0;
       int div = 1;
 
-      for (int y = src.ct; y <= src.cb; y++)
+      for (int y = padded.ct; y <= padded.cb; y++)
       {
         const int my = y - div;
 
@@ -284,7 +286,7 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
         if (div > size)
           div = size;
 
-        int c1 = src.getpixel(x, y);
+        int c1 = padded.getpixel(x, y);
 
         const int c2 = makeRgba(Gamma::unfix(accum_r / div),
                                 Gamma::unfix(accum_g / div),
@@ -294,84 +296,20 @@ void GaussianBlur::apply(Bitmap *bmp, float size, int blend, int mode)
         switch (mode)
         {
           case 0:
-            src.setpixel(x, y, Blend::trans(c1, c2, blend));
+            padded.setpixel(x, y, Blend::trans(c1, c2, blend));
             break;
           case 1:
-            src.setpixel(x, y,
+            padded.setpixel(x, y,
               Blend::trans(c1, Blend::keepLum(c2, getl(c1)), blend));
             break;
           case 2:
-            src.setpixel(x, y, Blend::transAlpha(c1, c2, blend));
+            padded.setpixel(x, y, Blend::transAlpha(c1, c2, blend));
             break;
         }
       }
     }
   }
 
-  src.blit(bmp, border, border, 0, 0, bmp->w, bmp->h);
+  padded.blit(bmp, border, border, 0, 0, bmp->w, bmp->h);
   Progress::hide();
 }
-
-void GaussianBlur::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  int size = Items::size->value();
-  int blend = 255 - Items::blend->value() * 2.55;
-  int mode = Items::mode->value();
-
-  apply(Project::bmp, size, blend, mode);
-}
-
-void GaussianBlur::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void GaussianBlur::begin()
-{
-  Items::dialog->show();
-}
-
-void GaussianBlur::init()
-{
-  int y1 = 16;
-  int ww = 0;
-  int hh = 0;
-
-  Items::dialog = new DialogWindow(400, 0, "Gaussian Blur");
-
-  Items::size = new InputInt(Items::dialog, 0, y1, 128, 32, "Size (1-60)", 0, 1, 60);
-  y1 += 32 + 16;
-  Items::size->value(1);
-  Items::size->center();
-
-  Items::blend = new InputInt(Items::dialog, 0, y1, 128, 32, "Blend %", 0, 0, 100);
-  Items::blend->value(100);
-  Items::blend->center();
-  y1 += 32 + 16;
-
-  Items::mode = new Fl_Choice(0, y1, 128, 32, "Mode:");
-  Items::mode->labelsize(16);
-  Items::mode->textsize(16);
-  Items::mode->add("Normal");
-  Items::mode->add("Color Only");
-  Items::mode->add("Alpha Only");
-  Items::mode->value(0);
-  Items::mode->align(FL_ALIGN_LEFT);
-  Items::mode->measure_label(ww, hh);
-  Items::mode->resize(Items::dialog->x() + Items::dialog->w() / 2
-                      - (Items::mode->w() + ww) / 2 + ww,
-                      Items::mode->y(), Items::mode->w(), Items::mode->h());
-  y1 += 32 + 16;
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
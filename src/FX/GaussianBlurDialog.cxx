@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "GaussianBlur.H"
+#include "GaussianBlurDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    InputInt *size;
+    InputInt *blend;
+    Fl_Choice *mode;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void GaussianBlurDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  GaussianBlur::params_type params;
+
+  params.size = Items::size->value();
+  params.blend = 255 - Items::blend->value() * 2.55;
+  params.mode = Items::mode->value();
+
+  GaussianBlur::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void GaussianBlurDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void GaussianBlurDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void GaussianBlurDialog::init()
+{
+  int y1 = 16;
+  int ww = 0;
+  int hh = 0;
+
+  Items::dialog = new DialogWindow(400, 0, "Gaussian Blur");
+
+  Items::size = new InputInt(Items::dialog, 0, y1, 128, 32, "Size (1-60)", 0, 1, 60);
+  y1 += 32 + 16;
+  Items::size->value(1);
+  Items::size->center();
+
+  Items::blend = new InputInt(Items::dialog, 0, y1, 128, 32, "Blend %", 0, 0, 100);
+  Items::blend->value(100);
+  Items::blend->center();
+  y1 += 32 + 16;
+
+  Items::mode = new Fl_Choice(0, y1, 128, 32, "Mode:");
+  Items::mode->labelsize(16);
+  Items::mode->textsize(16);
+  Items::mode->add("Normal");
+  Items::mode->add("Color Only");
+  Items::mode->add("Alpha Only");
+  Items::mode->value(0);
+  Items::mode->align(FL_ALIGN_LEFT);
+  Items::mode->measure_label(ww, hh);
+  Items::mode->resize(Items::dialog->x() + Items::dialog->w() / 2
+                      - (Items::mode->w() + ww) / 2 + ww,
+                      Items::mode->y(), Items::mode->w(), Items::mode->h());
+  y1 += 32 + 16;
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
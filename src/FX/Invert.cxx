@@ -18,13 +18,21 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
 #include "Invert.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void Invert::apply(Bitmap *bmp)
+void Invert::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -33,17 +41,10 @@ void Invert::apply(Bitmap *bmp)
       *p = Blend::invert(*p, 0, 0);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Invert::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
@@ -18,60 +18,37 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
-#include "Marble.H"
+#include "Bitmap.H"
+#include "Blend.H"
 #include "Fractal.H"
-#include "Gui.H"
-#include "Images.H"
 #include "Inline.H"
-#include "View.H"
-#include "Wheel.H"
+#include "Marble.H"
 
-namespace
+void Marble::apply(const Bitmap &src, Bitmap &dest, const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    Widget *preview;
-    Widget *marb;
-    Widget *turb;
-    Widget *blend;
-    Widget *threshold;
-    Fl_Choice *type;
-    Fl_Choice *mode;
-    Wheel *wheel;
-    Fl_Button *change;
-    Fl_Button *ok;
-    Fl_Button *cancel;
+  Bitmap *bmp = &dest;
 
-    Bitmap *temp;
-    int old_marb_var;
-    int old_turb_var;
-    int old_blend_var;
-    int old_threshold_var;
-  }
-}
+  bmp->copy(&src);
 
-void Marble::apply(Bitmap *dest)
-{
-  int w = dest->cw;
-  int h = dest->ch;
+  int w = bmp->cw;
+  int h = bmp->ch;
 
   Map plasma(w, h);
   Map marble(w, h);
   Map marbx(w, h);
   Map marby(w, h);
 
-  Fractal::plasma(&plasma, (Items::turb->var + 1) << 10);
-  Fractal::plasma(&marbx, (Items::turb->var + 1) << 10);
-  Fractal::plasma(&marby, (Items::turb->var + 1) << 10);
-  Fractal::marble(&plasma, &marble, &marbx, &marby, (Items::marb->var + 1) << 2, 50, Items::type->value());
+  Fractal::plasma(&plasma, (params.turbulence + 1) << 10);
+  Fractal::plasma(&marbx, (params.turbulence + 1) << 10);
+  Fractal::plasma(&marby, (params.turbulence + 1) << 10);
+  Fractal::marble(&plasma, &marble, &marbx, &marby, (params.marbleize + 1) << 2, 50, params.type);
 
-  int color = Items::wheel->getColor();
-  int trans = Items::blend->var * 13.43;
-  int threshold = Items::threshold->var * 13.43;
+  int color = params.color;
+  int trans = params.blend * 13.43;
+  int threshold = params.threshold * 13.43;
   int (*current_blend)(const int, const int, const int) = &Blend::trans;
 
-  switch (Items::mode->value())
+  switch (params.mode)
   {
     case 1:
       current_blend = &Blend::lighten;
@@ -86,7 +63,7 @@ void Marble::apply(Bitmap *dest)
   
   for (int y = 0; y < h; y++)
   {
-    int *p = dest->row[y + dest->ct] + dest->cl;
+    int *p = bmp->row[y + bmp->ct] + bmp->cl;
 
     for (int x = 0; x < w; x++)
     {
@@ -95,7 +72,7 @@ void Marble::apply(Bitmap *dest)
       if (mix < 0)
         mix = 0;
 
-      if (Items::type->value() == 1)
+      if (params.type == 1)
         *p = current_blend(*p, color, (scaleVal(trans, 255 - mix) & 63) * 4);
       else
         *p = current_blend(*p, color, scaleVal(trans, 255 - mix));
@@ -104,157 +81,3 @@ void Marble::apply(Bitmap *dest)
     }
   }
 }
-
-void Marble::close()
-{
-  Bitmap *bmp = Project::bmp;
-  Items::temp->blit(bmp, 0, 0, bmp->cl, bmp->ct, Items::temp->w, Items::temp->h);
-  Items::dialog->hide();
-  Gui::getView()->drawMain(true);
-  delete Items::temp;
-}
-
-void Marble::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-  delete Items::temp;
-}
-
-void Marble::begin()
-{
-  Items::wheel->update(Project::brush->color);
-  Bitmap *bmp = Project::bmp;
-  Project::undo->push();
-  Items::temp = new Bitmap(bmp->cw, bmp->ch);
-  bmp->blit(Items::temp, bmp->cl, bmp->ct, 0, 0, bmp->cw, bmp->ch);
-  apply(Items::temp);
-  FX::drawPreview(Items::temp, Items::preview->bitmap);
-  Items::preview->redraw();
-  Items::dialog->show();
-}
-
-void Marble::init()
-{
-  int y1 = 8;
-
-  Items::dialog = new DialogWindow(544, 8, "Marble");
-
-  Items::preview = new Widget(Items::dialog, 8, y1, 528, 528, 0, 1, 1, 0);
-  y1 += 528 + 24;
-
-  Items::marb = new Widget(Items::dialog, 8, y1, 160, 32, "Marbleize", images_marbleize_png, 16, 32, (Fl_Callback *)setMarb);
-  Items::marb->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::marb->labelfont(FL_COURIER);
-
-  Items::turb = new Widget(Items::dialog, 8 + 160 + 8, y1, 160, 32, "Turbulence", images_turbulence_png, 16, 32, (Fl_Callback *)setTurb);
-  Items::turb->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::turb->labelfont(FL_COURIER);
-  y1 += 64;
-
-  Items::blend = new Widget(Items::dialog, 8, y1, 160, 32, "Blend", images_marble_blend_png, 8, 32, (Fl_Callback *)setBlend);
-  Items::blend->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::blend->labelfont(FL_COURIER);
-
-  Items::threshold = new Widget(Items::dialog, 8 + 160 + 8, y1, 160, 32, "Threshold", images_marble_blend_png, 8, 32, (Fl_Callback *)setThreshold);
-  Items::threshold->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::threshold->labelfont(FL_COURIER);
-  y1 += 64;
-
-  Items::type = new Fl_Choice(8, y1, 160, 32, 0);
-  Items::type->labelsize(16);
-  Items::type->textsize(16);
-  Items::type->tooltip("Type");
-  Items::type->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::type->labelfont(FL_COURIER);
-  Items::type->add("Marble");
-  Items::type->add("Wood");
-  Items::type->add("Malachite");
-  Items::type->add("Corrosion");
-  Items::type->add("Metal");
-  Items::type->add("Weathered");
-  Items::type->add("Immiscible");
-  Items::type->value(0);
-  Items::type->callback((Fl_Callback *)update);
-
-  Items::mode = new Fl_Choice(8 + 160 + 8, y1, 160, 32, 0);
-  Items::mode->labelsize(16);
-  Items::mode->textsize(16);
-  Items::mode->tooltip("Blending Mode");
-  Items::mode->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::mode->labelfont(FL_COURIER);
-  Items::mode->add("Normal");
-  Items::mode->add("Lighten");
-  Items::mode->add("Darken");
-  Items::mode->value(0);
-  Items::mode->callback((Fl_Callback *)update);
-
-  Items::wheel = new Wheel(344, 544, 192, 192, ""); 
-  Items::wheel->callback((Fl_Callback *)update);
-  y1 = 8 + 528 + 8 + 192 + 8;
-
-
-  Items::change = new Fl_Button(8, y1 + 12, 160, 40, "Apply To Image");
-  Items::change->labelsize(16);
-  Items::change->tooltip("Apply Changes");
-  Items::change->callback((Fl_Callback *)updateMain);
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
-void Marble::update()
-{
-  Bitmap *bmp = Project::bmp;
-  bmp->blit(Items::temp, bmp->cl, bmp->ct, 0, 0, bmp->cw, bmp->ch);
-  apply(Items::temp);
-  FX::drawPreview(Items::temp, Items::preview->bitmap);
-  Items::preview->redraw();
-}
-
-void Marble::updateMain()
-{
-  Items::temp->blit(Project::bmp, 0, 0, 0, 0, Items::temp->w, Items::temp->h);
-  Gui::getView()->drawMain(true);
-}
-
-void Marble::setMarb()
-{
-  if (Items::marb->var == Items::old_marb_var)
-    return;
-
-  update();
-  Items::old_marb_var = Items::marb->var;
-}
-
-void Marble::setTurb()
-{
-  if (Items::turb->var == Items::old_turb_var)
-    return;
-
-  update();
-  Items::old_turb_var = Items::turb->var;
-}
-
-void Marble::setBlend()
-{
-  if (Items::blend->var == Items::old_blend_var)
-    return;
-
-  update();
-  Items::old_blend_var = Items::blend->var;
-}
-
-void Marble::setThreshold()
-{
-  if (Items::threshold->var == Items::old_threshold_var)
-    return;
-
-  update();
-  Items::old_threshold_var = Items::threshold->var;
-}
-
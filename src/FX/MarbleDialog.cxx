@@ -0,0 +1,225 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "Marble.H"
+#include "MarbleDialog.H"
+#include "Gui.H"
+#include "Images.H"
+#include "Inline.H"
+#include "View.H"
+#include "Wheel.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    Widget *preview;
+    Widget *marb;
+    Widget *turb;
+    Widget *blend;
+    Widget *threshold;
+    Fl_Choice *type;
+    Fl_Choice *mode;
+    Wheel *wheel;
+    Fl_Button *change;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+
+    Bitmap *temp;
+    int old_marb_var;
+    int old_turb_var;
+    int old_blend_var;
+    int old_threshold_var;
+  }
+
+  Marble::params_type getParams()
+  {
+    Marble::params_type params;
+
+    params.marbleize = Items::marb->var;
+    params.turbulence = Items::turb->var;
+    params.blend = Items::blend->var;
+    params.threshold = Items::threshold->var;
+    params.type = Items::type->value();
+    params.mode = Items::mode->value();
+    params.color = Items::wheel->getColor();
+
+    return params;
+  }
+}
+
+void MarbleDialog::close()
+{
+  Bitmap *bmp = Project::bmp;
+  Items::temp->blit(bmp, 0, 0, bmp->cl, bmp->ct, Items::temp->w, Items::temp->h);
+  Items::dialog->hide();
+  Gui::getView()->invalidate(bmp->cl, bmp->ct,
+                             bmp->cl + Items::temp->w - 1,
+                             bmp->ct + Items::temp->h - 1);
+  Gui::getView()->drawMain(true);
+  delete Items::temp;
+}
+
+void MarbleDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+  delete Items::temp;
+}
+
+void MarbleDialog::begin()
+{
+  Items::wheel->update(Project::brush->color);
+  Bitmap *bmp = Project::bmp;
+  Project::undo->push();
+  Items::temp = new Bitmap(bmp->cw, bmp->ch);
+  bmp->blit(Items::temp, bmp->cl, bmp->ct, 0, 0, bmp->cw, bmp->ch);
+  Marble::apply(*Items::temp, *Items::temp, getParams());
+  FX::drawPreview(Items::temp, Items::preview->bitmap);
+  Items::preview->redraw();
+  Items::dialog->show();
+}
+
+void MarbleDialog::init()
+{
+  int y1 = 8;
+
+  Items::dialog = new DialogWindow(544, 8, "Marble");
+
+  Items::preview = new Widget(Items::dialog, 8, y1, 528, 528, 0, 1, 1, 0);
+  y1 += 528 + 24;
+
+  Items::marb = new Widget(Items::dialog, 8, y1, 160, 32, "Marbleize", images_marbleize_png, 16, 32, (Fl_Callback *)setMarb);
+  Items::marb->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::marb->labelfont(FL_COURIER);
+
+  Items::turb = new Widget(Items::dialog, 8 + 160 + 8, y1, 160, 32, "Turbulence", images_turbulence_png, 16, 32, (Fl_Callback *)setTurb);
+  Items::turb->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::turb->labelfont(FL_COURIER);
+  y1 += 64;
+
+  Items::blend = new Widget(Items::dialog, 8, y1, 160, 32, "Blend", images_marble_blend_png, 8, 32, (Fl_Callback *)setBlend);
+  Items::blend->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::blend->labelfont(FL_COURIER);
+
+  Items::threshold = new Widget(Items::dialog, 8 + 160 + 8, y1, 160, 32, "Threshold", images_marble_blend_png, 8, 32, (Fl_Callback *)setThreshold);
+  Items::threshold->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::threshold->labelfont(FL_COURIER);
+  y1 += 64;
+
+  Items::type = new Fl_Choice(8, y1, 160, 32, 0);
+  Items::type->labelsize(16);
+  Items::type->textsize(16);
+  Items::type->tooltip("Type");
+  Items::type->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::type->labelfont(FL_COURIER);
+  Items::type->add("Marble");
+  Items::type->add("Wood");
+  Items::type->add("Malachite");
+  Items::type->add("Corrosion");
+  Items::type->add("Metal");
+  Items::type->add("Weathered");
+  Items::type->add("Immiscible");
+  Items::type->value(0);
+  Items::type->callback((Fl_Callback *)update);
+
+  Items::mode = new Fl_Choice(8 + 160 + 8, y1, 160, 32, 0);
+  Items::mode->labelsize(16);
+  Items::mode->textsize(16);
+  Items::mode->tooltip("Blending Mode");
+  Items::mode->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::mode->labelfont(FL_COURIER);
+  Items::mode->add("Normal");
+  Items::mode->add("Lighten");
+  Items::mode->add("Darken");
+  Items::mode->value(0);
+  Items::mode->callback((Fl_Callback *)update);
+
+  Items::wheel = new Wheel(344, 544, 192, 192, ""); 
+  Items::wheel->callback((Fl_Callback *)update);
+  y1 = 8 + 528 + 8 + 192 + 8;
+
+
+  Items::change = new Fl_Button(8, y1 + 12, 160, 40, "Apply To Image");
+  Items::change->labelsize(16);
+  Items::change->tooltip("Apply Changes");
+  Items::change->callback((Fl_Callback *)updateMain);
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
+
+void MarbleDialog::update()
+{
+  Bitmap *bmp = Project::bmp;
+  bmp->blit(Items::temp, bmp->cl, bmp->ct, 0, 0, bmp->cw, bmp->ch);
+  Marble::apply(*Items::temp, *Items::temp, getParams());
+  FX::drawPreview(Items::temp, Items::preview->bitmap);
+  Items::preview->redraw();
+}
+
+void MarbleDialog::updateMain()
+{
+  Items::temp->blit(Project::bmp, 0, 0, 0, 0, Items::temp->w, Items::temp->h);
+  Gui::getView()->invalidate(0, 0, Items::temp->w - 1, Items::temp->h - 1);
+  Gui::getView()->drawMain(true);
+}
+
+void MarbleDialog::setMarb()
+{
+  if (Items::marb->var == Items::old_marb_var)
+    return;
+
+  update();
+  Items::old_marb_var = Items::marb->var;
+}
+
+void MarbleDialog::setTurb()
+{
+  if (Items::turb->var == Items::old_turb_var)
+    return;
+
+  update();
+  Items::old_turb_var = Items::turb->var;
+}
+
+void MarbleDialog::setBlend()
+{
+  if (Items::blend->var == Items::old_blend_var)
+    return;
+
+  update();
+  Items::old_blend_var = Items::blend->var;
+}
+
+void MarbleDialog::setThreshold()
+{
+  if (Items::threshold->var == Items::old_threshold_var)
+    return;
+
+  update();
+  Items::old_threshold_var = Items::threshold->var;
+}
@@ -18,10 +18,18 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Inline.H"
 #include "Normalize.H"
+#include "Progress.H"
+#include "Threads.H"
 
-void Normalize::apply(Bitmap *bmp)
+void Normalize::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   // search for highest & lowest RGB values
   int r_high = 0;
   int g_high = 0;
@@ -73,7 +81,7 @@ void Normalize::apply(Bitmap *bmp)
 
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -88,17 +96,10 @@ void Normalize::apply(Bitmap *bmp)
       *p = makeRgba(r, g, b, rgba.a);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Normalize::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
@@ -18,29 +18,29 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Inline.H"
 #include "Painting.H"
+#include "Progress.H"
+#include "Threads.H"
 
-namespace
+void Painting::apply(const Bitmap &src, Bitmap &dest,
+                     const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *amount;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  const int amount = params.amount;
 
-void Painting::apply()
-{
-  Bitmap *bmp = Project::bmp;
-  int amount = Items::amount->value();
+  bmp->copy(&src);
+
+  // rows are done in parallel, so results go to a copy instead of in-place
+  Bitmap temp(bmp->cw, bmp->ch);
 
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
-    int *p = bmp->row[y] + bmp->cl;
+    const int *s = bmp->row[y] + bmp->cl;
+    int *p = temp.row[y - bmp->ct];
 
     for (int x = bmp->cl; x <= bmp->cr; x++)
     {
@@ -53,7 +53,7 @@ void Painting::apply()
       {
         for (int i = -amount; i <= amount; i++) 
         {
-          const int c3 = *p;
+          const int c3 = *s;
           const int c1 = bmp->getpixel(x + i, y + j);
           const int c2 = bmp->getpixel(x - i, y - j);
 
@@ -78,51 +78,16 @@ void Painting::apply()
       g /= count;
       b /= count;
 
-      *p = makeRgba(r, g, b, geta(*p));
+      *p = makeRgba(r, g, b, geta(*s));
+      s++;
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
-  Progress::hide();
-}
+  temp.blit(bmp, 0, 0, bmp->cl, bmp->ct, temp.w, temp.h);
 
-void Painting::close()
-{
-    Items::dialog->hide();
-    Project::undo->push();
-    apply();
-}
-
-void Painting::quit()
-{
   Progress::hide();
-  Items::dialog->hide();
 }
-
-void Painting::begin()
-{
-  Items::dialog->show();
-}
-
-void Painting::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Painting");
-
-  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount (1-10)", 0, 1, 10);
-  y1 += 32 + 16;
-  Items::amount->value(3);
-  Items::amount->center();
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
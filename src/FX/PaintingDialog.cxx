@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "Painting.H"
+#include "PaintingDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    InputInt *amount;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void PaintingDialog::close()
+{
+    Items::dialog->hide();
+    Project::undo->push();
+
+    Painting::params_type params;
+
+    params.amount = Items::amount->value();
+    Painting::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void PaintingDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void PaintingDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void PaintingDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Painting");
+
+  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount (1-10)", 0, 1, 10);
+  y1 += 32 + 16;
+  Items::amount->value(3);
+  Items::amount->center();
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
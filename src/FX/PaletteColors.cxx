@@ -18,10 +18,21 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Palette.H"
 #include "PaletteColors.H"
+#include "Progress.H"
 
-void PaletteColors::apply(Bitmap *bmp, Palette *pal)
+void PaletteColors::apply(const Bitmap &src, Bitmap &dest,
+                          const params_type &params)
 {
+  Bitmap *bmp = &dest;
+  Palette *pal = params.palette;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
   const float inc = 1.0 / (bmp->cw * bmp->ch);
@@ -114,10 +125,3 @@ void PaletteColors::apply(Bitmap *bmp, Palette *pal)
 
   Progress::hide();
 }
-
-void PaletteColors::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp, Project::palette);
-}
-
@@ -18,11 +18,23 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "Randomize.H"
 
-void Randomize::apply()
+// the random state and the blend are local, so batch mode can run this on
+// several images at once
+void Randomize::apply(const Bitmap &src, Bitmap &dest,
+                      const params_type &params)
 {
-  Bitmap *bmp = Project::bmp;
+  Bitmap *bmp = &dest;
+  const int random_seed = params.random_seed;
+
+  bmp->copy(&src);
+
+  int seed = random_seed != 0 ? random_seed : 12345;
 
   for (int j = 0; j < 1; j++)
   {
@@ -31,12 +43,14 @@ void Randomize::apply()
     {
       for (int x = bmp->cl + 1 + j; x <= bmp->cr; x += 2)
       {
-        if ((rnd() & 1) == 1)
+        if ((rnd(seed) & 1) == 1)
         {
           const int temp = bmp->getpixel(x, y);
 
-          bmp->setpixel(x, y, bmp->getpixel(x - 1, y), 128);
-          bmp->setpixel(x - 1, y, temp, 128);
+          bmp->setpixel(x, y, Blend::trans(temp, bmp->getpixel(x - 1, y),
+                                           128));
+          bmp->setpixel(x - 1, y, Blend::trans(bmp->getpixel(x - 1, y),
+                                               temp, 128));
         }
       }
     }
@@ -46,12 +60,14 @@ void Randomize::apply()
     {
       for (int y = bmp->ct + 1 + j; y <= bmp->cb; y += 2)
       {
-        if ((rnd() & 1) == 1)
+        if ((rnd(seed) & 1) == 1)
         {
           const int temp = bmp->getpixel(x, y);
 
-          bmp->setpixel(x, y, bmp->getpixel(x, y - 1), 128);
-          bmp->setpixel(x, y - 1, temp, 128);
+          bmp->setpixel(x, y, Blend::trans(temp, bmp->getpixel(x, y - 1),
+                                           128));
+          bmp->setpixel(x, y - 1, Blend::trans(bmp->getpixel(x, y - 1),
+                                               temp, 128));
         }
       }
     }
@@ -59,10 +75,3 @@ void Randomize::apply()
 
   Progress::hide();
 }
-
-void Randomize::begin()
-{
-  Project::undo->push();
-  apply();
-}
-
@@ -18,22 +18,19 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "RemoveDust.H"
 
-namespace
+void RemoveDust::apply(const Bitmap &src, Bitmap &dest,
+                       const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *amount;
-    CheckBox *invert;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  int amount = params.amount;
+
+  bmp->copy(&src);
 
-void RemoveDust::apply(Bitmap *bmp, int amount)
-{
   Progress::show(bmp->h);
 
   for (int y = bmp->ct + 1; y <= bmp->cb - 1; y++)
@@ -80,52 +77,3 @@ void RemoveDust::apply(Bitmap *bmp, int amount)
 
   Progress::hide();
 }
-
-void RemoveDust::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  if (Items::invert->value())
-    Invert::apply(Project::bmp);
-
-  apply(Project::bmp, Items::amount->value());
-
-  if (Items::invert->value())
-    Invert::apply(Project::bmp);
-}
-
-void RemoveDust::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void RemoveDust::begin()
-{
-  Items::dialog->show();
-}
-
-void RemoveDust::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Remove Dust");
-
-  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount (1-10)", 0, 1, 10);
-  y1 += 32 + 16;
-  Items::amount->value(4);
-  Items::amount->center();
-
-  Items::invert = new CheckBox(Items::dialog, 0, y1, 16, 16, "Invert First", 0);
-  y1 += 16 + 16;
-  Items::invert->center();
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
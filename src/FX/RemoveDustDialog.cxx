@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "RemoveDust.H"
+#include "RemoveDustDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    InputInt *amount;
+    CheckBox *invert;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void RemoveDustDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  Bitmap *bmp = Project::bmp;
+  RemoveDust::params_type params;
+
+  params.amount = Items::amount->value();
+
+  if (Items::invert->value())
+    Invert::apply(*bmp, *bmp, {});
+
+  RemoveDust::apply(*bmp, *bmp, params);
+
+  if (Items::invert->value())
+    Invert::apply(*bmp, *bmp, {});
+}
+
+void RemoveDustDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void RemoveDustDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void RemoveDustDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Remove Dust");
+
+  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32, "Amount (1-10)", 0, 1, 10);
+  y1 += 32 + 16;
+  Items::amount->value(4);
+  Items::amount->center();
+
+  Items::invert = new CheckBox(Items::dialog, 0, y1, 16, 16, "Invert First", 0);
+  y1 += 16 + 16;
+  Items::invert->center();
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
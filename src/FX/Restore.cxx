@@ -23,32 +23,27 @@ This attempts to correct a color cast by computing adjustment factors
 based on an overall average, which are then used to "undo" the cast.
 */
 
+#include <cmath>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "Restore.H"
+#include "Threads.H"
 
-namespace
+void Restore::apply(const Bitmap &src, Bitmap &dest, const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    CheckBox *normalize;
-    CheckBox *invert;
-    CheckBox *preserve_lum;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  const bool keep_lum = params.keep_lum;
 
-void Restore::apply()
-{
-  Bitmap *bmp = Project::bmp;
+  bmp->copy(&src);
 
   double rr = 0;
   double gg = 0;
   double bb = 0;
   int count = 0;
 
-  const bool keep_lum = Items::preserve_lum->value();
-
   // determine overall color cast
   for (int y = bmp->ct; y <= bmp->cb; y++)
   {
@@ -79,7 +74,7 @@ void Restore::apply()
   // begin restore
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -107,65 +102,10 @@ void Restore::apply()
 
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Restore::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  if (Items::normalize->value())
-    Normalize::apply(Project::bmp);
-  if (Items::invert->value())
-    Invert::apply(Project::bmp);
-
-  apply();
-
-  if (Items::invert->value())
-    Invert::apply(Project::bmp);
-}
-
-void Restore::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void Restore::begin()
-{
-  Items::dialog->show();
-}
-
-void Restore::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Restore");
-
-  Items::normalize = new CheckBox(Items::dialog, 0, y1, 16, 16, "Normalize First", 0);
-  y1 += 16 + 16;
-  Items::normalize->value(1);
-  Items::normalize->center();
-
-  Items::invert = new CheckBox(Items::dialog, 0, y1, 16, 16, "Invert First", 0);
-  Items::invert->center();
-  y1 += 16 + 16;
-
-  Items::preserve_lum = new CheckBox(Items::dialog, 8, y1, 16, 16, "Preserve Luminosity", 0);
-  y1 += 16 + 16;
-
-  Items::preserve_lum->center();
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
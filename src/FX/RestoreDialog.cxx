@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "Restore.H"
+#include "RestoreDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    CheckBox *normalize;
+    CheckBox *invert;
+    CheckBox *preserve_lum;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void RestoreDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  Bitmap *bmp = Project::bmp;
+  Restore::params_type params;
+
+  params.keep_lum = Items::preserve_lum->value();
+
+  if (Items::normalize->value())
+    Normalize::apply(*bmp, *bmp, {});
+  if (Items::invert->value())
+    Invert::apply(*bmp, *bmp, {});
+
+  Restore::apply(*bmp, *bmp, params);
+
+  if (Items::invert->value())
+    Invert::apply(*bmp, *bmp, {});
+}
+
+void RestoreDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void RestoreDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void RestoreDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Restore");
+
+  Items::normalize = new CheckBox(Items::dialog, 0, y1, 16, 16, "Normalize First", 0);
+  y1 += 16 + 16;
+  Items::normalize->value(1);
+  Items::normalize->center();
+
+  Items::invert = new CheckBox(Items::dialog, 0, y1, 16, 16, "Invert First", 0);
+  Items::invert->center();
+  y1 += 16 + 16;
+
+  Items::preserve_lum = new CheckBox(Items::dialog, 8, y1, 16, 16, "Preserve Luminosity", 0);
+  y1 += 16 + 16;
+
+  Items::preserve_lum->center();
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
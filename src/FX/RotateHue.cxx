@@ -18,38 +18,34 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "RotateHue.H"
+#include "Threads.H"
 
-namespace
+// angle is in degrees, -360 to 360
+void RotateHue::apply(const Bitmap &src, Bitmap &dest,
+                      const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    Widget *preview;
-    Widget *hue;
-    Fl_Repeat_Button *inc_hue;
-    Fl_Repeat_Button *dec_hue;
-    CheckBox *preserve_lum;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  const int angle = params.angle;
+  const bool keep_lum = params.keep_lum;
+  const bool show_progress = params.show_progress;
 
-void RotateHue::apply(Bitmap *dest, bool show_progress)
-{
-  const int hh = (((Items::hue->var + 180) % 360) * 6) * .712;
-  const bool keep_lum = Items::preserve_lum->value();
+  bmp->copy(&src);
 
-  FX::drawPreview(Project::bmp, Items::preview->bitmap);
+  const int hh = (((angle + 360) % 360) * 6) * .712;
 
   if (show_progress)
-    Progress::show(dest->h);
+    Progress::show(bmp->h);
 
-  for (int y = dest->ct; y <= dest->cb; y++)
+  auto row = [&](const int y)
   {
-    int *p = dest->row[y] + dest->cl;
+    int *p = bmp->row[y] + bmp->cl;
 
-    for (int x = dest->cl; x <= dest->cr; x++)
+    for (int x = bmp->cl; x <= bmp->cr; x++)
     {
       int c = *p;
 
@@ -75,108 +71,17 @@ void RotateHue::apply(Bitmap *dest, bool show_progress)
 
       p++;
     }
+  };
 
-    if (show_progress)
-    {
-      if (Progress::update(y) < 0)
-        return;
-    }
+  if (show_progress)
+  {
+    if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+      return;
   }
-
-  Progress::hide();
-}
-
-void RotateHue::begin()
-{
-  Items::hue->var = 180;
-  FX::drawPreview(Project::bmp, Items::preview->bitmap);
-  Items::preview->redraw();
-  Items::hue->do_callback();
-  Items::dialog->show();
-}
-
-void RotateHue::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-  apply(Project::bmp, true);
-}
-
-void RotateHue::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void RotateHue::init()
-{
-  int x1 = 528 / 2 - (360 + 28 * 2) / 2;
-  int y1 = 8;
-
-  Items::dialog = new DialogWindow(528, 0, "Rotate Hue");
-  Items::preview = new Widget(Items::dialog, 8, y1, 512, 512, 0, 1, 1, 0);
-  y1 += 512 + 8;
-  Items::dec_hue = new Fl_Repeat_Button(x1, y1, 20, 32, "@<");
-  Items::dec_hue->callback((Fl_Callback *)decHue);
-  Items::hue = new Widget(Items::dialog, x1 + 28, y1, 360, 32, 0, 1, 32, (Fl_Callback *)setHue);
-  Items::hue->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
-  Items::hue->labelfont(FL_COURIER);
-  Items::inc_hue = new Fl_Repeat_Button(x1 + 28 + 360 + 8, y1, 20, 32, "@>");
-  Items::inc_hue->callback((Fl_Callback *)incHue);
-  y1 += 24 + 8 + 32;
-  Items::preserve_lum = new CheckBox(Items::dialog, 0, y1, 16, 16, "Preserve Luminosity", (Fl_Callback *)setHue);
-  Items::preserve_lum->center();
-  y1 += 16 + 8;
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
-void RotateHue::setHue()
-{
-  int hx = Items::hue->var % 360;
-
-  Items::hue->bitmap->clear(getFltkColor(FL_BACKGROUND2_COLOR));
-
-  for (int x = 0; x < 360; x++)
+    else
   {
-    if (!(x % 60))
-      Items::hue->bitmap->vline(8, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
-    else if (!(x % 30))
-      Items::hue->bitmap->vline(16, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
-    else if (!(x % 15))
-      Items::hue->bitmap->vline(20, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
+    Threads::run(bmp->ct, bmp->cb, row);
   }
 
-  Items::hue->bitmap->rect(0, 0, Items::hue->bitmap->w - 1, Items::hue->bitmap->h - 1, makeRgb(0, 0, 0), 0);
-  Items::hue->bitmap->xorVline(0, hx, 31);
-  Items::hue->redraw();
-
-  char degree[16];
-
-  Items::hue->copy_label("                ");
-  snprintf(degree, sizeof(degree), "%d\xB0", (int)(hx - 180));
-
-  Items::hue->copy_label(degree);
-  apply(Items::preview->bitmap, false);
-  Items::preview->redraw();
-}
-
-void RotateHue::incHue()
-{
-  Items::hue->var++;
-  if (Items::hue->var > 359)
-    Items::hue->var = 359;
-  setHue();
-}
-
-void RotateHue::decHue()
-{
-  Items::hue->var--;
-  if (Items::hue->var < 0)
-    Items::hue->var = 0;
-  setHue();
+  Progress::hide();
 }
-
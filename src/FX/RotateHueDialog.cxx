@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "RotateHue.H"
+#include "RotateHueDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    Widget *preview;
+    Widget *hue;
+    Fl_Repeat_Button *inc_hue;
+    Fl_Repeat_Button *dec_hue;
+    CheckBox *preserve_lum;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void RotateHueDialog::begin()
+{
+  Items::hue->var = 180;
+  FX::drawPreview(Project::bmp, Items::preview->bitmap);
+  Items::preview->redraw();
+  Items::hue->do_callback();
+  Items::dialog->show();
+}
+
+void RotateHueDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  RotateHue::params_type params;
+
+  params.angle = Items::hue->var - 180;
+  params.keep_lum = Items::preserve_lum->value();
+  params.show_progress = true;
+  RotateHue::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void RotateHueDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void RotateHueDialog::init()
+{
+  int x1 = 528 / 2 - (360 + 28 * 2) / 2;
+  int y1 = 8;
+
+  Items::dialog = new DialogWindow(528, 0, "Rotate Hue");
+  Items::preview = new Widget(Items::dialog, 8, y1, 512, 512, 0, 1, 1, 0);
+  y1 += 512 + 8;
+  Items::dec_hue = new Fl_Repeat_Button(x1, y1, 20, 32, "@<");
+  Items::dec_hue->callback((Fl_Callback *)decHue);
+  Items::hue = new Widget(Items::dialog, x1 + 28, y1, 360, 32, 0, 1, 32, (Fl_Callback *)setHue);
+  Items::hue->align(FL_ALIGN_CENTER | FL_ALIGN_BOTTOM);
+  Items::hue->labelfont(FL_COURIER);
+  Items::inc_hue = new Fl_Repeat_Button(x1 + 28 + 360 + 8, y1, 20, 32, "@>");
+  Items::inc_hue->callback((Fl_Callback *)incHue);
+  y1 += 24 + 8 + 32;
+  Items::preserve_lum = new CheckBox(Items::dialog, 0, y1, 16, 16, "Preserve Luminosity", (Fl_Callback *)setHue);
+  Items::preserve_lum->center();
+  y1 += 16 + 8;
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
+
+void RotateHueDialog::setHue()
+{
+  int hx = Items::hue->var % 360;
+
+  Items::hue->bitmap->clear(getFltkColor(FL_BACKGROUND2_COLOR));
+
+  for (int x = 0; x < 360; x++)
+  {
+    if (!(x % 60))
+      Items::hue->bitmap->vline(8, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
+    else if (!(x % 30))
+      Items::hue->bitmap->vline(16, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
+    else if (!(x % 15))
+      Items::hue->bitmap->vline(20, x, 31, getFltkColor(FL_FOREGROUND_COLOR), 160);
+  }
+
+  Items::hue->bitmap->rect(0, 0, Items::hue->bitmap->w - 1, Items::hue->bitmap->h - 1, makeRgb(0, 0, 0), 0);
+  Items::hue->bitmap->xorVline(0, hx, 31);
+  Items::hue->redraw();
+
+  char degree[16];
+
+  Items::hue->copy_label("                ");
+  snprintf(degree, sizeof(degree), "%d\xB0", (int)(hx - 180));
+
+  Items::hue->copy_label(degree);
+  FX::drawPreview(Project::bmp, Items::preview->bitmap);
+
+  RotateHue::params_type params;
+  Bitmap *preview = Items::preview->bitmap;
+
+  params.angle = hx - 180;
+  params.keep_lum = Items::preserve_lum->value();
+  params.show_progress = false;
+  RotateHue::apply(*preview, *preview, params);
+  Items::preview->redraw();
+}
+
+void RotateHueDialog::incHue()
+{
+  Items::hue->var++;
+  if (Items::hue->var > 359)
+    Items::hue->var = 359;
+  setHue();
+}
+
+void RotateHueDialog::decHue()
+{
+  Items::hue->var--;
+  if (Items::hue->var < 0)
+    Items::hue->var = 0;
+  setHue();
+}
@@ -18,10 +18,21 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "Saturate.H"
+#include "Threads.H"
 
-void Saturate::apply(Bitmap *bmp)
+void Saturate::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   std::vector<int> list_s(256, 0);
 
   const int size = bmp->cw * bmp->ch;
@@ -53,7 +64,7 @@ void Saturate::apply(Bitmap *bmp)
 
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
     int *p = bmp->row[y] + bmp->cl;
 
@@ -89,17 +100,10 @@ void Saturate::apply(Bitmap *bmp)
       *p = Blend::colorize(c1, Blend::keepLum(makeRgba(r, g, b, rgba.a), l), 255 - s);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   Progress::hide();
 }
-
-void Saturate::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
@@ -26,10 +26,19 @@ It works remarkably well on certain "hard-to-fix" photographs, particularly thos
 Restore, Equalize, etc.
 */
 
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "SideAbsorptions.H"
 
-void SideAbsorptions::apply(Bitmap *bmp)
+void SideAbsorptions::apply(const Bitmap &src, Bitmap &dest,
+                            const params_type &)
 {
+  Bitmap *bmp = &dest;
+
+  bmp->copy(&src);
+
   Progress::show(bmp->h);
 
   for (int y = bmp->ct; y <= bmp->cb; y++)
@@ -68,10 +77,3 @@ void SideAbsorptions::apply(Bitmap *bmp)
 
   Progress::hide();
 }
-
-void SideAbsorptions::begin()
-{
-  Project::undo->push();
-  apply(Project::bmp);
-}
-
@@ -18,29 +18,31 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <cmath>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "FilterMatrix.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "Sobel.H"
+#include "Threads.H"
 
-namespace
+void Sobel::apply(const Bitmap &src, Bitmap &dest, const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *amount;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  int amount = params.amount;
+
+  bmp->copy(&src);
 
-void Sobel::apply(Bitmap *bmp, int amount)
-{
   int div = 1;
 
   Bitmap temp(bmp->cw, bmp->ch);
   Progress::show(bmp->h);
 
-  for (int y = bmp->ct; y <= bmp->cb; y++)
+  auto row = [&](const int y)
   {
-    int *p = temp.row[y - bmp->cl];
+    int *p = temp.row[y - bmp->ct];
 
     for (int x = bmp->cl; x <= bmp->cr; x++)
     {
@@ -83,51 +85,12 @@ void Sobel::apply(Bitmap *bmp, int amount)
       *p = Blend::trans(c, makeRgba(r, g, b, geta(c)), 255 - amount * 2.55);
       p++;
     }
+  };
 
-    if (Progress::update(y) < 0)
-      return;
-  }
+  if (Threads::rows(bmp->ct, bmp->cb, row) < 0)
+    return;
 
   temp.blit(bmp, 0, 0, bmp->cl, bmp->ct, temp.w, temp.h);
 
   Progress::hide();
 }
-
-void Sobel::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-  apply(Project::bmp, Items::amount->value());
-}
-
-void Sobel::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void Sobel::begin()
-{
-  Items::dialog->show();
-}
-
-void Sobel::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(256, 0, "Sobel Edge Detection");
-
-  Items::amount = new InputInt(Items::dialog, 0, y1, 128, 32,
-                               "Amount %", 0, 0, 100);
-  Items::amount->value(100);
-  Items::amount->center();
-  y1 += 32 + 16;
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
@@ -18,20 +18,20 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Inline.H"
+#include "KDtree.H"
+#include "Map.H"
+#include "Progress.H"
 #include "StainedGlass.H"
 
 namespace
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *detail;
-    CheckBox *sat_alpha;
-    CheckBox *draw_edges;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-
   int isSegmentEdge(Bitmap *b, const int x, const int y)
   {
     const int c0 = b->getpixel(x, y);
@@ -46,27 +46,36 @@ namespace
   }
 }
 
-void StainedGlass::apply()
+// the random state is local, so batch mode can run this on several
+// images at once
+void StainedGlass::apply(const Bitmap &src, Bitmap &dest,
+                         const params_type &params)
 {
-  Bitmap *bmp = Project::bmp;
-  int size = Items::detail->value() + 5;
+  Bitmap *bmp = &dest;
+  const int detail = params.detail;
+  const bool sat_alpha = params.sat_alpha;
+  const bool draw_edges = params.draw_edges;
+  const int random_seed = params.random_seed;
+
+  bmp->copy(&src);
+
+  int seed = random_seed != 0 ? random_seed : 12345;
+  int size = detail + 5;
 
   size = std::pow(size, 2.5);
 
-  KDtree::node_type test_node;
-  KDtree::node_type *root, *found;
   std::vector<KDtree::node_type> points(size);
-  int best_distance;
+  std::vector<int> found(bmp->cr - bmp->cl + 1);
 
   for (int i = 0; i < size; i++)
   {
-    points[i].x[0] = rnd() % bmp->w; 
-    points[i].x[1] = rnd() % bmp->h; 
+    points[i].x[0] = rnd(seed) % bmp->w; 
+    points[i].x[1] = rnd(seed) % bmp->h; 
     points[i].x[2] = 0;
     points[i].index = bmp->getpixel(points[i].x[0], points[i].x[1]);
   }
 
-  root = KDtree::build(&points[0], size, 0);
+  KDtree::build(&points[0], size);
 
   Progress::show(bmp->h);
 
@@ -75,29 +84,24 @@ void StainedGlass::apply()
   {
     int *p = bmp->row[y] + bmp->cl;
 
+    KDtree::nearestRow(&points[0], size, bmp->cl, bmp->cr, y, 0, &found[0]);
+
     for (int x = bmp->cl; x <= bmp->cr; x++)
     {
-      test_node.x[0] = x;
-      test_node.x[1] = y;
-      test_node.x[2] = 0;
-      found = 0;
-      KDtree::nearest(root, &test_node, &found, &best_distance, 0);
+      const int index = points[found[x - bmp->cl]].index;
 
-      if (found)
+      if (sat_alpha)
       {
-        if (Items::sat_alpha->value())
-        {
-          rgba_type rgba = getRgba(found->index);
-
-          int h, s, v;
-
-          Blend::rgbToHsv(rgba.r, rgba.g, rgba.b, &h, &s, &v);
-          *p = makeRgba(rgba.r, rgba.g, rgba.b, std::min(192, s / 2 + 128));
-        }
-          else
-        {
-          *p = found->index;
-        }
+        rgba_type rgba = getRgba(index);
+
+        int h, s, v;
+
+        Blend::rgbToHsv(rgba.r, rgba.g, rgba.b, &h, &s, &v);
+        *p = makeRgba(rgba.r, rgba.g, rgba.b, std::min(192, s / 2 + 128));
+      }
+        else
+      {
+        *p = index;
       }
 
       p++;
@@ -108,9 +112,10 @@ void StainedGlass::apply()
   }
 
   // draw edges
-  if (found && Items::draw_edges->value())
+  if (draw_edges)
   {
-    Map *map = Project::map;
+    Map edges(bmp->w, bmp->h);
+    Map *map = &edges;
     map->clear(0);
 
     for (int y = bmp->ct; y <= bmp->cb; y++)
@@ -140,48 +145,3 @@ void StainedGlass::apply()
 
   Progress::hide();
 }
-
-void StainedGlass::close()
-{
-    Items::dialog->hide();
-    Project::undo->push();
-    apply();
-}
-
-void StainedGlass::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void StainedGlass::begin()
-{
-  Items::dialog->show();
-}
-
-void StainedGlass::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Stained Glass");
-
-  Items::detail = new InputInt(Items::dialog, 0, y1, 128, 32, "Detail (1-100)", 0, 1, 100);
-  Items::detail->value(25);
-  Items::detail->center();
-  y1 += 32 + 16;
-
-  Items::sat_alpha = new CheckBox(Items::dialog, 0, y1, 16, 16, "Saturation to Alpha", 0);
-  Items::sat_alpha->center();
-  y1 += 16 + 16;
-
-  Items::draw_edges = new CheckBox(Items::dialog, 0, y1, 16, 16, "Draw Edges", 0);
-  Items::draw_edges->center();
-  y1 += 16 + 16;
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "StainedGlass.H"
+#include "StainedGlassDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    InputInt *detail;
+    CheckBox *sat_alpha;
+    CheckBox *draw_edges;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void StainedGlassDialog::close()
+{
+    Items::dialog->hide();
+    Project::undo->push();
+
+    StainedGlass::params_type params;
+
+    params.detail = Items::detail->value();
+    params.sat_alpha = Items::sat_alpha->value();
+    params.draw_edges = Items::draw_edges->value();
+    params.random_seed = rnd();
+    StainedGlass::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void StainedGlassDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void StainedGlassDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void StainedGlassDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Stained Glass");
+
+  Items::detail = new InputInt(Items::dialog, 0, y1, 128, 32, "Detail (1-100)", 0, 1, 100);
+  Items::detail->value(25);
+  Items::detail->center();
+  y1 += 32 + 16;
+
+  Items::sat_alpha = new CheckBox(Items::dialog, 0, y1, 16, 16, "Saturation to Alpha", 0);
+  Items::sat_alpha->center();
+  y1 += 16 + 16;
+
+  Items::draw_edges = new CheckBox(Items::dialog, 0, y1, 16, 16, "Draw Edges", 0);
+  Items::draw_edges->center();
+  y1 += 16 + 16;
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
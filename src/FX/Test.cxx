@@ -18,15 +18,10 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include "Bitmap.H"
 #include "Test.H"
 
-void Test::apply()
+void Test::apply(const Bitmap &src, Bitmap &dest, const params_type &)
 {
+  dest.copy(&src);
 }
-
-void Test::begin()
-{
-  Project::undo->push();
-  apply();
-}
-
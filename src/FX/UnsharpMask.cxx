@@ -18,23 +18,27 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bitmap.H"
+#include "Blend.H"
+#include "Gamma.H"
+#include "Inline.H"
+#include "Progress.H"
 #include "UnsharpMask.H"
 
-namespace
+void UnsharpMask::apply(const Bitmap &src, Bitmap &dest,
+                        const params_type &params)
 {
-  namespace Items
-  {
-    DialogWindow *dialog;
-    InputInt *radius;
-    InputFloat *amount;
-    InputInt *threshold;
-    Fl_Button *ok;
-    Fl_Button *cancel;
-  }
-}
+  Bitmap *bmp = &dest;
+  int radius = params.radius;
+  double amount = params.amount;
+  int threshold = params.threshold;
+
+  bmp->copy(&src);
 
-void UnsharpMask::apply(Bitmap *bmp, int radius, double amount, int threshold)
-{
   radius = (radius + 1) * 2 + 1;
   std::vector<int> kernel(radius);
   int div = 0;
@@ -160,56 +164,3 @@ void UnsharpMask::apply(Bitmap *bmp, int radius, double amount, int threshold)
 
   Progress::hide();
 }
-
-void UnsharpMask::close()
-{
-  Items::dialog->hide();
-  Project::undo->push();
-
-  const int radius = Items::radius->value();
-  const double amount = Items::amount->value();
-  const int threshold = Items::threshold->value();
-
-  apply(Project::bmp, radius, amount, threshold);
-}
-
-void UnsharpMask::quit()
-{
-  Progress::hide();
-  Items::dialog->hide();
-}
-
-void UnsharpMask::begin()
-{
-  Items::dialog->show();
-}
-
-void UnsharpMask::init()
-{
-  int y1 = 16;
-
-  Items::dialog = new DialogWindow(400, 0, "Unsharp Mask");
-
-  Items::radius = new InputInt(Items::dialog, 0, y1, 128, 32, "Radius (1-100)", 0, 1, 100);
-  y1 += 32 + 16;
-  Items::radius->value(1);
-  Items::radius->center();
-
-  Items::amount = new InputFloat(Items::dialog, 0, y1, 128, 32, "Amount (0-10)", 0, 0, 10);
-  y1 += 32 + 16;
-  Items::amount->value(1.5);
-  Items::amount->center();
-
-  Items::threshold = new InputInt(Items::dialog, 0, y1, 128, 32, "Threshold (0-255)", 0, 0, 255);
-  y1 += 32 + 16;
-  Items::threshold->value(0);
-  Items::threshold->center();
-
-  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
-  Items::ok->callback((Fl_Callback *)close);
-  Items::cancel->callback((Fl_Callback *)quit);
-
-  Items::dialog->set_modal();
-  Items::dialog->end();
-}
-
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include "FX.H"
+#include "UnsharpMask.H"
+#include "UnsharpMaskDialog.H"
+
+namespace
+{
+  namespace Items
+  {
+    DialogWindow *dialog;
+    InputInt *radius;
+    InputFloat *amount;
+    InputInt *threshold;
+    Fl_Button *ok;
+    Fl_Button *cancel;
+  }
+}
+
+void UnsharpMaskDialog::close()
+{
+  Items::dialog->hide();
+  Project::undo->push();
+
+  UnsharpMask::params_type params;
+
+  params.radius = Items::radius->value();
+  params.amount = Items::amount->value();
+  params.threshold = Items::threshold->value();
+
+  UnsharpMask::apply(*Project::bmp, *Project::bmp, params);
+}
+
+void UnsharpMaskDialog::quit()
+{
+  Progress::hide();
+  Items::dialog->hide();
+}
+
+void UnsharpMaskDialog::begin()
+{
+  Items::dialog->show();
+}
+
+void UnsharpMaskDialog::init()
+{
+  int y1 = 16;
+
+  Items::dialog = new DialogWindow(400, 0, "Unsharp Mask");
+
+  Items::radius = new InputInt(Items::dialog, 0, y1, 128, 32, "Radius (1-100)", 0, 1, 100);
+  y1 += 32 + 16;
+  Items::radius->value(1);
+  Items::radius->center();
+
+  Items::amount = new InputFloat(Items::dialog, 0, y1, 128, 32, "Amount (0-10)", 0, 0, 10);
+  y1 += 32 + 16;
+  Items::amount->value(1.5);
+  Items::amount->center();
+
+  Items::threshold = new InputInt(Items::dialog, 0, y1, 128, 32, "Threshold (0-255)", 0, 0, 255);
+  y1 += 32 + 16;
+  Items::threshold->value(0);
+  Items::threshold->center();
+
+  Items::dialog->addOkCancelButtons(&Items::ok, &Items::cancel, &y1);
+  Items::ok->callback((Fl_Callback *)close);
+  Items::cancel->callback((Fl_Callback *)quit);
+
+  Items::dialog->set_modal();
+  Items::dialog->end();
+}
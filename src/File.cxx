@@ -25,38 +25,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include <cmath>
 #include <vector>
 
-#include <FL/Fl_Group.H>
-#include <FL/Fl_Image.H>
-#include <FL/Fl_Native_File_Chooser.H>
-
 #include "Bitmap.H"
-#include "ColorOptions.H"
-#include "Dialog.H"
 #include "File.H"
 #include "FileSP.H"
-#include "Gui.H"
-#include "ImagesOptions.H"
 #include "Inline.H"
-#include "Map.H"
 #include "Palette.H"
-#include "Project.H"
-#include "Stroke.H"
-#include "Selection.H"
-#include "Undo.H"
-#include "View.H"
-#include "Widget.H"
-
-enum
-{
-  ERROR_FILE_NOT_FOUND,
-  ERROR_LOADING,
-  ERROR_SAVING,
-  ERROR_BMP_BITS,
-  ERROR_TGA_BITS,
-  ERROR_JPG_BITS,
-  ERROR_DIMENSIONS,
-  ERROR_UNKNOWN
-};
 
 #pragma pack(push)
 #pragma pack(1)
@@ -127,55 +100,49 @@ void jpg_exit(j_common_ptr cinfo)
   longjmp(myerr->setjmp_buffer, 1);
 }
 
-// bitmap pointer used for FLTK's file preview
-//Bitmap *preview_bmp = 0;
-
-// palette preview widget
-//Widget *pal_preview;
-
-enum
+namespace
 {
-  TYPE_PNG,
-  TYPE_JPG,
-  TYPE_BMP,
-  TYPE_TGA
-};
- 
-int File::last_type = 0;
-
-// store previous directory
-char File::last_dir[FILE_PATH_MAX];
+  // shown as a dialog when the gui is running (see FileDialog.cxx),
+  // printed otherwise
+  void showMessage(const char *title, const char *text)
+  {
+    if (File::message_callback)
+      File::message_callback(title, text);
+    else
+      fprintf(stderr, "%s: %s\n", title, text);
+  }
+}
 
-const char *File::ext_string[] = { ".png", ".jpg", ".bmp", ".tga" };
+void (*File::message_callback)(const char *, const char *) = 0;
 
 void File::errorMessage(const int message)
 {
   switch (message)
   {
     case ERROR_FILE_NOT_FOUND:
-      Dialog::message("File Error", "File not found.");
+      showMessage("File Error", "File not found.");
       break;
     case ERROR_LOADING:
-      Dialog::message("File Error", "Could not load image.");
+      showMessage("File Error", "Could not load image.");
       break;
     case ERROR_SAVING:
-      Dialog::message("File Error", "Could not save image.");
+      showMessage("File Error", "Could not save image.");
       break;
     case ERROR_BMP_BITS:
-      Dialog::message("File Error", "Only uncompressed 24-bit BMP\nfiles are supported.");
+      showMessage("File Error", "Only uncompressed 24-bit BMP\nfiles are supported.");
       break;
     case ERROR_TGA_BITS:
-      Dialog::message("File Error", "Only uncompressed 24 or 32-bit TGA\nfiles are supported.");
+      showMessage("File Error", "Only uncompressed 24 or 32-bit TGA\nfiles are supported.");
       break;
     case ERROR_JPG_BITS:
-      Dialog::message("File Error", "Only RGB or grayscale JPEG files\nare supported.");
+      showMessage("File Error", "Only RGB or grayscale JPEG files\nare supported.");
       break;
     case ERROR_DIMENSIONS:
-      Dialog::message("File Error", "Dimensions over 16384 are\nnot supported.");
+      showMessage("File Error", "Dimensions over 16384 are\nnot supported.");
       break;
     case ERROR_UNKNOWN:
     default:
-      Dialog::message("File Error", "Unknown error.");
+      showMessage("File Error", "Unknown error.");
       break;
   }
 }
@@ -215,10 +182,9 @@ bool File::isBmp(const unsigned char *header)
 bool File::isTarga(const char *fn)
 {
   // targa has no real header, will have to trust the file extension
-  const char *ext;
+  const char *ext = strrchr(fn, '.');
 
-  ext = fl_filename_ext(fn);
-  return (strcasecmp(ext, ".tga") == 0);
+  return (ext && strcasecmp(ext, ".tga") == 0);
 }
 
 bool File::isGimpPalette(const unsigned char *header)
@@ -236,56 +202,15 @@ void File::pngReadFromArray(png_structp png_ptr,
   src->pos += length;
 }
 
-void File::init()
-{
-  snprintf(last_dir, sizeof(last_dir), ".");
-}
-
-/*
-void createPalettePreview()
-{
-  pal_preview = new Widget(new Fl_Group(0, 0, 96, 96),
-                      0, 0, 96, 96, "", 6, 6, 0);
-}
-*/
-
-// display file loading dialog
-void File::load(Fl_Widget *, void *)
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Load Image");
-  //fc.filter("All Files\t*.*\n"
-  fc.filter("PNG \t*.png\n"
-            "JPEG \t*.{jpg,jpeg}\n"
-            "Bitmap \t*.bmp\n"
-            "Targa \t*.tga\n");
-//  fc.options(Fl_Native_File_Chooser::PREVIEW);
-  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
-  fc.filter_value(last_type);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  File::loadFile(fc.filename());
-}
-
-// load a file
-int File::loadFile(const char *fn)
+// load any supported image type without touching the project
+Bitmap *File::loadImage(const char *fn)
 {
   FileSP in(fn, "rb");
 
   if (!in.get())
   {
     errorMessage(ERROR_FILE_NOT_FOUND);
-    return -1;
+    return 0;
   }
 
   unsigned char header[8];
@@ -293,42 +218,17 @@ int File::loadFile(const char *fn)
   if (fread(&header, 1, 8, in.get()) != 8)
   {
     errorMessage(ERROR_LOADING);
-    return -1;
+    return 0;
   }
 
-  // load to a temporary bitmap first
-  Bitmap *temp = 0;
-
   if (isPng(header))
-    temp = File::loadPng((const char *)fn);
+    return File::loadPng(fn);
   else if (isJpeg(header))
-    temp = File::loadJpeg((const char *)fn);
+    return File::loadJpeg(fn);
   else if (isBmp(header))
-    temp = File::loadBmp((const char *)fn);
+    return File::loadBmp(fn);
   else if (isTarga(fn))
-    temp = File::loadTarga((const char *)fn);
-
-  if (!temp)
-  {
-    return -1;
-  }
-
-  if (Project::newImageFromBitmap(temp) == -1)
-  {
-    delete temp;
-    return -1;
-  }
-    else
-  {
-    char s[FILE_PATH_MAX];
-
-    getFilename(s, fn);
-    Gui::images->addFile(s);
-  }
-
-  // redraw
-  Project::stroke->clip();
-  Gui::getView()->drawMain(true);
+    return File::loadTarga(fn);
 
   return 0;
 }
@@ -1047,71 +947,6 @@ Bitmap *File::loadPngFromArray(const unsigned char *array)
   return temp;
 }
 
-void File::save(Fl_Widget *, void *)
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Save Image");
-  fc.filter("PNG \t*.png\n"
-            "JPEG \t*.jpg\n"
-            "Bitmap \t*.bmp\n"
-            "Targa \t*.tga\n");
-
-//  fc.options(Fl_Native_File_Chooser::PREVIEW);
-  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
-  fc.filter_value(last_type);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  char fn[FILE_PATH_MAX];
-  snprintf(fn, sizeof(fn), "%s", fc.filename());
-
-  int ext_value = fc.filter_value();
-  fl_filename_setext(fn, sizeof(fn), ext_string[ext_value]);
-
-  if (fileExists(fn))
-  {
-    if (!Dialog::choice("Replace File?", "Overwrite?"))
-      return;
-  }
-
-  int ret = -1;
-  
-  switch (ext_value)
-  {
-    case TYPE_PNG:
-      ret = File::savePng(Project::bmp, fn);
-      break;
-    case TYPE_JPG:
-      ret = File::saveJpeg(Project::bmp, fn);
-      break;
-    case TYPE_BMP:
-      ret = File::saveBmp(Project::bmp, fn);
-      break;
-    case TYPE_TGA:
-      ret = File::saveTarga(Project::bmp, fn);
-      break;
-
-    default:
-      ret = -1;
-  }
-
-  if (ret == -1)
-  {
-    errorMessage(ERROR_SAVING);
-  }
-
-  last_type = ext_value;
-}
-
 int File::saveBmp(Bitmap *bmp, const char *fn)
 {
   FileSP out(fn, "wb");
@@ -1169,7 +1004,7 @@ int File::saveBmp(Bitmap *bmp, const char *fn)
 
   if (found_alpha)
   {
-    Dialog::message("Warning", "Image contains transparency information\nwhich will be discarded.");
+    showMessage("Warning", "Image contains transparency information\nwhich will be discarded.");
   }
 
   p = bmp->data;
@@ -1245,22 +1080,13 @@ int File::saveTarga(Bitmap *bmp, const char *fn)
   return 0;
 }
 
-int File::savePng(Bitmap *bmp, const char *fn)
+// write png without asking for options (the palette is only used
+// if use_palette is set)
+int File::writePng(Bitmap *bmp, const char *fn, Palette *pal,
+                   const bool use_palette, const bool use_alpha,
+                   const int alpha_levels)
 {
-  Dialog::pngOptions();
-  bool use_palette = Dialog::pngUsePalette();
-  bool use_alpha = Dialog::pngUseAlpha();
-  int alpha_levels = Dialog::pngAlphaLevels();
   float alpha_step = 255.0 / (alpha_levels - 1);
-  Palette *pal = Project::palette;
-
-  if (use_palette && use_alpha && pal->max * alpha_levels > 256)
-  {
-    Dialog::message("PNG Error",
-                    "Not enough palette entries left for this\n"
-                    "many alpha channel levels.");
-    return 0;
-  }
 
   std::vector<png_color> palette(256);
   std::vector<png_byte> trans(256);
@@ -1397,7 +1223,8 @@ int File::savePng(Bitmap *bmp, const char *fn)
   return 0;
 }
 
-int File::saveJpeg(Bitmap *bmp, const char *fn)
+// write jpeg without asking for the quality
+int File::writeJpeg(Bitmap *bmp, const char *fn, const int quality)
 {
   struct jpeg_compress_struct cinfo;
   struct my_error_mgr jerr;
@@ -1417,10 +1244,6 @@ int File::saveJpeg(Bitmap *bmp, const char *fn)
     return 0;
   }
 
-  // show quality dialog
-  Dialog::jpegQuality();
-
-  int quality = Dialog::jpegQualityValue();
   int w = bmp->cw;
   int h = bmp->ch;
 
@@ -1459,187 +1282,6 @@ int File::saveJpeg(Bitmap *bmp, const char *fn)
   return 0;
 }
 
-// load a palette using the file chooser
-void File::loadPalette()
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Load Palette");
-  fc.filter("GIMP Palette\t*.gpl\n");
-  fc.options(Fl_Native_File_Chooser::PREVIEW);
-  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  char fn[FILE_PATH_MAX];
-
-  snprintf(fn, sizeof(fn), "%s", fc.filename());
-
-  FileSP in(fn, "r");
-
-  if (!in.get())
-    return;
-
-  unsigned char header[12];
-
-  if (fread(&header, 1, 12, in.get()) != 12)
-  {
-//    errorMessage();
-    return;
-  }
-
-  if (isGimpPalette(header))
-  {
-    if (Project::palette->load((const char*)fn) < 0)
-    {
-//      errorMessage();
-      return;
-    }
-
-    Gui::colors->paletteDraw();
-  }
-}
-
-// save a palette using the file chooser
-void File::savePalette()
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Save Palette");
-  fc.filter("GIMP Palette\t*.gpl\n");
-  fc.options(Fl_Native_File_Chooser::PREVIEW);
-  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  char fn[FILE_PATH_MAX];
-
-  snprintf(fn, sizeof(fn), "%s", fc.filename());
-  fl_filename_setext(fn, sizeof(fn), ".gpl");
-
-  if (fileExists(fn))
-  {
-    if (!Dialog::choice("Replace File?",
-                      "Do you want to overwrite this file?"))
-    {
-      return;
-    }
-  }
-  
-  if (Project::palette->save(fn) < 0)
-  {
-//    errorMessage();
-    return;
-  }
-}
-
-void File::loadSelection()
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Load Selection");
-  fc.filter("PNG \t*.png\n");
-  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
-  fc.filter_value(0);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  FileSP in(fc.filename(), "rb");
-
-  if (!in.get())
-    return;
-
-  unsigned char header[8];
-
-  if (fread(&header, 1, 8, in.get()) != 8)
-    return;
-
-  // load to a temporary bitmap first
-  Bitmap *temp = 0;
-
-  if (isPng(header))
-    temp = File::loadPng((const char *)fc.filename());
-  else
-    return;
-
-  delete Project::select_bmp;
-  Project::select_bmp = temp;
-  Project::selection->reload();
-}
-
-void File::saveSelection()
-{
-  Fl_Native_File_Chooser fc;
-  fc.title("Save Selection");
-  fc.filter("PNG \t*.png\n");
-  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
-  fc.filter_value(0);
-  fc.directory(last_dir);
-
-  switch (fc.show())
-  {
-    case -1:
-    case 1:
-      return;
-    default:
-      getDirectory(last_dir, fc.filename());
-      break;
-  }
-
-  char fn[FILE_PATH_MAX];
-  snprintf(fn, sizeof(fn), "%s", fc.filename());
-
-  int ext_value = fc.filter_value();
-  fl_filename_setext(fn, sizeof(fn), ext_string[ext_value]);
-
-  if (fileExists(fn))
-  {
-    if (!Dialog::choice("Replace File?", "Overwrite?"))
-      return;
-  }
-
-  int ret = -1;
-
-  switch (ext_value)
-  {
-    case TYPE_PNG:
-      ret = File::savePng(Project::select_bmp, fn);
-      break;
-
-    default:
-      ret = -1;
-  }
-
-  if (ret == -1)
-  {
-    errorMessage(ERROR_UNKNOWN);
-  }
-}
-
 // convert special characters from drag n' drop path/filename string
 void File::decodeURI(char *str, int len)
 {
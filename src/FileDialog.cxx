@@ -0,0 +1,415 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Image.H>
+#include <FL/Fl_Native_File_Chooser.H>
+
+#include "Bitmap.H"
+#include "ColorOptions.H"
+#include "Dialog.H"
+#include "File.H"
+#include "FileSP.H"
+#include "Gui.H"
+#include "ImagesOptions.H"
+#include "Inline.H"
+#include "Map.H"
+#include "Palette.H"
+#include "Project.H"
+#include "Stroke.H"
+#include "Selection.H"
+#include "Undo.H"
+#include "View.H"
+#include "Widget.H"
+
+// bitmap pointer used for FLTK's file preview
+//Bitmap *preview_bmp = 0;
+
+// palette preview widget
+//Widget *pal_preview;
+
+enum
+{
+  TYPE_PNG,
+  TYPE_JPG,
+  TYPE_BMP,
+  TYPE_TGA
+};
+ 
+int File::last_type = 0;
+
+// store previous directory
+char File::last_dir[FILE_PATH_MAX];
+
+const char *File::ext_string[] = { ".png", ".jpg", ".bmp", ".tga" };
+
+void File::init()
+{
+  snprintf(last_dir, sizeof(last_dir), ".");
+  message_callback = Dialog::message;
+}
+
+/*
+void createPalettePreview()
+{
+  pal_preview = new Widget(new Fl_Group(0, 0, 96, 96),
+                      0, 0, 96, 96, "", 6, 6, 0);
+}
+*/
+
+// display file loading dialog
+void File::load(Fl_Widget *, void *)
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Load Image");
+  //fc.filter("All Files\t*.*\n"
+  fc.filter("PNG \t*.png\n"
+            "JPEG \t*.{jpg,jpeg}\n"
+            "Bitmap \t*.bmp\n"
+            "Targa \t*.tga\n");
+//  fc.options(Fl_Native_File_Chooser::PREVIEW);
+  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
+  fc.filter_value(last_type);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  File::loadFile(fc.filename());
+}
+
+// load a file
+int File::loadFile(const char *fn)
+{
+  // load to a temporary bitmap first
+  Bitmap *temp = loadImage(fn);
+
+  if (!temp)
+  {
+    return -1;
+  }
+
+  if (Project::newImageFromBitmap(temp) == -1)
+  {
+    delete temp;
+    return -1;
+  }
+    else
+  {
+    char s[FILE_PATH_MAX];
+
+    getFilename(s, fn);
+    Gui::images->addFile(s);
+  }
+
+  // redraw
+  Project::stroke->clip();
+  Gui::getView()->drawMain(true);
+
+  return 0;
+}
+
+void File::save(Fl_Widget *, void *)
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Save Image");
+  fc.filter("PNG \t*.png\n"
+            "JPEG \t*.jpg\n"
+            "Bitmap \t*.bmp\n"
+            "Targa \t*.tga\n");
+
+//  fc.options(Fl_Native_File_Chooser::PREVIEW);
+  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+  fc.filter_value(last_type);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  char fn[FILE_PATH_MAX];
+  snprintf(fn, sizeof(fn), "%s", fc.filename());
+
+  int ext_value = fc.filter_value();
+  fl_filename_setext(fn, sizeof(fn), ext_string[ext_value]);
+
+  if (fileExists(fn))
+  {
+    if (!Dialog::choice("Replace File?", "Overwrite?"))
+      return;
+  }
+
+  int ret = -1;
+  
+  switch (ext_value)
+  {
+    case TYPE_PNG:
+      ret = File::savePng(Project::bmp, fn);
+      break;
+    case TYPE_JPG:
+      ret = File::saveJpeg(Project::bmp, fn);
+      break;
+    case TYPE_BMP:
+      ret = File::saveBmp(Project::bmp, fn);
+      break;
+    case TYPE_TGA:
+      ret = File::saveTarga(Project::bmp, fn);
+      break;
+
+    default:
+      ret = -1;
+  }
+
+  if (ret == -1)
+  {
+    errorMessage(ERROR_SAVING);
+  }
+
+  last_type = ext_value;
+}
+
+int File::savePng(Bitmap *bmp, const char *fn)
+{
+  Dialog::pngOptions();
+  bool use_palette = Dialog::pngUsePalette();
+  bool use_alpha = Dialog::pngUseAlpha();
+  int alpha_levels = Dialog::pngAlphaLevels();
+  Palette *pal = Project::palette;
+
+  if (use_palette && use_alpha && pal->max * alpha_levels > 256)
+  {
+    Dialog::message("PNG Error",
+                    "Not enough palette entries left for this\n"
+                    "many alpha channel levels.");
+    return 0;
+  }
+
+  return writePng(bmp, fn, pal, use_palette, use_alpha, alpha_levels);
+}
+
+int File::saveJpeg(Bitmap *bmp, const char *fn)
+{
+  // show quality dialog
+  Dialog::jpegQuality();
+
+  return writeJpeg(bmp, fn, Dialog::jpegQualityValue());
+}
+
+// load a palette using the file chooser
+void File::loadPalette()
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Load Palette");
+  fc.filter("GIMP Palette\t*.gpl\n");
+  fc.options(Fl_Native_File_Chooser::PREVIEW);
+  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  char fn[FILE_PATH_MAX];
+
+  snprintf(fn, sizeof(fn), "%s", fc.filename());
+
+  FileSP in(fn, "r");
+
+  if (!in.get())
+    return;
+
+  unsigned char header[12];
+
+  if (fread(&header, 1, 12, in.get()) != 12)
+  {
+//    errorMessage();
+    return;
+  }
+
+  if (isGimpPalette(header))
+  {
+    if (Project::palette->load((const char*)fn) < 0)
+    {
+//      errorMessage();
+      return;
+    }
+
+    Gui::colors->paletteDraw();
+  }
+}
+
+// save a palette using the file chooser
+void File::savePalette()
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Save Palette");
+  fc.filter("GIMP Palette\t*.gpl\n");
+  fc.options(Fl_Native_File_Chooser::PREVIEW);
+  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  char fn[FILE_PATH_MAX];
+
+  snprintf(fn, sizeof(fn), "%s", fc.filename());
+  fl_filename_setext(fn, sizeof(fn), ".gpl");
+
+  if (fileExists(fn))
+  {
+    if (!Dialog::choice("Replace File?",
+                      "Do you want to overwrite this file?"))
+    {
+      return;
+    }
+  }
+  
+  if (Project::palette->save(fn) < 0)
+  {
+//    errorMessage();
+    return;
+  }
+}
+
+void File::loadSelection()
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Load Selection");
+  fc.filter("PNG \t*.png\n");
+  fc.type(Fl_Native_File_Chooser::BROWSE_FILE);
+  fc.filter_value(0);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  FileSP in(fc.filename(), "rb");
+
+  if (!in.get())
+    return;
+
+  unsigned char header[8];
+
+  if (fread(&header, 1, 8, in.get()) != 8)
+    return;
+
+  // load to a temporary bitmap first
+  Bitmap *temp = 0;
+
+  if (isPng(header))
+    temp = File::loadPng((const char *)fc.filename());
+  else
+    return;
+
+  delete Project::select_bmp;
+  Project::select_bmp = temp;
+  Project::selection->reload();
+}
+
+void File::saveSelection()
+{
+  Fl_Native_File_Chooser fc;
+  fc.title("Save Selection");
+  fc.filter("PNG \t*.png\n");
+  fc.type(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
+  fc.filter_value(0);
+  fc.directory(last_dir);
+
+  switch (fc.show())
+  {
+    case -1:
+    case 1:
+      return;
+    default:
+      getDirectory(last_dir, fc.filename());
+      break;
+  }
+
+  char fn[FILE_PATH_MAX];
+  snprintf(fn, sizeof(fn), "%s", fc.filename());
+
+  int ext_value = fc.filter_value();
+  fl_filename_setext(fn, sizeof(fn), ext_string[ext_value]);
+
+  if (fileExists(fn))
+  {
+    if (!Dialog::choice("Replace File?", "Overwrite?"))
+      return;
+  }
+
+  int ret = -1;
+
+  switch (ext_value)
+  {
+    case TYPE_PNG:
+      ret = File::savePng(Project::select_bmp, fn);
+      break;
+
+    default:
+      ret = -1;
+  }
+
+  if (ret == -1)
+  {
+    errorMessage(ERROR_UNKNOWN);
+  }
+}
+
@@ -32,26 +32,32 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Gui.H"
 #include "Inline.H"
 #include "InputInt.H"
-#include "KDtree.H"
 #include "Map.H"
 #include "Progress.H"
 #include "Project.H"
-#include "Stroke.H"
+#include "Threads.H"
 #include "Undo.H"
 #include "View.H"
 
+namespace
+{
+  // row of pixels to look for fillable runs in
+  struct span_type
+  {
+    int x1, x2, y;
+  };
+
+  // larger ranges tend to cover most of the image, so the color test is
+  // worth doing for every pixel up front, in parallel
+  const int MASK_RANGE = 8;
+}
+
 Fill::Fill()
 {
-  stack_size = 16384;
-  stack_x = new int [stack_size];
-  stack_y = new int [stack_size];
-  sp = 0;
 }
 
 Fill::~Fill()
 {
-  delete[] stack_x;
-  delete[] stack_y;
 }
 
 bool Fill::inbox(int x, int y, int x1, int y1, int x2, int y2)
@@ -67,39 +73,10 @@ bool Fill::inbox(int x, int y, int x1, int y1, int x2, int y2)
     return false;
 }
 
-// finds edges
-bool Fill::isEdge(Map *map, const int x, const int y)
+// edge feathering, takes the squared distance to the nearest edge
+int Fill::fineEdge(const int dist, const int feather, const int trans)
 {
-  // special case
-  if (x < 1 || x >= map->w - 1 || y < 1 || y >= map->h - 1)
-  {
-//    if (*(map->row[y] + x))
-//      return 0;
-//    else
-      return 1;
-  }
-
-  if ( *(map->row[y - 1] + x) &&
-      *(map->row[y] + x - 1) &&
-      *(map->row[y] + x + 1) &&
-      *(map->row[y + 1] + x) )
-  {
-    return 0;
-  }
-    else
-  {
-    return 1;
-  }
-}
-
-// edge feathering
-int Fill::fineEdge(int x1, int y1, const int x2, const int y2,
-             const int feather, const int trans)
-{
-  x1 -= x2;
-  y1 -= y2;
-
-  const float d = std::sqrt(x1 * x1 + y1 * y1);
+  const float d = std::sqrt(dist);
   const int s = (255 - trans) / (feather + 1);
   int temp = s * d;
 
@@ -108,64 +85,20 @@ int Fill::fineEdge(int x1, int y1, const int x2, const int y2,
   return temp < trans ? trans : temp;
 }
 
-// flood-fill related stack routines
-bool Fill::pop(int *x, int *y)
-{
-  if (sp > 0)
-  {
-    *x = stack_x[sp];
-    *y = stack_y[sp];
-    sp--;
-    return true;
-  }
-
-  return false;
-}
-
-bool Fill::push(const int x, const int y)
-{
-  if (sp < stack_size - 1)
-  {
-    sp++;
-    stack_x[sp] = x;
-    stack_y[sp] = y;
-    return true;
-  }
-
-  return false;
-}
-
-void Fill::clear()
-{
-  int x, y;
-
-  while (pop(&x, &y))
-  {
-    // loop until pop returns false
-  }
-}
-
+// same as sqrt(diff32(c1, c2)) / 2 <= range
 bool Fill::inRange(const int c1, const int c2, const int range)
 {
-  if ((std::sqrt(diff32(c1, c2)) / 2) <= range)
-    return true;
-  else
-    return false;
+  return diff32(c1, c2) <= 4 * range * range;
 }
 
-void Fill::fill(int x, int y, int new_color, int old_color, int range, int feather, int color_only)
+// scanline flood fill, filled pixels are marked in the map
+// (or every pixel in range when global is set, connected or not)
+void Fill::fill(int x, int y, int new_color, int old_color, int range, int feather, int color_only, int global)
 {
   if (old_color == new_color)
     return;
 
-  clear();
-  
-  if (!push(x, y))
-    return;
-
   Bitmap *bmp = Project::bmp;
-  Bitmap temp(bmp->w, bmp->h);
-  bmp->blit(&temp, 0, 0, 0, 0, bmp->w, bmp->h);
   Map *map = Project::map;
   map->clear(0);
 
@@ -174,97 +107,144 @@ void Fill::fill(int x, int y, int new_color, int old_color, int range, int feath
   int ct = bmp->ct;
   int cb = bmp->cb;
 
-  while (pop(&x, &y))
-  {    
-    int x1 = x;
+  const int cw = (cr - cl) + 1;
+  const int ch = (cb - ct) + 1;
 
-    while (x1 >= cl && inRange(temp.getpixel(x1, y), old_color, range))
-      x1--;
-
-    x1++;
+  if (global)
+  {
+    // one pass over the rows, in parallel
+    Threads::run(ct, cb, [&](int yy)
+    {
+      const int *p = bmp->row[yy] + cl;
+      unsigned char *m = map->row[yy - ct];
 
-    bool span_t = false;
-    bool span_b = false;
+      for (int xx = 0; xx < cw; xx++)
+        m[xx] = inRange(p[xx], old_color, range) ? 255 : 0;
+    });
+  }
+    else
+  {
+    std::vector<unsigned char> mask;
 
-    while (x1 <= cr && inRange(temp.getpixel(x1, y), old_color, range))
+    if (range >= MASK_RANGE)
     {
-      temp.setpixel(x1, y, new_color);
-      map->setpixel(x1 - bmp->cl, y - bmp->ct, 255);
+      mask.resize(cw * ch);
 
-      if ((!span_t && y > ct) && inRange(temp.getpixel(x1, y - 1),
-                                        old_color, range))
+      Threads::run(ct, cb, [&](int yy)
       {
-        if (!push(x1, y - 1))
-          return;
+        const int *p = bmp->row[yy] + cl;
+        unsigned char *m = &mask[(yy - ct) * cw];
 
-        span_t = true;
-      }
-      else if ((span_t && y > ct) && !inRange(temp.getpixel(x1, y - 1),
-                                             old_color, range))
-      {
-        span_t = false;
-      }
+        for (int xx = 0; xx < cw; xx++)
+          m[xx] = inRange(p[xx], old_color, range);
+      });
+    }
 
-      if ((!span_b && y < cb) && inRange(temp.getpixel(x1, y + 1),
-                                        old_color, range))
-      {
-        if (!push(x1, y + 1))
-          return;
+    // not filled yet, and close enough to the old color
+    auto fillable = [&](const int xx, const int yy)
+    {
+      if (*(map->row[yy - ct] + xx - cl))
+        return false;
 
-        span_b = true;
-      }
-      else if ((span_b && y < cb) && !inRange(temp.getpixel(x1, y + 1),
-                                             old_color, range))
+      if (mask.size() > 0)
+        return mask[(yy - ct) * cw + xx - cl] != 0;
+
+      return inRange(*(bmp->row[yy] + xx), old_color, range);
+    };
+
+    // grows as needed, so large fills are never cut short
+    std::vector<span_type> spans;
+
+    spans.push_back(span_type { x, x, y });
+
+    while (spans.size() > 0)
+    {
+      const span_type span = spans.back();
+      spans.pop_back();
+
+      y = span.y;
+      x = span.x1;
+
+      while (x <= span.x2)
       {
-        span_b = false;
-      } 
+        if (!fillable(x, y))
+        {
+          x++;
+          continue;
+        }
+
+        int x1 = x;
+        int x2 = x;
 
-      x1++;
+        while (x1 > cl && fillable(x1 - 1, y))
+          x1--;
+
+        while (x2 < cr && fillable(x2 + 1, y))
+          x2++;
+
+        unsigned char *m = map->row[y - ct] - cl;
+
+        std::fill(m + x1, m + x2 + 1, 255);
+
+        if (y > ct)
+          spans.push_back(span_type { x1, x2, y - 1 });
+
+        if (y < cb)
+          spans.push_back(span_type { x1, x2, y + 1 });
+
+        x = x2 + 1;
+      }
     }
   }
 
   if (feather == 0)
   {
-    if (color_only)
+    for (y = ct; y <= cb; y++)
     {
-      for (int y = 0; y < temp.h; y++)
+      unsigned char *m = map->row[y - ct];
+      int *p = bmp->row[y] + cl;
+
+      for (x = 0; x < cw; x++)
       {
-        for (int x = 0; x < temp.w; x++)
+        if (m[x] == 0)
+          continue;
+
+        if (color_only)
+        {
+          const int c1 = p[x];
+          const int c = Blend::trans(c1, new_color, 255 - geta(c1));
+          bmp->setpixel(x + cl, y, Blend::keepLum(c, getl(c1)));
+        }
+          else
         {
-          if (temp.getpixel(x, y) == new_color)
-          {
-            const int c1 = bmp->getpixel(x, y);
-            const int c = Blend::trans(c1, temp.getpixel(x, y), 255 - geta(c1));
-            bmp->setpixel(x, y, Blend::keepLum(c, getl(c1)));
-          }
+          p[x] = new_color;
         }
       }
     }
-      else
-    {
-      temp.blit(bmp, 0, 0, 0, 0, temp.w, temp.h);
-    }
 
     return;
   }
 
-  Stroke *stroke = Project::stroke;
   int count = 0;
+  int tl = 0xfffff;
+  int tr = 0;
+  int tt = 0xfffff;
+  int tb = 0;
 
   Progress::show((cb - ct) + 1);
 
+  // bounds of the edges
   for (y = ct; y <= cb; y++)
   {
     for (x = cl; x <= cr; x++)
     {
-      if (map->getpixel(x - cl, y - ct) && isEdge(map, x - cl, y - ct))
+      if (map->isEdge(x - cl, y - ct))
       {
-        stroke->edge_x[count] = x;
-        stroke->edge_y[count] = y;
+        tl = std::min(tl, x);
+        tr = std::max(tr, x);
+        tt = std::min(tt, y);
+        tb = std::max(tb, y);
         count++;
-
-        if (count > 0xfffff)
-          break;
       }
     }
 
@@ -275,39 +255,6 @@ void Fill::fill(int x, int y, int new_color, int old_color, int range, int feath
   if (count == 0)
     return;
 
-  KDtree::node_type test_node;
-  KDtree::node_type *root, *found;
-  std::vector<KDtree::node_type> points(count);
-
-  int best_dist;
-
-  int tl = 0xfffff;
-  int tr = 0;
-  int tt = 0xfffff;
-  int tb = 0;
-
-  for (int i = 0; i < count; i++)
-  {
-    const int ex = stroke->edge_x[i];
-    const int ey = stroke->edge_y[i];
-
-    if (ex < tl)
-      tl = ex;
-
-    if (ex > tr)
-      tr = ex;
-
-    if (ey < tt)
-      tt = ey;
-
-    if (ey > tb)
-      tb = ey;
-
-    points[i].x[0] = ex;
-    points[i].x[1] = ey;
-    points[i].x[2] = 0;
-  }
-
   tl -= feather;
   tr += feather;
   tt -= feather;
@@ -331,7 +278,6 @@ void Fill::fill(int x, int y, int new_color, int old_color, int range, int feath
   if (tt > tb)
     std::swap(tt, tb);
 
-  root = KDtree::build(&points[0], count, 0);
   Progress::show((cb - ct) + 1);
 
   for (y = ct; y <= cb; y++)
@@ -344,23 +290,24 @@ void Fill::fill(int x, int y, int new_color, int old_color, int range, int feath
     }
   }
 
+  // distance to the nearest edge, every edge is inside this area
+  std::vector<int> dist;
+
+  map->distance(dist, tl - cl, tt - ct, tr - cl, tb - ct);
+
+  const int dw = (tr - tl) + 1;
+
   for (y = tt; y <= tb; y++)
   {
+    const int *d = &dist[(y - tt) * dw];
+
     for (x = tl; x <= tr; x++)
     {
       if (map->getpixel(x - cl, y - ct) == 255)
         continue;
 
-      test_node.x[0] = x;
-      test_node.x[1] = y;
-      test_node.x[2] = 0;
-      found = 0;
-      KDtree::nearest(root, &test_node, &found, &best_dist, 0);
-
-      const int zx = found->x[0];
-      const int zy = found->x[1];
       const int c1 = bmp->getpixel(x, y);
-      const int t = fineEdge(x, y, zx, zy, feather, 0);
+      const int t = fineEdge(d[x - tl], feather, 0);
 
       if (color_only)
       {
@@ -398,8 +345,12 @@ void Fill::push(View *view)
          target,
          Gui::fill->getRange(),
          Gui::fill->getFeather(),
-         Gui::fill->getColorOnly());
+         Gui::fill->getColorOnly(),
+         Gui::fill->getGlobal());
+
+    Bitmap *bmp = Project::bmp;
 
+    view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
     view->drawMain(true);
   }
 }
@@ -62,6 +62,11 @@ FillOptions::FillOptions(int x, int y, int w, int h, const char *l)
   fill_color_only->center();
   fill_color_only->value(0);
   pos += 32;
+
+  fill_global = new CheckBox(this, 8, pos, 16, 16, "Global", 0);
+  fill_global->center();
+  fill_global->value(0);
+  pos += 32;
   
   new Separator(this, 0, pos, Gui::OPTIONS_WIDTH, Separator::HORIZONTAL, "");
   pos += 4 + Gui::SPACING;
@@ -92,6 +97,11 @@ int FillOptions::getColorOnly()
   return fill_color_only->value();
 }
 
+int FillOptions::getGlobal()
+{
+  return fill_global->value();
+}
+
 void FillOptions::reset()
 {
   fill_range->value(0);
@@ -20,18 +20,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 
 #include <cmath>
 
-#include <FL/fl_draw.H>
-#include <FL/Fl_Group.H>
-
 #include "Fractal.H"
 #include "Inline.H"
 #include "Map.H"
 
-namespace
-{
-  int level, turb;
-}
-
 void Fractal::marble(Map *src, Map *dest, Map *marbx, Map *marby, float scale, float turbulence, int type)
 {
   int xval[256];
@@ -119,13 +111,28 @@ void Fractal::marble(Map *src, Map *dest, Map *marbx, Map *marby, float scale, f
   }
 }
 
-void Fractal::plasma(Map * map, int turbulence)
+// continues the shared random sequence
+void Fractal::plasma(Map *map, int turbulence)
+{
+  plasma_type state = { 0, turbulence, rnd_seed };
+
+  plasma(map, &state);
+  rnd_seed = state.seed;
+}
+
+// same seed always gives the same plasma
+void Fractal::plasma(Map *map, int turbulence, int seed)
+{
+  plasma_type state = { 0, turbulence, seed != 0 ? seed : 12345 };
+
+  plasma(map, &state);
+}
+
+void Fractal::plasma(Map *map, plasma_type *state)
 {
   int w, h;
 
   map->clear(0);
-  turb = turbulence;
-  level = 0;
 
   w = map->w;
   h = map->h;
@@ -135,14 +142,25 @@ void Fractal::plasma(Map * map, int turbulence)
   map->setpixel(0, h - 1, 0);
   map->setpixel(w - 1, h - 1, 0);
 
-  divide(map, 0, 0, w - 1, h - 1);
+  divide(map, state, 0, 0, w - 1, h - 1);
+}
+
+// same generator as rnd()
+int Fractal::random(plasma_type *state)
+{
+  state->seed ^= state->seed << 17;
+  state->seed ^= state->seed >> 13;
+  state->seed ^= state->seed <<  5;
+
+  return state->seed;
 }
 
-int Fractal::adjust(Map * map, int xa, int ya, int x, int y, int xb, int yb)
+int Fractal::adjust(Map *map, plasma_type *state,
+                    int xa, int ya, int x, int y, int xb, int yb)
 {
-  int r = (rnd() % turb) >> level;
+  int r = (random(state) % state->turb) >> state->level;
 
-  if ((rnd() % 2) == 0)
+  if ((random(state) % 2) == 0)
     r = -r;
 
   r = ((map->getpixel(xa, ya) + map->getpixel(xb, yb) + 1) >> 1) + r;
@@ -166,14 +184,15 @@ int Fractal::adjust(Map * map, int xa, int ya, int x, int y, int xb, int yb)
   return r;
 }
 
-void Fractal::divide(Map * map, int x1, int y1, int x2, int y2)
+void Fractal::divide(Map *map, plasma_type *state,
+                     int x1, int y1, int x2, int y2)
 {
   int x, y, i, v;
 
   if (((x2 - x1) < 2) && ((y2 - y1) < 2))
     return;
 
-  level++;
+  state->level++;
 
   x = (x1 + x2) >> 1;
   y = (y1 + y2) >> 1;
@@ -181,36 +200,36 @@ void Fractal::divide(Map * map, int x1, int y1, int x2, int y2)
   v = map->getpixel(x, y1);
 
   if (!v)
-    v = Fractal::adjust(map, x1, y1, x, y1, x2, y1);
+    v = Fractal::adjust(map, state, x1, y1, x, y1, x2, y1);
 
   i = v;
   v = map->getpixel(x2, y);
 
   if (!v)
-    v = Fractal::adjust(map, x2, y1, x2, y, x2, y2);
+    v = Fractal::adjust(map, state, x2, y1, x2, y, x2, y2);
 
   i += v;
   v = map->getpixel(x, y2);
 
   if (!v)
-    v = Fractal::adjust(map, x1, y2, x, y2, x2, y2);
+    v = Fractal::adjust(map, state, x1, y2, x, y2, x2, y2);
 
   i += v;
   v = map->getpixel(x1, y);
 
   if (!v)
-    v = Fractal::adjust(map, x1, y1, x1, y, x1, y2);
+    v = Fractal::adjust(map, state, x1, y1, x1, y, x1, y2);
 
   i += v;
 
   if (!map->getpixel(x, y))
     map->setpixel(x, y, ((i + 2) >> 2));
 
-  divide(map, x1, y1, x, y);
-  divide(map, x, y1, x2, y);
-  divide(map, x, y, x2, y2);
-  divide(map, x1, y, x, y2);
+  divide(map, state, x1, y1, x, y);
+  divide(map, state, x, y1, x2, y);
+  divide(map, state, x, y, x2, y2);
+  divide(map, state, x1, y, x, y2);
 
-  level--;
+  state->level--;
 }
 
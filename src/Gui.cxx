@@ -18,11 +18,14 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <cstdio>
+
 #include <FL/Fl_Double_Window.H>
 #include <FL/Fl_Progress.H>
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/Fl_Tooltip.H>
 
+#include "Bitmap.H"
 #include "ColorOptions.H"
 #include "Dialog.H"
 #include "Editor.H"
@@ -38,6 +41,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Palette.H"
 #include "PaintOptions.H"
 #include "PickerOptions.H"
+#include "Progress.H"
 #include "Project.H"
 #include "Separator.H"
 #include "Selection.H"
@@ -246,6 +250,81 @@ public:
   }
 };
 
+namespace
+{
+  // progress bar, see Progress.cxx
+  void progressShow()
+  {
+    Gui::view->rendering = true;
+
+    // keep progress bar on right side in case window was resized
+    Gui::progress->resize(Gui::getStatus()->x() + Gui::getWindow()->w()
+                          - 256 - 8, Gui::getStatus()->y() + 4, 256, 24);
+    Gui::progress->show();
+    Gui::view->drawMain(true);
+  }
+
+  int progressUpdate(const float value, const bool redraw)
+  {
+    // user cancelled operation
+    if (Fl::get_key(FL_Escape))
+    {
+      Gui::view->drawMain(true);
+      return -1;
+    }
+
+    if (redraw)
+    {
+      Gui::progress->value(value);
+      char percent[16];
+      snprintf(percent, sizeof(percent), "%d%%", (int)value);
+      Gui::progress->copy_label(percent);
+
+      // filters only change the clipped area of the image
+      Bitmap *bmp = Project::bmp;
+
+      Gui::view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
+      Gui::view->drawDirty(true);
+    }
+
+    return 0;
+  }
+
+  void progressHide()
+  {
+    Gui::progress->value(0);
+    Gui::progress->copy_label("");
+    Gui::progress->redraw();
+    Gui::progress->hide();
+    Gui::view->rendering = false;
+
+    // include rows changed since the last progress step
+    Bitmap *bmp = Project::bmp;
+
+    Gui::view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
+    Gui::view->drawMain(true);
+  }
+
+  void progressInfo(const char *s)
+  {
+    static bool saved = false;
+
+    if (s)
+    {
+      if (!saved)
+        Gui::saveStatusInfo();
+
+      saved = true;
+      Gui::statusInfo(s);
+    }
+      else if (saved)
+    {
+      saved = false;
+      Gui::restoreStatusInfo();
+    }
+  }
+}
+
 // initialize main gui
 void Gui::init()
 {
@@ -323,7 +402,7 @@ void Gui::init()
   menubar->add("&Palette/&Create...", 0,
     (Fl_Callback *)Dialog::makePalette, 0, 0);
   menubar->add("&Palette/&Apply\\/Dither...", 0,
-    (Fl_Callback *)Dither::begin, 0, FL_MENU_DIVIDER);
+    (Fl_Callback *)DitherDialog::begin, 0, FL_MENU_DIVIDER);
   menubar->add("&Palette/Presets/Default", 0,
     (Fl_Callback *)paletteSetDefault, 0, 0);
   menubar->add("Palette/Presets/Black and White", 0,
@@ -358,63 +437,63 @@ void Gui::init()
     (Fl_Callback *)Editor::popRedo, 0, 0);
 
 //  menubar->add("F&X/Color/Test", 0,
-//    (Fl_Callback *)Test::begin, 0, 0);
+//    (Fl_Callback *)TestDialog::begin, 0, 0);
   menubar->add("F&X/Color/Normalize", 0,
-    (Fl_Callback *)Normalize::begin, 0, 0);
+    (Fl_Callback *)NormalizeDialog::begin, 0, 0);
   menubar->add("F&X/Color/Equalize", 0,
-    (Fl_Callback *)Equalize::begin, 0, 0);
+    (Fl_Callback *)EqualizeDialog::begin, 0, 0);
   menubar->add("F&X/Color/Value Stretch", 0,
-    (Fl_Callback *)ValueStretch::begin, 0, 0);
+    (Fl_Callback *)ValueStretchDialog::begin, 0, 0);
   menubar->add("F&X/Color/Saturate", 0,
-    (Fl_Callback *)Saturate::begin, 0, 0);
+    (Fl_Callback *)SaturateDialog::begin, 0, 0);
   menubar->add("F&X/Color/Rotate Hue...", 0,
-    (Fl_Callback *)RotateHue::begin, 0, 0);
+    (Fl_Callback *)RotateHueDialog::begin, 0, 0);
   menubar->add("F&X/Color/Desaturate", 0,
-    (Fl_Callback *)Desaturate::begin, 0, 0);
+    (Fl_Callback *)DesaturateDialog::begin, 0, 0);
   menubar->add("F&X/Color/Colorize", 0,
-    (Fl_Callback *)Colorize::begin, 0);
+    (Fl_Callback *)ColorizeDialog::begin, 0);
   menubar->add("F&X/Color/Palette Colors", 0,
-   (Fl_Callback *)PaletteColors::begin, 0, 0);
+   (Fl_Callback *)PaletteColorsDialog::begin, 0, 0);
   menubar->add("F&X/Color/Invert", 0,
-    (Fl_Callback *)Invert::begin, 0, 0);
+    (Fl_Callback *)InvertDialog::begin, 0, 0);
 
   menubar->add("F&X/Alpha/Invert", 0,
-    (Fl_Callback *)AlphaInvert::begin, 0, 0);
+    (Fl_Callback *)AlphaInvertDialog::begin, 0, 0);
   menubar->add("F&X/Alpha/Clear", 0,
-    (Fl_Callback *)AlphaClear::begin, 0, 0);
+    (Fl_Callback *)AlphaClearDialog::begin, 0, 0);
   menubar->add("F&X/Alpha/Blend to Paint Color", 0,
-    (Fl_Callback *)AlphaColor::begin, 0, 0);
+    (Fl_Callback *)AlphaColorDialog::begin, 0, 0);
 
   menubar->add("F&X/Filters/Gaussian Blur...", 0,
-    (Fl_Callback *)GaussianBlur::begin, 0, 0);
+    (Fl_Callback *)GaussianBlurDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Sharpen...", 0,
-    (Fl_Callback *)Sharpen::begin, 0, 0);
+    (Fl_Callback *)SharpenDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Unsharp Mask...", 0,
-    (Fl_Callback *)UnsharpMask::begin, 0, 0);
+    (Fl_Callback *)UnsharpMaskDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Box Filters...", 0,
-    (Fl_Callback *)BoxFilters::begin, 0, 0);
+    (Fl_Callback *)BoxFiltersDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Sobel...", 0,
-    (Fl_Callback *)Sobel::begin, 0, 0);
+    (Fl_Callback *)SobelDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Bloom...", 0,
-    (Fl_Callback *)Bloom::begin, 0, 0);
+    (Fl_Callback *)BloomDialog::begin, 0, 0);
   menubar->add("F&X/Filters/Randomize", 0,
-    (Fl_Callback *)Randomize::begin, 0, 0);
+    (Fl_Callback *)RandomizeDialog::begin, 0, 0);
 
   menubar->add("F&X/Photo/Restore...", 0,
-    (Fl_Callback *)Restore::begin, 0, 0);
+    (Fl_Callback *)RestoreDialog::begin, 0, 0);
   menubar->add("F&X/Photo/Side Absorptions", 0,
-    (Fl_Callback *)SideAbsorptions::begin, 0, 0);
+    (Fl_Callback *)SideAbsorptionsDialog::begin, 0, 0);
   menubar->add("F&X/Photo/Remove Dust...", 0,
-    (Fl_Callback *)RemoveDust::begin, 0, 0);
+    (Fl_Callback *)RemoveDustDialog::begin, 0, 0);
 
   menubar->add("F&X/Misc/Stained Glass...", 0,
-    (Fl_Callback *)StainedGlass::begin, 0, 0);
+    (Fl_Callback *)StainedGlassDialog::begin, 0, 0);
   menubar->add("F&X/Misc/Painting...", 0,
-    (Fl_Callback *)Painting::begin, 0, 0);
+    (Fl_Callback *)PaintingDialog::begin, 0, 0);
   menubar->add("F&X/Misc/Marble...", 0,
-    (Fl_Callback *)Marble::begin, 0, 0);
+    (Fl_Callback *)MarbleDialog::begin, 0, 0);
   menubar->add("F&X/Misc/Cube Plot...", 0,
-    (Fl_Callback *)CubePlot::begin, 0, 0);
+    (Fl_Callback *)CubePlotDialog::begin, 0, 0);
 
   menubar->add("&Help/&About...", 0,
     (Fl_Callback *)Dialog::about, 0, 0);
@@ -448,6 +527,11 @@ void Gui::init()
   progress->labelcolor(0xffffff00);
   progress->hide();
 
+  Progress::show_callback = progressShow;
+  Progress::update_callback = progressUpdate;
+  Progress::hide_callback = progressHide;
+  Progress::info_callback = progressInfo;
+
   status->resizable(0);
   status->end();
 
@@ -886,6 +970,7 @@ void Gui::clearToBlack()
   Bitmap *bmp = Project::bmp;
 
   bmp->rectfill(bmp->cl, bmp->ct, bmp->cr, bmp->cb, makeRgb(0, 0, 0), 0);
+  view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
   view->drawMain(true);
 }
 
@@ -902,6 +987,7 @@ void Gui::clearToColor()
     bmp->data[i] = c;
   }
 
+  view->invalidate(0, 0, bmp->w - 1, bmp->h - 1);
   view->drawMain(true);
 }
 
@@ -915,6 +1001,7 @@ void Gui::clearToGray()
     for (int x = bmp->cl; x <= bmp->cr; x++)
       *(bmp->row[y] + x) = 0xff808080;
 
+  view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
   view->drawMain(true);
 }
 
@@ -928,6 +1015,7 @@ void Gui::clearToTrans()
     for (int x = bmp->cl; x <= bmp->cr; x++)
       *(bmp->row[y] + x) = 0x00808080;
 
+  view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
   view->drawMain(true);
 }
 
@@ -938,6 +1026,7 @@ void Gui::clearToWhite()
   Bitmap *bmp = Project::bmp;
 
   bmp->rectfill(bmp->cl, bmp->ct, bmp->cr, bmp->cb, makeRgb(255, 255, 255), 0);
+  view->invalidate(bmp->cl, bmp->ct, bmp->cr, bmp->cb);
   view->drawMain(true);
 }
 
@@ -972,8 +1061,12 @@ void Gui::statusCoords(const char *str)
   coords->redraw();
 }
 
+// status functions do nothing when running without a window
 void Gui::statusInfo(const char *str)
 {
+  if (info == 0)
+    return;
+
   info->copy_label(str);
   info->redraw();
   Fl::check();
@@ -981,11 +1074,17 @@ void Gui::statusInfo(const char *str)
 
 void Gui::saveStatusInfo()
 {
+  if (info == 0)
+    return;
+
   snprintf(status_text, sizeof(status_text), "%s", info->label());
 }
 
 void Gui::restoreStatusInfo()
 {
+  if (info == 0)
+    return;
+
   info->copy_label(status_text);
   info->redraw();
   Fl::check();
@@ -1004,6 +1103,7 @@ void Gui::updateMemInfo()
   char s[256];
 
   double mem = Project::getImageMemory() / 1000000;
+  double spilled = Project::getSpilledMemory() / 1000000;
   double max = Project::mem_max;
 
   bool mem_gb = false;
@@ -1021,14 +1121,23 @@ void Gui::updateMemInfo()
     max_gb = true;
   }
 
-  const int undos =
-    Project::undo_max - Project::undo_list[Project::current]->undo_current - 1;
-  const int redos =
-    Project::undo_max - Project::undo_list[Project::current]->redo_current - 1;
+  const int undos = Project::undo_list[Project::current]->undo_count;
+  const int redos = Project::undo_list[Project::current]->redo_count;
 
-  snprintf(s, sizeof(s), "%.1lf %s / %.1lf %s used\n%d/%d undos, %d redos",
-          mem, mem_gb ? "GB" : "MB", max, max_gb ? "GB" : "MB",
-          undos, Project::undo_max, redos);
+  if (spilled > 0)
+  {
+    snprintf(s, sizeof(s),
+             "%.1lf %s / %.1lf %s used\n%.1lf MB on disk\n"
+             "%d/%d undos, %d redos",
+             mem, mem_gb ? "GB" : "MB", max, max_gb ? "GB" : "MB",
+             spilled, undos, Project::undo_max, redos);
+  }
+    else
+  {
+    snprintf(s, sizeof(s), "%.1lf %s / %.1lf %s used\n%d/%d undos, %d redos",
+            mem, mem_gb ? "GB" : "MB", max, max_gb ? "GB" : "MB",
+            undos, Project::undo_max, redos);
+  }
 
   images->memLabel(s);
 
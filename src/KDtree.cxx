@@ -19,17 +19,37 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
-#include <cstdlib>
-#include <cstdio>
-#include <cstring>
+#include <limits>
+#include <vector>
 
 #include "KDtree.H"
 
 // based on example at https://rosettacode.org/wiki/K-d_tree#C
-// see also https://en.wikipedia.org/wiki/Quickselect
+//
+// the tree is implicit: after build() the median of each range sits in the
+// middle of it, with the lower half to the left and the upper half to the
+// right, split along the axis with the widest spread (so unused dimensions,
+// such as z for 2D points, cost nothing). there are no child pointers, so
+// the points stay packed together and a query walks the array with a small
+// stack instead of recursing
 //
 // currently used for the "fine" airbrush mode, fill edge feathering, and
-// reverse color lookup table
+// the stained glass filter
+
+namespace
+{
+  // ranges this small are searched directly
+  const int LEAF_SIZE = 8;
+
+  // a part of the tree still to be searched, with the distance from the
+  // test point to its region along each axis and in total
+  struct range_type
+  {
+    int begin, end;
+    int offset[3];
+    int bound;
+  };
+}
 
 int KDtree::distance(const node_type *a, const node_type *b)
 {
@@ -44,93 +64,274 @@ int KDtree::distance(const node_type *a, const node_type *b)
   return d;
 }
 
-void KDtree::swapNodes(node_type *a, node_type *b)
+// reorder points into tree order
+void KDtree::build(node_type *points, const int length)
 {
-  node_type temp;
+  build(points, 0, length);
+}
+
+void KDtree::build(node_type *points, const int begin, const int end)
+{
+  if (end - begin <= LEAF_SIZE)
+    return;
+
+  int low[3] = { points[begin].x[0], points[begin].x[1], points[begin].x[2] };
+  int high[3] = { low[0], low[1], low[2] };
+
+  for (int i = begin + 1; i < end; i++)
+  {
+    for (int dim = 0; dim < 3; dim++)
+    {
+      low[dim] = std::min(low[dim], points[i].x[dim]);
+      high[dim] = std::max(high[dim], points[i].x[dim]);
+    }
+  }
+
+  int axis = 0;
+
+  for (int dim = 1; dim < 3; dim++)
+  {
+    if (high[dim] - low[dim] > high[axis] - low[axis])
+      axis = dim;
+  }
+
+  const int mid = begin + (end - begin) / 2;
+
+  std::nth_element(points + begin, points + mid, points + end,
+    [axis](const node_type &a, const node_type &b)
+    {
+      return a.x[axis] < b.x[axis];
+    });
+
+  points[mid].axis = axis;
 
-  temp = *a;
-  *a = *b;
-  *b = temp;
+  build(points, begin, mid);
+  build(points, mid + 1, end);
 }
 
-KDtree::node_type *KDtree::median(node_type *left, node_type *right,
-                                  const int axis)
+// find the point nearest to test_node, returning its position in the array
+// (or -1 if there are no points)
+//
+// if *found is a valid position on entry, that point is used as the
+// starting guess, which prunes most of the tree when it is already close
+// (such as the result for the previous pixel)
+int KDtree::nearest(const node_type *points, const int length,
+                    const node_type *test_node, int *found, int *best_distance)
 {
-  if (right < left)
-    return 0;
+  if (length <= 0)
+  {
+    *found = -1;
+    return -1;
+  }
 
-  node_type *p; 
-  node_type *midpoint = left + (right - left) / 2; 
+  int best = -1;
+  int best_d = 0;
 
-  while (true)
+  if (*found >= 0 && *found < length)
   {
-    const int pivot = midpoint->x[axis];
-    node_type *temp = left;
+    best = *found;
+    best_d = distance(&points[best], test_node);
+  }
 
-    swapNodes(midpoint, right);
+  // enough for 2^31 points, since each level adds at most one far side
+  range_type stack[64];
+  int sp = 0;
 
-    for (p = left; p <= right; p++)
+  stack[sp++] = range_type { 0, length, { 0, 0, 0 }, 0 };
+
+  while (sp > 0 && !(best >= 0 && best_d == 0))
+  {
+    const range_type r = stack[--sp];
+
+    if (r.end <= r.begin || (best >= 0 && r.bound >= best_d))
+      continue;
+
+    if (r.end - r.begin <= LEAF_SIZE)
     {
-      if (p->x[axis] < pivot)
+      for (int i = r.begin; i < r.end; i++)
       {
-        swapNodes(p, temp);
-        temp++;
+        const int d = distance(&points[i], test_node);
+
+        if (best < 0 || d < best_d)
+        {
+          best = i;
+          best_d = d;
+        }
       }
+
+      continue;
+    }
+
+    const int mid = r.begin + (r.end - r.begin) / 2;
+    const node_type *node = &points[mid];
+    const int d = distance(node, test_node);
+
+    if (best < 0 || d < best_d)
+    {
+      best = mid;
+      best_d = d;
     }
 
-    swapNodes(temp, right);
+    const int axis = node->axis;
+    const int dx = node->x[axis] - test_node->x[axis];
+    const int old = r.offset[axis];
+    const int bound = r.bound - old * old + dx * dx;
+
+    range_type near = r;
+    range_type far = r;
+
+    if (dx > 0)
+    {
+      near.end = mid;
+      far.begin = mid + 1;
+    }
+      else
+    {
+      near.begin = mid + 1;
+      far.end = mid;
+    }
 
-    if (midpoint->x[axis] == temp->x[axis])
-      return temp;
-    else if (midpoint->x[axis] < temp->x[axis])
-      right = temp - 1;
-    else
-      left = temp + 1;
+    // far side first, so the near side is searched next
+    if (bound < best_d)
+    {
+      far.offset[axis] = dx;
+      far.bound = bound;
+      stack[sp++] = far;
+    }
+
+    stack[sp++] = near;
   }
+
+  *found = best;
+  *best_distance = best_d;
+
+  return best;
 }
 
-KDtree::node_type *KDtree::build(node_type *root,
-                           const int length, const int axis)
+// nearest point for each pixel from x1 to x2 on row y (at depth z)
+//
+// when there are few points for the width of the row, each column's closest
+// point is found first, and the lower envelope of the parabolas
+// (x - column)^2 + height^2 gives the answer for the whole row in one pass
+// (as in Felzenszwalb and Huttenlocher's distance transform); otherwise
+// each pixel is a tree query, seeded with the result for the pixel before it
+void KDtree::nearestRow(const node_type *points, const int length,
+                        const int x1, const int x2, const int y, const int z,
+                        int *found)
 {
-  if (length == 0)
-    return 0;
+  const int width = x2 - x1 + 1;
 
-  node_type *node = median(root, root + length - 1, axis);
+  if (width < 1)
+    return;
 
-  if (node != 0)
+  if (length <= 0)
   {
-    node->left = build(root, node - root, (axis + 1) % 3);
-    node->right = build(node + 1, root + length - (node + 1), (axis + 1) % 3);
+    std::fill(found, found + width, -1);
+    return;
   }
 
-  return node;
-}
+  int low = points[0].x[0];
+  int high = low;
+
+  for (int i = 1; i < length; i++)
+  {
+    low = std::min(low, points[i].x[0]);
+    high = std::max(high, points[i].x[0]);
+  }
+
+  const int range = high - low + 1;
+
+  if ((long long)length + range > 16LL * width)
+  {
+    node_type test_node;
+    int index = -1;
+    int best_distance;
+
+    test_node.x[1] = y;
+    test_node.x[2] = z;
+
+    for (int x = x1; x <= x2; x++)
+    {
+      test_node.x[0] = x;
+      nearest(points, length, &test_node, &index, &best_distance);
+      found[x - x1] = index;
+    }
 
-void KDtree::nearest(node_type *root, node_type *test_node,
-                     node_type **best_node, int *best_distance, const int axis)
-{
-  if (root == 0)
     return;
+  }
 
-  const int d = distance(root, test_node);
-  const int dx = root->x[axis] - test_node->x[axis];
+  // closest point in each column
+  std::vector<int> column(range, -1);
+  std::vector<int> height(range, 0);
 
-  if ((*best_node == 0) || d < *best_distance)
+  for (int i = 0; i < length; i++)
   {
-    *best_distance = d;
-    *best_node = root;
+    const int q = points[i].x[0] - low;
+    const int dy = points[i].x[1] - y;
+    const int dz = points[i].x[2] - z;
+    const int h = dy * dy + dz * dz;
+
+    if (column[q] < 0 || h < height[q])
+    {
+      column[q] = i;
+      height[q] = h;
+    }
   }
 
-  if (*best_distance == 0)
-    return;
+  // lower envelope, v holds the columns that take part and the parabola
+  // for v[k] is lowest from edge[k] to edge[k + 1]
+  std::vector<int> v(range);
+  std::vector<double> edge(range + 1);
+  int k = -1;
+
+  for (int q = 0; q < range; q++)
+  {
+    if (column[q] < 0)
+      continue;
+
+    const double fq = (double)height[q] + (double)q * q;
+
+    if (k < 0)
+    {
+      k = 0;
+      v[0] = q;
+      edge[0] = -std::numeric_limits<double>::max();
+      edge[1] = std::numeric_limits<double>::max();
+      continue;
+    }
+
+    // where this parabola crosses the one for column r
+    auto cross = [&](const int r)
+    {
+      const double fr = (double)height[r] + (double)r * r;
 
-  nearest(dx > 0 ? root->left : root->right,
-          test_node, best_node, best_distance, (axis + 1) % 3);
+      return (fq - fr) / (2.0 * (q - r));
+    };
 
-  if (*best_distance > dx * dx)
+    double s = cross(v[k]);
+
+    // edge[0] is the lowest value possible, so k never goes below zero
+    while (s <= edge[k])
+    {
+      k--;
+      s = cross(v[k]);
+    }
+
+    k++;
+    v[k] = q;
+    edge[k] = s;
+    edge[k + 1] = std::numeric_limits<double>::max();
+  }
+
+  k = 0;
+
+  for (int x = x1; x <= x2; x++)
   {
-    nearest(dx <= 0 ? root->left : root->right,
-            test_node, best_node, best_distance, (axis + 1) % 3);
+    const double q = x - low;
+
+    while (edge[k + 1] < q)
+      k++;
+
+    found[x - x1] = column[v[k]];
   }
 }
-
@@ -27,7 +27,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 //#include <FL/Fl_Shared_Image.H>
 #include "FL/Fl_File_Icon.H"
 
+#include "Batch.H"
 #include "Blend.H"
+#include "BlendSimd.H"
 #include "Dialog.H"
 #include "Editor.H"
 #include "ExportData.H"
@@ -37,7 +39,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Gamma.H"
 #include "Gui.H"
 #include "Inline.H"
+#include "Progress.H"
 #include "Project.H"
+#include "Threads.H"
 #include "Transform.H"
 #include "Undo.H"
 
@@ -49,6 +53,12 @@ enum
 {
   OPTION_MEM,
   OPTION_UNDOS,
+  OPTION_COMPRESS_UNDOS,
+  OPTION_SPILL_DIR,
+  OPTION_SPILL_MAX,
+  OPTION_BATCH,
+  OPTION_OUTPUT,
+  OPTION_FORMAT,
   OPTION_VERSION,
   OPTION_HELP
 };
@@ -59,6 +69,12 @@ struct option long_options[] =
 {
   { "mem", optional_argument,       &verbose_flag, OPTION_MEM },
   { "undos", optional_argument,       &verbose_flag, OPTION_UNDOS },
+  { "compress-undos", no_argument,       &verbose_flag, OPTION_COMPRESS_UNDOS },
+  { "spill-dir", optional_argument,       &verbose_flag, OPTION_SPILL_DIR },
+  { "spill-max", optional_argument,       &verbose_flag, OPTION_SPILL_MAX },
+  { "batch", optional_argument,       &verbose_flag, OPTION_BATCH },
+  { "output", optional_argument,       &verbose_flag, OPTION_OUTPUT },
+  { "format", optional_argument,       &verbose_flag, OPTION_FORMAT },
   { "version", no_argument,       &verbose_flag, OPTION_VERSION },
   { "help",    no_argument,       &verbose_flag, OPTION_HELP    },
   { 0, 0, 0, 0 }
@@ -109,21 +125,34 @@ void setDarkTheme()
 
 void printHelp()
 {
-  printf("Usage: rendera [OPTIONS] filename\n\n");
+  printf("Usage: rendera [OPTIONS] filename\n");
+  printf("       rendera --batch=<operations> [--output=<dir>] [--format=<type>] files...\n\n");
   printf("--mem=<value>\t\t memory limit (in megabytes)\n");
   printf("--undos=<value>\t\t undo limit (1-100)\n");
+  printf("--compress-undos\t compress undo history in the background\n");
+  printf("--spill-dir=<path>\t keep older undo history in a scratch file\n");
+  printf("--spill-max=<value>\t scratch file limit (in megabytes)\n");
+  printf("--batch=<operations>\t process files without the gui, operations are\n");
+  printf("\t\t\t separated by ';' (or read from a file with @file)\n");
+  printf("--output=<dir>\t\t batch output directory\n");
+  printf("--format=<type>\t\t batch output type: png, jpg[:quality], bmp, tga\n");
   printf("--version\t\t version information\n\n");
+  Batch::printOperations();
 }
 
 int main(int argc, char *argv[])
 {
   //Fl::keyboard_screen_scaling(0);
-  Fl_File_Icon::load_system_icons();
-  setDarkTheme();
 
   // parse command line
   int memory_max = 1000;
   int undo_max = 16;
+  bool undo_compress = false;
+  const char *spill_dir = 0;
+  int spill_max = 4000;
+  const char *batch = 0;
+  const char *output_dir = 0;
+  const char *format = "png";
   int option_index = 0;
   bool exit = false;
   bool custom_settings = false;
@@ -195,6 +224,79 @@ int main(int argc, char *argv[])
             
             break;
 
+          case OPTION_COMPRESS_UNDOS:
+            undo_compress = true;
+            printf("Undo compression enabled\n");
+            break;
+
+          case OPTION_SPILL_DIR:
+            if (optarg)
+            {
+              spill_dir = optarg;
+            }
+              else
+            {
+              printHelp();
+              exit = true;
+            }
+
+            break;
+
+          case OPTION_SPILL_MAX:
+            if (optarg)
+            {
+              spill_max = atoi(optarg);
+
+              if (spill_max < 16)
+                spill_max = 16;
+            }
+              else
+            {
+              printHelp();
+              exit = true;
+            }
+
+            break;
+
+          case OPTION_BATCH:
+            if (optarg)
+            {
+              batch = optarg;
+            }
+              else
+            {
+              printHelp();
+              exit = true;
+            }
+
+            break;
+
+          case OPTION_OUTPUT:
+            if (optarg)
+            {
+              output_dir = optarg;
+            }
+              else
+            {
+              printHelp();
+              exit = true;
+            }
+
+            break;
+
+          case OPTION_FORMAT:
+            if (optarg)
+            {
+              format = optarg;
+            }
+              else
+            {
+              printHelp();
+              exit = true;
+            }
+
+            break;
+
           default:
             printHelp();
             exit = true;
@@ -220,13 +322,41 @@ int main(int argc, char *argv[])
     #endif
   }
 
+  // process files and quit without creating any windows
+  if (batch)
+  {
+    Gamma::init();
+    BlendSimd::init();
+    Threads::init();
+    Progress::enable(false);
+
+    const int failed = Batch::run(batch, output_dir, format,
+                                  argv + optind, argc - optind);
+
+    return failed == 0 ? 0 : 1;
+  }
+
+  Fl_File_Icon::load_system_icons();
+  setDarkTheme();
+
   // fltk related inits
   Fl::visual(FL_DOUBLE | FL_RGB);
   Fl::scheme("gtk+");
 
   // program initalization
   Gamma::init();
+  BlendSimd::init();
+  Threads::init();
   Project::init(memory_max, undo_max);
+  Project::undo_compress = undo_compress;
+
+  if (spill_dir)
+  {
+    if (Undo::initSpill(spill_dir, spill_max))
+      printf("Undo scratch file limit set to: %d MB\n", spill_max);
+    else
+      printf("Could not create undo scratch file in: %s\n", spill_dir);
+  }
   File::init();
   ExportData::init();
   FX::init();
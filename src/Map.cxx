@@ -19,23 +19,90 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
-#include <array>
 #include <cmath>
 #include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <vector>
 
 #include "Gamma.H"
 #include "Inline.H"
 #include "Map.H"
+#include "Threads.H"
 
 namespace
 {
-  // qsort callback for polyfill
-  int node_cmp(const void *a, const void *b)
+  // polygon edge used by the scanline fillers
+  struct edge_type
   {
-    return *(int *)a - *(int *)b;
+    int x1, y1, x2, y2;
+    int top, bottom;
+  };
+
+  // build the edge table, skipping horizontal edges (they never cross
+  // a scanline), and bucket each edge by the first row it is active on
+  // (linked lists through "next" so there is no per-row allocation)
+  void makeEdges(const int *px, const int *py, const int count,
+                 const int first_offset, const int y1, const int y2,
+                 std::vector<edge_type> &edges,
+                 std::vector<int> &head, std::vector<int> &next)
+  {
+    edges.clear();
+    head.assign(y2 - y1 + 1, -1);
+
+    int j = count - 1;
+
+    for (int i = 0; i < count; i++)
+    {
+      if (py[i] != py[j])
+      {
+        const int top = std::min(py[i], py[j]) + first_offset;
+        const int bottom = std::max(py[i], py[j]);
+
+        if (top <= y2 && bottom >= y1 && top <= bottom)
+          edges.push_back(edge_type { px[i], py[i], px[j], py[j], top, bottom });
+      }
+
+      j = i;
+    }
+
+    next.assign(edges.size(), -1);
+
+    for (int i = 0; i < (int)edges.size(); i++)
+    {
+      const int start = std::max(edges[i].top, y1) - y1;
+
+      next[i] = head[start];
+      head[start] = i;
+    }
+  }
+
+  // radius of each of three stacked box blurs that together give about
+  // the same spread as a gaussian (box widths from Wells, "Efficient
+  // Synthesis of Gaussian Filters by Cascaded Uniform Filters")
+  void boxRadius(const float sigma, int *radius)
+  {
+    int wl = std::sqrt(4 * sigma * sigma + 1);
+
+    if ((wl & 1) == 0)
+      wl--;
+
+    const int m = std::round((12 * sigma * sigma - 3 * wl * wl -
+                              12 * wl - 9) / (-4.0f * wl - 4));
+
+    for (int i = 0; i < 3; i++)
+      radius[i] = i < m ? (wl - 1) / 2 : (wl + 1) / 2;
+  }
+
+  // one over how many samples of a box fall inside the row at each
+  // position, so the edges are not darkened
+  void boxNorm(std::vector<float> &norm, const int size, const int r)
+  {
+    norm.resize(size);
+
+    for (int i = 0; i < size; i++)
+      norm[i] = 1.0f / (std::min(i + r, size - 1) - std::max(i - r, 0) + 1);
   }
 }
 
@@ -66,8 +133,13 @@ Map::~Map()
   delete[] data;
 }
 
-bool Map::isEdge(const int x, const int y)
+// skip_border leaves out pixels near the sides of the map, as the fine
+// airbrush always has (including the second to last row and column)
+bool Map::isEdge(const int x, const int y, const bool skip_border)
 {
+  if (skip_border && (x < 1 || x >= w - 2 || y < 1 || y >= h - 2))
+    return false;
+
   if (getpixel(x, y) &&
        (!getpixel(x, y - 1) ||
         !getpixel(x - 1, y) ||
@@ -443,37 +515,180 @@ void Map::vline(int y1, int x, int y2, int c)
   while (y2 >= y1);
 }
 
-void Map::polyfill(int *px, int *py, int count, int y1, int y2, int c)
+// fill the area covered by moving a brush along line(), where the brush is
+// given as one span per row (span_x1[i] to span_x2[i] on row span_y + i)
+void Map::sweep(int x1, int y1, int x2, int y2,
+                const int *span_x1, const int *span_x2,
+                const int span_y, const int span_count, int c)
 {
-  std::array<int, 65536> nodex = {};
+  // the run of pixels line() draws in each row
+  const int top = std::min(y1, y2);
+  const int rows = std::abs(y2 - y1) + 1;
 
-  for (int y = y1; y <= y2; y++)
+  std::vector<int> run_x1(rows, std::numeric_limits<int>::max());
+  std::vector<int> run_x2(rows, std::numeric_limits<int>::min());
+
+  auto plot = [&](const int x, const int y)
   {
-    int nodes = 0;
-    int j = count - 1;
+    run_x1[y - top] = std::min(run_x1[y - top], x);
+    run_x2[y - top] = std::max(run_x2[y - top], x);
+  };
 
-    for (int i = 0; i < count; i++)
+  int dx, dy, inx, iny, e;
+
+  dx = x2 - x1;
+  dy = y2 - y1;
+  inx = dx > 0 ? 1 : -1;
+  iny = dy > 0 ? 1 : -1;
+
+  dx = std::abs(dx);
+  dy = std::abs(dy);
+
+  if (dx >= dy)
+  {
+    dy <<= 1;
+    e = dy - dx;
+    dx <<= 1;
+
+    while (x1 != x2)
     {
-      if ((py[i] < y && py[j] >= y) || (py[j] < y && py[i] >= y))
+      plot(x1, y1);
+
+      if (e >= 0)
       {
-        nodex[nodes] =
-          (px[i] + (float)(y - py[i]) / (py[j] - py[i]) * (px[j] - px[i]));
+        y1 += iny;
+        e -= dx;
+      }
+
+      e += dy;
+      x1 += inx;
+    }
+  }
+    else
+  {
+    dx <<= 1;
+    e = dx - dy;
+    dy <<= 1;
 
-        nodes++;
+    while (y1 != y2)
+    {
+      plot(x1, y1);
 
-        if (nodes >= (signed)nodex.size())
-          break;
+      if (e >= 0)
+      {
+        x1 += inx;
+        e -= dy;
       }
 
-      j = i;
+      e += dx;
+      y1 += iny;
+    }
+  }
+
+  plot(x1, y1);
+
+  // each output row is the union of the brush rows placed along the runs
+  const int first = std::max(top + span_y, 0);
+  const int last = std::min(top + rows - 1 + span_y + span_count - 1, h - 1);
+
+  std::vector<std::pair<int, int>> spans;
+
+  for (int y = first; y <= last; y++)
+  {
+    const int i1 = std::max(y - span_y - (top + rows - 1), 0);
+    const int i2 = std::min(y - span_y - top, span_count - 1);
+
+    spans.clear();
+
+    for (int i = i1; i <= i2; i++)
+    {
+      const int ly = y - span_y - i - top;
+
+      spans.push_back(std::make_pair(run_x1[ly] + span_x1[i],
+                                     run_x2[ly] + span_x2[i]));
     }
 
-    std::qsort(&nodex[0], nodes, sizeof(int), node_cmp);
+    if (spans.empty())
+      continue;
 
-    for (int i = 0; i < nodes; i += 2)
+    std::sort(spans.begin(), spans.end());
+
+    int sx1 = spans[0].first;
+    int sx2 = spans[0].second;
+
+    for (int i = 1; i < (int)spans.size(); i++)
     {
-      for (int x = nodex[i]; x < nodex[i + 1]; x++)
-        setpixel(x + 1, y, c);
+      if (spans[i].first > sx2 + 1)
+      {
+        hline(sx1, y, sx2, c);
+        sx1 = spans[i].first;
+      }
+
+      sx2 = std::max(sx2, spans[i].second);
+    }
+
+    hline(sx1, y, sx2, c);
+  }
+}
+
+// scanline polygon fill (even-odd rule) using an edge table and an
+// active edge list, so each row only looks at the edges crossing it
+void Map::polyfill(int *px, int *py, int count, int y1, int y2, int c)
+{
+  if (count < 3)
+    return;
+
+  y1 = std::max(y1, 0);
+  y2 = std::min(y2, h - 1);
+
+  if (y1 > y2)
+    return;
+
+  std::vector<edge_type> edges;
+  std::vector<int> head;
+  std::vector<int> next;
+
+  // an edge crosses row y when its upper end is above y and
+  // its lower end is on or below it
+  makeEdges(px, py, count, 1, y1, y2, edges, head, next);
+
+  if (edges.empty())
+    return;
+
+  // active edges, kept sorted by crossing from the previous row
+  // so insertion sort stays close to linear
+  std::vector<std::pair<int, int>> active;
+
+  for (int y = y1; y <= y2; y++)
+  {
+    int count_active = 0;
+
+    for (int i = 0; i < (int)active.size(); i++)
+    {
+      if (edges[active[i].second].bottom >= y)
+        active[count_active++] = active[i];
+    }
+
+    active.resize(count_active);
+
+    for (int i = head[y - y1]; i != -1; i = next[i])
+      active.push_back(std::make_pair(0, i));
+
+    for (int i = 0; i < (int)active.size(); i++)
+    {
+      const edge_type &e = edges[active[i].second];
+
+      active[i].first =
+        (e.x1 + (float)(y - e.y1) / (e.y2 - e.y1) * (e.x2 - e.x1));
+
+      for (int k = i; k > 0 && active[k - 1].first > active[k].first; k--)
+        std::swap(active[k - 1], active[k]);
+    }
+
+    for (int i = 0; i + 1 < (int)active.size(); i += 2)
+    {
+      if (active[i].first < active[i + 1].first)
+        hline(active[i].first + 1, y, active[i + 1].first, c);
     }
   }
 }
@@ -491,15 +706,10 @@ void Map::blendAA(int x, int y, int c2)
   *(row[y] + x) = c1;
 }
 
-// draw antialiased pixel
-// each real pixel is treated like 4x4 virtual pixels
-void Map::setpixelAA(int x, int y, int c)
+// how much of an antialiased pixel goes to each of the four real pixels
+// under it (top-left, top-right, bottom-left, bottom-right)
+void Map::weightAA(int x, int y, int *weight)
 {
-  if (c == 0 ||
-    x < 0 || x >= ((w - 1) << 2) ||
-    y < 0 || y >= ((h - 1) << 2))
-    return;
-
   int shift1 = 4;
   int shift2 = 20;
 
@@ -517,13 +727,33 @@ void Map::setpixelAA(int x, int y, int c)
   const int v16 = 16 - v;
   const int a = (u16 | (u << 8)) * (v16 | (v16 << 8));
   const int b = (u16 | (u << 8)) * (v | (v << 8));
+
+  weight[0] = (a & 0x000001ff) >> shift1;
+  weight[1] = (a & 0x01ff0000) >> shift2;
+  weight[2] = (b & 0x000001ff) >> shift1;
+  weight[3] = (b & 0x01ff0000) >> shift2;
+}
+
+// draw antialiased pixel
+// each real pixel is treated like 4x4 virtual pixels
+void Map::setpixelAA(int x, int y, int c)
+{
+  if (c == 0 ||
+    x < 0 || x >= ((w - 1) << 2) ||
+    y < 0 || y >= ((h - 1) << 2))
+    return;
+
+  int weight[4];
+
+  weightAA(x, y, weight);
+
   const int xx = (x >> 2);
   const int yy = (y >> 2);
 
-  blendAA(xx, yy, (a & 0x000001ff) >> shift1);
-  blendAA(xx + 1, yy, (a & 0x01ff0000) >> shift2);
-  blendAA(xx, yy + 1, (b & 0x000001ff) >> shift1);
-  blendAA(xx + 1, yy + 1, (b & 0x01ff0000) >> shift2);
+  blendAA(xx, yy, weight[0]);
+  blendAA(xx + 1, yy, weight[1]);
+  blendAA(xx, yy + 1, weight[2]);
+  blendAA(xx + 1, yy + 1, weight[3]);
 }
 
 // draw horizontal antialised line (used by filled oval/rectangle)
@@ -592,6 +822,173 @@ void Map::lineAA(int x1, int y1, int x2, int y2, int c)
   }
 }
 
+// antialiased version of sweep(), gives the same result as calling lineAA()
+// from every pixel of the brush: the weights lineAA() would add are summed
+// per pixel first, then spread over each brush row with running sums
+void Map::sweepAA(int x1, int y1, int x2, int y2,
+                  const int *span_x1, const int *span_x2,
+                  const int span_y, const int span_count, int c)
+{
+  if (c == 0 || span_count < 1)
+    return;
+
+  struct cell_type
+  {
+    int x, y;
+    int weight[4];
+  };
+
+  // the walk only moves one way, so points in a cell are consecutive
+  std::vector<cell_type> cells;
+
+  auto plot = [&](const int x, const int y)
+  {
+    const int xx = x >> 2;
+    const int yy = y >> 2;
+
+    if (cells.empty() || cells.back().x != xx || cells.back().y != yy)
+      cells.push_back(cell_type { xx, yy, { 0, 0, 0, 0 } });
+
+    int weight[4];
+
+    weightAA(x, y, weight);
+
+    for (int i = 0; i < 4; i++)
+      cells.back().weight[i] += weight[i];
+  };
+
+  x1 <<= 2;
+  y1 <<= 2;
+  x2 <<= 2;
+  y2 <<= 2;
+
+  int dx, dy, inx, iny, e;
+
+  dx = x2 - x1;
+  dy = y2 - y1;
+  inx = dx > 0 ? 1 : -1;
+  iny = dy > 0 ? 1 : -1;
+
+  dx = std::abs(dx);
+  dy = std::abs(dy);
+
+  if (dx >= dy)
+  {
+    dy <<= 1;
+    e = dy - dx;
+    dx <<= 1;
+
+    while (x1 != x2)
+    {
+      plot(x1, y1);
+
+      if (e >= 0)
+      {
+        y1 += iny;
+        e -= dx;
+      }
+
+      e += dy;
+      x1 += inx;
+    }
+  }
+    else
+  {
+    dx <<= 1;
+    e = dx - dy;
+    dy <<= 1;
+
+    while (y1 != y2)
+    {
+      plot(x1, y1);
+
+      if (e >= 0)
+      {
+        x1 += inx;
+        e -= dy;
+      }
+
+      e += dx;
+      y1 += iny;
+    }
+  }
+
+  if (cells.empty())
+    return;
+
+  // area that can be touched
+  int cx1 = cells[0].x, cy1 = cells[0].y;
+  int cx2 = cx1, cy2 = cy1;
+
+  for (const cell_type &cell : cells)
+  {
+    cx1 = std::min(cx1, cell.x);
+    cy1 = std::min(cy1, cell.y);
+    cx2 = std::max(cx2, cell.x);
+    cy2 = std::max(cy2, cell.y);
+  }
+
+  const int bx1 = *std::min_element(span_x1, span_x1 + span_count);
+  const int bx2 = *std::max_element(span_x2, span_x2 + span_count);
+
+  const int rx1 = std::max(cx1 + bx1, 0);
+  const int ry1 = std::max(cy1 + span_y, 0);
+  const int rx2 = std::min(cx2 + bx2 + 1, w - 1);
+  const int ry2 = std::min(cy2 + span_y + span_count, h - 1);
+
+  if (rx1 > rx2 || ry1 > ry2)
+    return;
+
+  const int rw = rx2 - rx1 + 2;
+  std::vector<int> diff(rw * (ry2 - ry1 + 1), 0);
+
+  // setpixelAA() only draws when the top-left pixel of the four is
+  // inside (0, 0) - (w - 2, h - 2), so brush rows are clipped to that
+  for (const cell_type &cell : cells)
+  {
+    for (int i = 0; i < span_count; i++)
+    {
+      const int ty = cell.y + span_y + i;
+
+      if (ty < 0 || ty > h - 2)
+        continue;
+
+      const int tx1 = std::max(cell.x + span_x1[i], 0);
+      const int tx2 = std::min(cell.x + span_x2[i], w - 2);
+
+      if (tx1 > tx2)
+        continue;
+
+      for (int j = 0; j < 2; j++)
+      {
+        const int d = (ty + j - ry1) * rw - rx1;
+
+        diff[d + tx1] += cell.weight[j * 2];
+        diff[d + tx2 + 1] -= cell.weight[j * 2];
+        diff[d + tx1 + 1] += cell.weight[j * 2 + 1];
+        diff[d + tx2 + 2] -= cell.weight[j * 2 + 1];
+      }
+    }
+  }
+
+  for (int y = ry1; y <= ry2; y++)
+  {
+    const int *d = &diff[(y - ry1) * rw];
+    unsigned char *p = row[y] + rx1;
+    int sum = 0;
+
+    for (int x = rx1; x <= rx2; x++)
+    {
+      sum += *d++;
+
+      if (sum > 0)
+        *p = std::min(*p + sum, 255);
+
+      p++;
+    }
+  }
+}
+
 void Map::ovalAA(int x1, int y1, int x2, int y2, int c)
 {
   x1 <<= 2;
@@ -796,46 +1193,164 @@ void Map::rectfillAA(int x1, int y1, int x2, int y2, int c)
     hlineAA(x1, y1, x2, c);
 }
 
+// antialiased scanline polygon fill
+// each edge adds its exact signed area to a row accumulator (only the
+// cells it passes through), then a running sum gives the coverage of
+// every pixel in the row, which is folded to match the even-odd rule
+// of polyfill(); pixel centers lie on the integer coordinates
 void Map::polyfillAA(int *px, int *py, int count, int y1, int y2, int c)
 {
-  for (int i = 0; i < count; i++)
+  if (count < 3 || c == 0)
+    return;
+
+  y1 = std::max(y1, 0);
+  y2 = std::min(y2, h - 1);
+
+  if (y1 > y2)
+    return;
+
+  std::vector<edge_type> edges;
+  std::vector<int> head;
+  std::vector<int> next;
+
+  // with the half-pixel offset an edge touches rows top to bottom
+  makeEdges(px, py, count, 0, y1, y2, edges, head, next);
+
+  if (edges.empty())
+    return;
+
+  int bx1 = edges[0].x1;
+  int bx2 = bx1;
+
+  for (const edge_type &e : edges)
   {
-    px[i] <<= 2;
-    py[i] <<= 2;
+    bx1 = std::min(bx1, std::min(e.x1, e.x2));
+    bx2 = std::max(bx2, std::max(e.x1, e.x2));
   }
 
-  std::array<int, 65536> nodex = {};
+  // accumulator covers the polygon bounds, indexed from bx1
+  std::vector<float> acc(bx2 - bx1 + 3, 0.0f);
+  std::vector<int> active;
 
-  for (int y = (y1 << 2); y <= (y2 << 2); y++)
+  for (int y = y1; y <= y2; y++)
   {
-    int j = count - 1;
-    int nodes = 0;
+    int count_active = 0;
 
-    for (int i = 0; i < count; i++)
+    for (int i = 0; i < (int)active.size(); i++)
     {
-      if ((py[i] < y && py[j] >= y) || (py[j] < y && py[i] >= y))
-      {
-        nodex[nodes] =
-          (px[i] + (double)(y - py[i]) / (py[j] - py[i]) * (px[j] - px[i]));
+      if (edges[active[i]].bottom >= y)
+        active[count_active++] = active[i];
+    }
+
+    active.resize(count_active);
+
+    for (int i = head[y - y1]; i != -1; i = next[i])
+      active.push_back(i);
 
-        nodes++;
+    if (active.empty())
+      continue;
 
-        if (nodes >= (signed)nodex.size())
-          break;
+    int ax1 = (int)acc.size();
+    int ax2 = 0;
+
+    for (const int i : active)
+    {
+      const edge_type &e = edges[i];
+
+      // part of the edge inside this row, with row top at 0
+      const float dir = e.y2 > e.y1 ? 1.0f : -1.0f;
+      const float ex1 = e.x1 - bx1 + 0.5f;
+      const float ey1 = e.y1 - y + 0.5f;
+      const float dxdy = (float)(e.x2 - e.x1) / (e.y2 - e.y1);
+      const float ya = std::max(std::min(ey1, e.y2 - y + 0.5f), 0.0f);
+      const float yb = std::min(std::max(ey1, e.y2 - y + 0.5f), 1.0f);
+
+      if (ya >= yb)
+        continue;
+
+      const float xa = ex1 + (ya - ey1) * dxdy;
+      const float xb = ex1 + (yb - ey1) * dxdy;
+      const float d = (yb - ya) * dir;
+      const float x0 = std::min(xa, xb);
+      const float x1 = std::max(xa, xb);
+      const int x0i = (int)std::floor(x0);
+      const int x1i = (int)std::ceil(x1);
+
+      ax1 = std::min(ax1, x0i);
+
+      if (x1i <= x0i + 1)
+      {
+        // stays inside one cell
+        const float xm = 0.5f * (xa + xb) - x0i;
+
+        acc[x0i] += d - d * xm;
+        acc[x0i + 1] += d * xm;
+        ax2 = std::max(ax2, x0i + 1);
       }
+        else
+      {
+        // spread the trapezoid over the cells it passes through
+        const float s = 1.0f / (x1 - x0);
+        const float x0f = x0 - x0i;
+        const float a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+        const float x1f = x1 - x1i + 1.0f;
+        const float am = 0.5f * s * x1f * x1f;
 
-      j = i;
+        acc[x0i] += d * a0;
+
+        if (x1i == x0i + 2)
+        {
+          acc[x0i + 1] += d * (1.0f - a0 - am);
+        }
+          else
+        {
+          const float a1 = s * (1.5f - x0f);
+
+          acc[x0i + 1] += d * (a1 - a0);
+
+          for (int x = x0i + 2; x < x1i - 1; x++)
+            acc[x] += d * s;
+
+          const float a2 = a1 + (x1i - x0i - 3) * s;
+
+          acc[x1i - 1] += d * (1.0f - a2 - am);
+        }
+
+        acc[x1i] += d * am;
+        ax2 = std::max(ax2, x1i);
+      }
     }
 
-    std::qsort(&nodex[0], nodes, sizeof(int), node_cmp);
+    if (ax1 > ax2)
+      continue;
 
-    for (int i = 0; i < nodes; i += 2)
+    unsigned char *p = row[y];
+    float sum = 0;
+
+    for (int i = ax1; i <= ax2; i++)
     {
-      for (int x = nodex[i]; x <= nodex[i + 1]; x++)
-        setpixelAA(x, y, c);
+      sum += acc[i];
+      acc[i] = 0;
+
+      const int x = i + bx1;
+
+      if (x < 0 || x >= w)
+        continue;
+
+      // fold winding into 0-1 for the even-odd rule
+      float cover = std::fabs(sum);
+
+      cover -= 2.0f * (int)(cover * 0.5f);
+
+      if (cover > 1.0f)
+        cover = 2.0f - cover;
+
+      const int value = p[x] + (int)(cover * c + 0.5f);
+
+      p[x] = value > 255 ? 255 : value;
     }
   }
-} 
+}
 
 void Map::shrinkBlock(unsigned char *s0, unsigned char *s1,
                       unsigned char *s2, unsigned char *s3)
@@ -924,6 +1439,140 @@ void Map::grow(const int offset)
   }
 }
 
+// number of alternating shrink passes (as done by the coarse airbrush)
+// it takes to clear each pixel in the area, -1 if still set after all
+// of them; each pass only revisits the blocks around pixels that changed
+// in the previous two, so the whole thing is linear in the area, and the
+// map ends up exactly as if every pass had gone over all blocks
+// returns false if the first pass finds nothing (nothing more is done)
+bool Map::shrinkDepth(std::vector<int> &depth, int x1, int y1,
+                      int x2, int y2, const int passes)
+{
+  if (x1 > x2)
+    std::swap(x1, x2);
+  if (y1 > y2)
+    std::swap(y1, y2);
+
+  const int dw = x2 - x1 + 1;
+  const int dh = y2 - y1 + 1;
+
+  depth.assign(dw * dh, -1);
+
+  // blocks for each grid offset
+  int bw[2], bh[2];
+
+  for (int a = 0; a < 2; a++)
+  {
+    bw[a] = std::max((dw - a) / 2, 0);
+    bh[a] = std::max((dh - a) / 2, 0);
+  }
+
+  // pass each block was last queued for, and queues for the next two
+  std::vector<int> queued[2];
+  std::vector<int> queue[3];
+
+  for (int a = 0; a < 2; a++)
+    queued[a].assign(bw[a] * bh[a], -1);
+
+  // a changed pixel can change the block over it in the next pass,
+  // and the block it was in again the pass after that
+  auto requeue = [&](const int x, const int y, const int pass)
+  {
+    for (int k = 1; k <= 2; k++)
+    {
+      const int a = (pass + k) & 1;
+      const int bx = (x - a) >> 1;
+      const int by = (y - a) >> 1;
+
+      if (bx < 0 || bx >= bw[a] || by < 0 || by >= bh[a])
+        continue;
+
+      const int i = by * bw[a] + bx;
+
+      if (queued[a][i] != pass + k)
+      {
+        queued[a][i] = pass + k;
+        queue[(pass + k) % 3].push_back(i);
+      }
+    }
+  };
+
+  bool found = false;
+
+  for (int pass = 0; pass < passes; pass++)
+  {
+    const int a = pass & 1;
+    std::vector<int> &blocks = queue[pass % 3];
+
+    // nothing is known about the map until both grids have been seen
+    if (pass < 2)
+    {
+      blocks.resize(bw[a] * bh[a]);
+
+      for (int i = 0; i < (int)blocks.size(); i++)
+        blocks[i] = i;
+    }
+
+    for (const int i : blocks)
+    {
+      const int x = ((i % bw[a]) << 1) + a;
+      const int y = ((i / bw[a]) << 1) + a;
+
+      unsigned char *s0 = row[y + y1] + x + x1;
+      unsigned char *s1 = s0 + 1;
+      unsigned char *s2 = row[y + y1 + 1] + x + x1;
+      unsigned char *s3 = s2 + 1;
+
+      *s0 &= 1;
+      *s1 &= 1;
+      *s2 &= 1;
+      *s3 &= 1;
+
+      const unsigned char d0 = *s0;
+      const unsigned char d1 = *s1;
+      const unsigned char d2 = *s2;
+      const unsigned char d3 = *s3;
+
+      if (!(d0 | d1 | d2 | d3))
+        continue;
+
+      found = true;
+      shrinkBlock(s0, s1, s2, s3);
+
+      if (!*s0 && d0)
+      {
+        depth[y * dw + x] = pass;
+        requeue(x, y, pass);
+      }
+
+      if (!*s1 && d1)
+      {
+        depth[y * dw + x + 1] = pass;
+        requeue(x + 1, y, pass);
+      }
+
+      if (!*s2 && d2)
+      {
+        depth[(y + 1) * dw + x] = pass;
+        requeue(x, y + 1, pass);
+      }
+
+      if (!*s3 && d3)
+      {
+        depth[(y + 1) * dw + x + 1] = pass;
+        requeue(x + 1, y + 1, pass);
+      }
+    }
+
+    blocks.clear();
+
+    if (!found)
+      return false;
+  }
+
+  return true;
+}
+
 void Map::dilate(const int amount)
 {
   for (int z = 0; z < amount; z++)
@@ -972,63 +1621,264 @@ void Map::dilate(const int amount)
 
 void Map::blur(int radius)
 {
-  radius = (radius + 1) * 2;
+  // the old kernel was cut off at two deviations, which narrows it
+  blur(0, 0, w - 1, h - 1, (radius + 1) * 0.44f);
+}
+
+// gaussian blur of an area, approximated by three box blurs in each
+// direction so the cost doesn't depend on the radius; values keep four
+// extra bits between passes, and samples outside the area are left out
+void Map::blur(int x1, int y1, int x2, int y2, const float sigma)
+{
+  if (x1 > x2)
+    std::swap(x1, x2);
+  if (y1 > y2)
+    std::swap(y1, y2);
+
+  x1 = std::max(x1, 0);
+  y1 = std::max(y1, 0);
+  x2 = std::min(x2, w - 1);
+  y2 = std::min(y2, h - 1);
+
+  if (x1 > x2 || y1 > y2 || sigma <= 0)
+    return;
+
+  const int dw = x2 - x1 + 1;
+  const int dh = y2 - y1 + 1;
+
+  int radius[3];
+
+  boxRadius(sigma, radius);
 
-  Map temp(w, h);
-  temp.clear(0);
+  const int rmax = *std::max_element(radius, radius + 3);
 
-  std::vector<int> kernel(radius);
-  int div = 0;
-  int b = radius / 2;
+  std::vector<float> norm_x[3];
+  std::vector<float> norm_y[3];
 
-  for (int x = 0; x < radius; x++)
+  for (int i = 0; i < 3; i++)
   {
-    kernel[x] = 255 * std::exp(-((double)((x - b) * (x - b)) / ((b * b) / 2)));
-    div += kernel[x];
+    boxNorm(norm_x[i], dw, radius[i]);
+    boxNorm(norm_y[i], dh, radius[i]);
   }
 
-  // x direction
-  for (int y = 0; y < h; y++)
+  std::vector<int> buf(dw * dh);
+  std::vector<int> temp(dw * dh);
+
+  // x direction, the row is padded with zeros so the running sum
+  // needs no bounds checks
+  Threads::run(0, dh - 1, [&](int y)
   {
-    const int y1 = y;
+    const unsigned char *p = row[y + y1] + x1;
+    int *b = &buf[y * dw];
+    std::vector<int> pad(dw + rmax * 2, 0);
+
+    for (int x = 0; x < dw; x++)
+      b[x] = p[x] << 4;
 
-    for (int x = 0; x < w; x++)
+    for (int i = 0; i < 3; i++)
     {
-      int xx = x - radius / 2;
-      int val = 0;
+      const int r = radius[i];
+      const float *norm = &norm_x[i][0];
+
+      std::copy(b, b + dw, pad.begin() + rmax);
+
+      const int *s = &pad[rmax];
+      int sum = 0;
 
-      for (int i = 0; i < radius; i++)
+      for (int x = -r; x < r; x++)
+        sum += s[x];
+
+      for (int x = 0; x < dw; x++)
       {
-        if (xx >= 0 && xx < w)
-          val += *(row[y1] + xx) * kernel[i];
+        sum += s[x + r];
+        b[x] = sum * norm[x] + 0.5f;
+        sum -= s[x - r];
+      }
+    }
+  });
 
-        xx++;
+  // y direction, a whole row at a time over strips of columns
+  const int strip = 256;
+
+  Threads::run(0, (dw - 1) / strip, [&](int n)
+  {
+    const int sx1 = n * strip;
+    const int sw = std::min(dw - sx1, strip);
+    std::vector<int> sum(sw);
+    int *src = &buf[sx1];
+    int *dest = &temp[sx1];
+
+    for (int i = 0; i < 3; i++)
+    {
+      const int r = radius[i];
+
+      std::fill(sum.begin(), sum.end(), 0);
+
+      for (int y = 0; y < std::min(r, dh); y++)
+      {
+        const int *s = src + y * dw;
+
+        for (int x = 0; x < sw; x++)
+          sum[x] += s[x];
       }
 
-      val /= div;
-      temp.setpixel(x, y, val);
+      for (int y = 0; y < dh; y++)
+      {
+        if (y + r < dh)
+        {
+          const int *s = src + (y + r) * dw;
+
+          for (int x = 0; x < sw; x++)
+            sum[x] += s[x];
+        }
+
+        const float norm = norm_y[i][y];
+        int *d = dest + y * dw;
+
+        for (int x = 0; x < sw; x++)
+          d[x] = sum[x] * norm + 0.5f;
+
+        if (y - r >= 0)
+        {
+          const int *s = src + (y - r) * dw;
+
+          for (int x = 0; x < sw; x++)
+            sum[x] -= s[x];
+        }
+      }
+
+      std::swap(src, dest);
+    }
+
+    for (int y = 0; y < dh; y++)
+    {
+      const int *s = src + y * dw;
+      unsigned char *p = row[y + y1] + x1 + sx1;
+
+      for (int x = 0; x < sw; x++)
+        p[x] = std::min((s[x] + 8) >> 4, 255);
+    }
+  });
+}
+
+
+// exact euclidean distance transform, see:
+// Felzenszwalb & Huttenlocher, "Distance Transforms of Sampled Functions"
+//
+// fills dist with the squared distance from each pixel in the rectangle
+// x1, y1, x2, y2 to the nearest edge pixel inside it (a set pixel with an
+// unset or off-map neighbor, as in isEdge), one row after another, or -1
+// if there are no edges; skip_border is passed on to isEdge
+//
+// the distance down each column is found first, then the lower envelope
+// of the parabolas (x - q)^2 + column[q]^2 gives the distance along each
+// row, so the whole rectangle takes linear time
+void Map::distance(std::vector<int> &dist, int x1, int y1, int x2, int y2,
+                   const bool skip_border)
+{
+  if (x1 > x2)
+    std::swap(x1, x2);
+  if (y1 > y2)
+    std::swap(y1, y2);
+
+  const int dw = x2 - x1 + 1;
+  const int dh = y2 - y1 + 1;
+
+  dist.resize(dw * dh);
+
+  const int far = dw + dh + 1;
+
+  // distance to the nearest edge above...
+  for (int y = y1; y <= y2; y++)
+  {
+    int *d = &dist[(y - y1) * dw];
+
+    for (int x = x1; x <= x2; x++)
+    {
+      if (isEdge(x, y, skip_border))
+        d[x - x1] = 0;
+      else if (y == y1)
+        d[x - x1] = far;
+      else
+        d[x - x1] = std::min(d[x - x1 - dw] + 1, far);
     }
   }
 
-  // y direction
-  for (int y = 0; y < h; y++)
+  // ...or below
+  for (int y = dh - 2; y >= 0; y--)
   {
-    for (int x = 0; x < w; x++)
+    int *d = &dist[y * dw];
+
+    for (int x = 0; x < dw; x++)
+      d[x] = std::min(d[x], d[x + dw] + 1);
+  }
+
+  Threads::run(0, dh - 1, [&](int y)
+  {
+    int *d = &dist[y * dw];
+    std::vector<int> column(d, d + dw);
+    std::vector<int> v(dw);
+    std::vector<double> edge(dw + 1);
+    int k = -1;
+
+    for (int q = 0; q < dw; q++)
     {
-      int yy = y - radius / 2;
-      int val = 0;
+      if (column[q] >= far)
+        continue;
 
-      for (int i = 0; i < radius; i++)
+      const double fq = (double)column[q] * column[q] + (double)q * q;
+
+      if (k < 0)
+      {
+        k = 0;
+        v[0] = q;
+        edge[0] = -std::numeric_limits<double>::max();
+        edge[1] = std::numeric_limits<double>::max();
+        continue;
+      }
+
+      // where this parabola crosses the one for column r
+      auto cross = [&](const int r)
       {
-        if (yy >= 0 && yy < h)
-          val += *(temp.row[yy] + x) * kernel[i];
+        const double fr = (double)column[r] * column[r] + (double)r * r;
+
+        return (fq - fr) / (2.0 * (q - r));
+      };
+
+      double s = cross(v[k]);
 
-        yy++;
+      // edge[0] is the lowest value possible, so k never goes below zero
+      while (s <= edge[k])
+      {
+        k--;
+        s = cross(v[k]);
       }
 
-      val /= div;
-      setpixel(x, y, val);
+      k++;
+      v[k] = q;
+      edge[k] = s;
+      edge[k + 1] = std::numeric_limits<double>::max();
+    }
+
+    // no edge in this row (sized from the copy so gcc can see the length
+    // is never negative)
+    if (k < 0)
+    {
+      std::fill(d, d + column.size(), -1);
+      return;
     }
-  }
-}
 
+    k = 0;
+
+    for (int x = 0; x < dw; x++)
+    {
+      while (edge[k + 1] < x)
+        k++;
+
+      const int dx = x - v[k];
+      const int dy = column[v[k]];
+
+      d[x] = dx * dx + dy * dy;
+    }
+  });
+}
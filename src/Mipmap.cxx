@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <algorithm>
+
+#include "Bitmap.H"
+#include "Gamma.H"
+#include "Inline.H"
+#include "Mipmap.H"
+#include "Threads.H"
+
+Mipmap::Mipmap()
+{
+  source = 0;
+  source_w = 0;
+  source_h = 0;
+
+  for (int i = 0; i <= MAX_LEVELS; i++)
+  {
+    levels[i] = 0;
+    dirty[i] = false;
+  }
+}
+
+Mipmap::~Mipmap()
+{
+  for (int i = 0; i <= MAX_LEVELS; i++)
+    delete levels[i];
+}
+
+// returns the image reduced by 2 to the power of level
+Bitmap *Mipmap::getLevel(const Bitmap *bmp, const int level)
+{
+  if (bmp != source || bmp->w != source_w || bmp->h != source_h)
+    reset(bmp);
+
+  for (int i = 1; i <= level; i++)
+    update(i);
+
+  return levels[level];
+}
+
+// marks part of the source image as changed
+void Mipmap::invalidate(int x1, int y1, int x2, int y2)
+{
+  if (x1 > x2)
+    std::swap(x1, x2);
+
+  if (y1 > y2)
+    std::swap(y1, y2);
+
+  for (int i = 1; i <= MAX_LEVELS; i++)
+  {
+    if (dirty[i] == false)
+    {
+      dirty_x1[i] = x1;
+      dirty_y1[i] = y1;
+      dirty_x2[i] = x2;
+      dirty_y2[i] = y2;
+      dirty[i] = true;
+    }
+      else
+    {
+      dirty_x1[i] = std::min(dirty_x1[i], x1);
+      dirty_y1[i] = std::min(dirty_y1[i], y1);
+      dirty_x2[i] = std::max(dirty_x2[i], x2);
+      dirty_y2[i] = std::max(dirty_y2[i], y2);
+    }
+  }
+}
+
+void Mipmap::invalidateAll()
+{
+  invalidate(0, 0, source_w - 1, source_h - 1);
+}
+
+void Mipmap::reset(const Bitmap *bmp)
+{
+  source = bmp;
+  source_w = bmp->w;
+  source_h = bmp->h;
+
+  int w = source_w;
+  int h = source_h;
+
+  for (int i = 1; i <= MAX_LEVELS; i++)
+  {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+
+    delete levels[i];
+    levels[i] = new Bitmap(w, h);
+  }
+
+  invalidateAll();
+}
+
+// rebuilds the changed part of a level from the one above it,
+// averaging 2x2 blocks in linear light and weighting color by alpha
+void Mipmap::update(const int level)
+{
+  if (dirty[level] == false)
+    return;
+
+  dirty[level] = false;
+
+  const Bitmap *src = level == 1 ? source : levels[level - 1];
+  Bitmap *dest = levels[level];
+
+  const int x1 = std::max(dirty_x1[level] >> level, 0);
+  const int y1 = std::max(dirty_y1[level] >> level, 0);
+  const int x2 = std::min(dirty_x2[level] >> level, dest->w - 1);
+  const int y2 = std::min(dirty_y2[level] >> level, dest->h - 1);
+
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  auto row = [&](const int y)
+  {
+    const int sy1 = y * 2;
+    const int sy2 = std::min(sy1 + 1, src->h - 1);
+    int *d = dest->row[y] + x1;
+
+    for (int x = x1; x <= x2; x++)
+    {
+      const int sx1 = x * 2;
+      const int sx2 = std::min(sx1 + 1, src->w - 1);
+
+      const int c[4] =
+      {
+        src->row[sy1][sx1], src->row[sy1][sx2],
+        src->row[sy2][sx1], src->row[sy2][sx2]
+      };
+
+      int r = 0;
+      int g = 0;
+      int b = 0;
+      int a = 0;
+
+      for (int i = 0; i < 4; i++)
+      {
+        const rgba_type rgba = getRgba(c[i]);
+
+        r += Gamma::fix(rgba.r) * rgba.a;
+        g += Gamma::fix(rgba.g) * rgba.a;
+        b += Gamma::fix(rgba.b) * rgba.a;
+        a += rgba.a;
+      }
+
+      if (a == 0)
+      {
+        *d++ = 0;
+        continue;
+      }
+
+      *d++ = makeRgba(Gamma::unfix(r / a), Gamma::unfix(g / a),
+                      Gamma::unfix(b / a), a / 4);
+    }
+  };
+
+  Threads::run(y1, y2, row);
+}
+
@@ -87,6 +87,7 @@ void Offset::drag(View *view)
   temp_x = x;
   temp_y = y;
 
+  view->invalidate(0, 0, w - 1, h - 1);
   view->drawMain(true);
   Gui::offset->values(dx, dy);
 }
@@ -27,11 +27,101 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Gui.H"
 #include "Map.H"
 #include "Paint.H"
+#include "PaintOptions.H"
 #include "Project.H"
 #include "Render.H"
 #include "Stroke.H"
+#include "Undo.H"
 #include "View.H"
 
+namespace
+{
+  // updates the viewport during rendering
+  int update(int pos)
+  {
+    // user cancelled operation
+    if (Fl::get_key(FL_Escape))
+    {
+      Gui::getView()->drawMain(true);
+      return -1;
+    }
+
+    if ((pos & 63) == 63)
+    {
+      Stroke *stroke = Project::stroke;
+
+      Gui::getView()->invalidate(stroke->x1, stroke->y1,
+                                 stroke->x2, stroke->y2);
+      Gui::getView()->drawDirty(true);
+      Fl::check();
+    }
+
+    return 0;
+  }
+
+  // start the rendering process
+  void render()
+  {
+    View *view = Gui::getView();
+    Stroke *stroke = Project::stroke;
+    Brush *brush = Project::brush;
+    const int mode = Gui::paint->getMode();
+
+    Render::bmp = Project::bmp;
+    Render::map = Project::map;
+    Render::brush = brush;
+    Render::color = brush->color;
+    Render::trans = brush->trans;
+    Render::update_callback = update;
+
+    int size = 1;
+
+    // for tools that grow outward
+    switch (mode)
+    {
+      case Render::BLURRY:
+        size = (3 << brush->blurry_edge);
+        break;
+      case Render::WATERCOLOR:
+        size = (3 << brush->watercolor_edge);
+        break;
+    }
+
+    stroke->x1 -= size;
+    stroke->y1 -= size;
+    stroke->x2 += size;
+    stroke->y2 += size;
+    stroke->clip();
+
+    stroke->makeBlitRect(stroke->x1, stroke->y1,
+                         stroke->x2, stroke->y2,
+                         view->ox, view->oy, 1, view->zoom);
+
+    const int x = stroke->x1;
+    const int y = stroke->y1;
+    const int w = (stroke->x2 - stroke->x1) + 1;
+    const int h = (stroke->y2 - stroke->y1) + 1;
+
+    if (w <= 0 || h <= 0)
+      return;
+
+    Project::undo->push(x, y, w, h, 0);
+
+    Render::x1 = stroke->x1;
+    Render::y1 = stroke->y1;
+    Render::x2 = stroke->x2;
+    Render::y2 = stroke->y2;
+
+    view->rendering = true;
+    Render::draw(mode);
+
+    Project::map->clear(0);
+    view->rendering = false;
+    view->invalidate(stroke->x1, stroke->y1, stroke->x2, stroke->y2);
+    view->drawDirty(true);
+  }
+}
+
 Paint::Paint()
 {
   active = 0;
@@ -51,7 +141,7 @@ void Paint::push(View *view)
     {
       stroke->end(view->imgx, view->imgy);
       Blend::set(Project::brush->blend);
-      Render::begin();
+      render();
       active = false;
       Blend::set(Blend::TRANS);
       view->drawMain(true);
@@ -77,7 +167,7 @@ void Paint::drag(View *view)
   if (stroke->type != 3)
   {
     stroke->draw(view->imgx, view->imgy, view->ox, view->oy, view->zoom);
-    view->drawMain(false);
+    view->drawDirty(false);
     stroke->previewPaint(view);
 
     view->redraw();
@@ -92,7 +182,7 @@ void Paint::release(View *view)
   {
     stroke->end(view->imgx, view->imgy);
     Blend::set(Project::brush->blend);
-    Render::begin();
+    render();
     active = false;
     Blend::set(Blend::TRANS);
   }
@@ -111,7 +201,7 @@ void Paint::move(View *view)
   if (radius < 2)
     radius = 2;
 
-  view->drawMain(false);
+  view->drawDirty(false);
 
   switch (stroke->type)
   {
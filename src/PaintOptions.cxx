@@ -230,6 +230,7 @@ void PaintOptions::mode()
       paint_texture_edge->show();
       paint_texture_marb->show();
       paint_texture_turb->show();
+      Render::prepareTexture(Project::brush);
       break;
     case Render::AVERAGE:
       paint_average_edge->show();
@@ -344,11 +345,13 @@ void PaintOptions::textureEdge()
 void PaintOptions::textureMarb()
 {
   Project::brush->texture_marb = paint_texture_marb->var;
+  Render::prepareTexture(Project::brush);
 }
 
 void PaintOptions::textureTurb()
 {
   Project::brush->texture_turb = paint_texture_turb->var;
+  Render::prepareTexture(Project::brush);
 }
 
 void PaintOptions::averageEdge()
@@ -19,16 +19,16 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "Bitmap.H"
 #include "Blend.H"
-#include "Editor.H"
 #include "FileSP.H"
 #include "KDtree.H"
 #include "Inline.H"
 #include "Palette.H"
-#include "Widget.H"
+#include "Threads.H"
 
 namespace
 {
@@ -37,101 +37,118 @@ namespace
     return getl(c1) < getl(c2);
   }
 
-  unsigned char *table;
-}
+  struct entry_type
+  {
+    int r, g, b;
+    int index;
+  };
 
-Palette::Palette()
-{
-  // palette color data
-  data = new int[256];
+  bool sort_green_cb(const entry_type &e1, const entry_type &e2)
+  {
+    return e1.g < e2.g;
+  }
 
-  data[0] = makeRgb(0, 0, 0);
-  data[1] = makeRgb(255, 255, 255);
-  max = 2;
-}
+  // see https://www.compuphase.com/cmetric.htm
+  inline int colorDistance(const int c1, const int r, const int g, const int b)
+  {
+    const int dr = getr(c1) - r;
+    const int dg = getg(c1) - g;
+    const int db = getb(c1) - b;
+    const int avg_r = (getr(c1) + r) / 2;
 
-Palette::~Palette()
-{
-  delete[] data;
-}
+    const int rw = ((512 + avg_r) * dr * dr) / 256;
+    const int gw = 4 * dg * dg;
+    const int bw = ((767 - avg_r) * db * db) / 256;
 
-// draw palette swatches to a widget, and try to fill the space optimally
-void Palette::draw(Widget *widget)
-{
-  if (max > 256)
-    return;
+    return rw + gw + bw;
+  }
 
-  int w = widget->w();
-  int h = widget->h();
+  // entries are sorted by green, which has the largest weight in the metric,
+  // so the search can walk outward from the cell and stop once 4 * dg * dg
+  // alone is worse than the best match (ties go to the lowest index, which
+  // is what a linear scan would pick)
+  int nearestEntry(const std::vector<entry_type> &sorted,
+                   const int r, const int g, const int b)
+  {
+    const int count = sorted.size();
+    int best = std::numeric_limits<int>::max();
+    int use = 0;
 
-  int step = std::sqrt((w * h) / max);
+    int up = std::lower_bound(sorted.begin(), sorted.end(),
+                              entry_type { 0, g, 0, 0 }, sort_green_cb)
+                              - sorted.begin();
+    int down = up - 1;
 
-  while ((w % step) != 0)
-    step--;
+    while (up < count || down >= 0)
+    {
+      if (up < count)
+      {
+        const entry_type &e = sorted[up];
+        const int dg = e.g - g;
 
-  while (((w / step) & ((w / step) - 1)) != 0)
-    step--;
+        if (4 * dg * dg > best)
+        {
+          up = count;
+        }
+          else
+        {
+          const int d = colorDistance(makeRgb(e.r, e.g, e.b), r, g, b);
 
-  widget->stepx = step;
-  widget->stepy = step;
-  widget->bitmap->clear(makeRgb(0, 0, 0));
+          if (d < best || (d == best && e.index < use))
+          {
+            best = d;
+            use = e.index;
+          }
 
-  for (int y = 0; y < h; y += step)
-  {
-    for (int x = 0; x < w; x += step)
-    {
-      widget->bitmap->rect(x, y, x + step, y + step,
-                           makeRgb(255, 255, 255), 160);
-      widget->bitmap->line(x, y, x + step - 1, y + step - 1,
-                           makeRgb(255, 255, 255), 160);
-      widget->bitmap->line(w - 1 - x, y, w - 1 - (x + step - 1), y + step - 1,
-                           makeRgb(255, 255, 255), 160);
-    }
-  }
+          up++;
+        }
+      }
 
-  int i = 0;
+      if (down >= 0)
+      {
+        const entry_type &e = sorted[down];
+        const int dg = e.g - g;
 
-  for (int y = 0; y < h / step; y++)
-  {
-    for (int x = 0; x < w / step; x++)
-    {
-      if (i >= max)
-        break;
-      int x1 = x * step;
-      int y1 = y * step;
+        if (4 * dg * dg > best)
+        {
+          down = -1;
+        }
+          else
+        {
+          const int d = colorDistance(makeRgb(e.r, e.g, e.b), r, g, b);
 
-      widget->bitmap->rectfill(x1, y1, x1 + step - 1, y1 + step - 1,
-                               data[i], 0);
-      i++;
-    }
-  }
+          if (d < best || (d == best && e.index < use))
+          {
+            best = d;
+            use = e.index;
+          }
 
-  for (int y = 0; y < h; y += step)
-  {
-    for (int x = 0; x < w; x += step)
-    {
-      widget->bitmap->hline(x, y, x + step - 1, makeRgb(0, 0, 0), 128);
-      widget->bitmap->vline(y, x, y + step - 1, makeRgb(0, 0, 0), 128);
+          down--;
+        }
+      }
     }
+
+    return use;
   }
+}
 
-  int div = widget->w() / step;
-  int px = widget->var % div;
-  int py = widget->var / div;
+Palette::Palette()
+{
+  // palette color data
+  data = new int[256];
 
-  int x = px * step;
-  int y = py * step;
+  data[0] = makeRgb(0, 0, 0);
+  data[1] = makeRgb(255, 255, 255);
+  max = 2;
 
-  widget->bitmap->rect(0, 0, w - 1, h - 1, makeRgb(0, 0, 0), 0);
-  widget->bitmap->rectfill(x, y, x + step - 1, y + step - 1,
-                           data[widget->var], 0);
-  widget->bitmap->rect(x, y, x + step - 1, y + step - 1, makeRgb(0, 0, 0), 0);
-  widget->bitmap->rect(x - 1, y - 1, x + step, y + step, makeRgb(0, 0, 0), 96);
-  widget->bitmap->rect(x - 2, y - 2, x + step + 1, y + step + 1,
-                       makeRgb(0, 0, 0), 160);
-  widget->bitmap->xorRect(x, y, x + step - 1, y + step - 1);
+  // lookup table is created by the first fillTable()
+  table = 0;
+}
 
-  widget->redraw();
+Palette::~Palette()
+{
+  delete[] data;
+  delete[] table;
 }
 
 // functions to modify palette (be sure to call fillTable afterwards)
@@ -180,60 +197,168 @@ void Palette::swapColor(int c1, int c2)
   data[c2] = temp;
 }
 
-// generate palette lookup table, see:
-// https://www.compuphase.com/cmetric.htm
+// generate palette lookup table
+//
+// only cells affected by a change are searched again when the palette differs
+// from the last one by a few replaced colors, or by a single insertion or
+// deletion (data may be edited directly, so this is worked out from the colors
+// rather than from which function was called)
 void Palette::fillTable()
 {
-  delete[] table;
-  table = new unsigned char[16777216];
+  if (table == 0)
+  {
+    table = new unsigned char[16777216];
+    cells.resize(64 * 64 * 64, 0);
+  }
+
+  const int old_max = table_colors.size();
+
+  // what each old index becomes, -1 if its cells must be searched again
+  std::vector<int> remap(256, -1);
+
+  // entries that may now be closer than the current match of a cell
+  std::vector<int> changed;
+
+  bool rebuild = true;
+
+  if (old_max == max)
+  {
+    for (int i = 0; i < max; i++)
+    {
+      if (data[i] == table_colors[i])
+        remap[i] = i;
+      else
+        changed.push_back(i);
+    }
+
+    // nothing to do
+    if (changed.size() == 0)
+      return;
+
+    rebuild = changed.size() > 16;
+  }
+    else if (old_max > 0 && (max == old_max + 1 || max == old_max - 1))
+  {
+    const int low = std::min(max, old_max);
+    int pos = 0;
+
+    while (pos < low && data[pos] == table_colors[pos])
+      pos++;
+
+    rebuild = false;
+
+    for (int i = 0; i < pos; i++)
+      remap[i] = i;
+
+    if (max > old_max)
+    {
+      // one color inserted at pos
+      for (int i = pos; i < old_max; i++)
+      {
+        if (data[i + 1] != table_colors[i])
+          rebuild = true;
+
+        remap[i] = i + 1;
+      }
+
+      changed.push_back(pos);
+    }
+      else
+    {
+      // one color deleted at pos
+      for (int i = pos + 1; i < old_max; i++)
+      {
+        if (data[i - 1] != table_colors[i])
+          rebuild = true;
+
+        remap[i] = i - 1;
+      }
+    }
+  }
+
+  if (rebuild)
+  {
+    std::fill(remap.begin(), remap.end(), -1);
+    changed.clear();
+  }
+
+  std::vector<entry_type> sorted(max);
+
+  for (int i = 0; i < max; i++)
+  {
+    const int c = data[i];
+
+    sorted[i] = entry_type { getr(c), getg(c), getb(c), i };
+  }
 
-  for (int b = 0; b <= 256 - 4; b += 4)
+  std::stable_sort(sorted.begin(), sorted.end(), sort_green_cb);
+
+  // each slice of blue values covers its own part of the table
+  Threads::run(0, 63, [&](int z)
   {
-    for (int g = 0; g <= 256 - 4; g += 4)
+    const int b = z * 4;
+
+    for (int y = 0; y < 64; y++)
     {
-      for (int r = 0; r <= 256 - 4; r += 4)
+      const int g = y * 4;
+
+      for (int x = 0; x < 64; x++)
       {
-        int lowest = std::numeric_limits<int>::max();
-        int use = 0;
+        const int r = x * 4;
+        unsigned char &cell = cells[(z << 12) + (y << 6) + x];
+        int use = remap[cell];
 
-        for (int i = 0; i < max; i++)
+        if (use < 0)
+        {
+          use = nearestEntry(sorted, r + 2, g + 2, b + 2);
+        }
+          else
         {
-          const int c1 = data[i];
-          const int dr = getr(c1) - (r + 2);
-          const int dg = getg(c1) - (g + 2);
-          const int db = getb(c1) - (b + 2);
-          const int avg_r = (getr(c1) + (r + 2)) / 2;
-
-          const int rw = ((512 + avg_r) * dr * dr) / 256;
-          const int gw = 4 * dg * dg;
-          const int bw = ((767 - avg_r) * db * db) / 256;
-          const int d = rw + gw + bw;
-
-          if (d < lowest)
+          int best = colorDistance(data[use], r + 2, g + 2, b + 2);
+
+          for (int i : changed)
           {
-            lowest = d;
-            use = i;
+            const int d = colorDistance(data[i], r + 2, g + 2, b + 2);
+
+            if (d < best || (d == best && i < use))
+            {
+              best = d;
+              use = i;
+            }
           }
         }
 
+        if (!rebuild && cell == use)
+          continue;
+
+        cell = use;
+
         for (int k = 0; k < 4; k++)
         {
-          const int bk = b + k;
-
           for (int j = 0; j < 4; j++)
           {
-            const int gj = g + j;
+            unsigned char *p = table + makeRgb24(r, g + j, b + k);
 
-            for (int i = 0; i < 4; i++)
-            {
-              const int ri = r + i;
-
-              table[makeRgb24(ri, gj, bk)] = use;
-            }
+            p[0] = use;
+            p[1] = use;
+            p[2] = use;
+            p[3] = use;
           }
         }
       }
     }
+  });
+
+  // take out the old exact matches
+  if (!rebuild)
+  {
+    for (int i = 0; i < old_max; i++)
+    {
+      const int c = table_colors[i];
+
+      table[c & 0xffffff] =
+        cells[((getb(c) >> 2) << 12) + ((getg(c) >> 2) << 6) + (getr(c) >> 2)];
+    }
   }
 
   // put exact matches back in
@@ -241,6 +366,8 @@ void Palette::fillTable()
   {
     table[data[i] & 0xffffff] = i;
   }
+
+  table_colors.assign(data, data + max);
 }
 
 // return the nearest palette entry for an RGB color
@@ -322,8 +449,6 @@ int Palette::load(const char *fn)
 // sort into grays, low-sat colors, hi-sat colors
 void Palette::sortByHue()
 {
-  Editor::push();
-
   std::vector<int> bucket(25 * 256, 0);
   std::vector<int> count(25, 0);
 
@@ -383,9 +508,7 @@ void Palette::sortByHue()
 }
 
 void Palette::sortByValue()
-{   
-  Editor::push();
-
+{
   std::sort(data, data + max, sort_value_cb);
   fillTable();
 } 
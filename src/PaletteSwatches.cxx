@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <cmath>
+
+#include "Bitmap.H"
+#include "Inline.H"
+#include "Palette.H"
+#include "Widget.H"
+
+// draw palette swatches to a widget, and try to fill the space optimally
+void Palette::draw(Widget *widget)
+{
+  if (max > 256)
+    return;
+
+  int w = widget->w();
+  int h = widget->h();
+
+  int step = std::sqrt((w * h) / max);
+
+  while ((w % step) != 0)
+    step--;
+
+  while (((w / step) & ((w / step) - 1)) != 0)
+    step--;
+
+  widget->stepx = step;
+  widget->stepy = step;
+  widget->bitmap->clear(makeRgb(0, 0, 0));
+
+  for (int y = 0; y < h; y += step)
+  {
+    for (int x = 0; x < w; x += step)
+    {
+      widget->bitmap->rect(x, y, x + step, y + step,
+                           makeRgb(255, 255, 255), 160);
+      widget->bitmap->line(x, y, x + step - 1, y + step - 1,
+                           makeRgb(255, 255, 255), 160);
+      widget->bitmap->line(w - 1 - x, y, w - 1 - (x + step - 1), y + step - 1,
+                           makeRgb(255, 255, 255), 160);
+    }
+  }
+
+  int i = 0;
+
+  for (int y = 0; y < h / step; y++)
+  {
+    for (int x = 0; x < w / step; x++)
+    {
+      if (i >= max)
+        break;
+      int x1 = x * step;
+      int y1 = y * step;
+
+      widget->bitmap->rectfill(x1, y1, x1 + step - 1, y1 + step - 1,
+                               data[i], 0);
+      i++;
+    }
+  }
+
+  for (int y = 0; y < h; y += step)
+  {
+    for (int x = 0; x < w; x += step)
+    {
+      widget->bitmap->hline(x, y, x + step - 1, makeRgb(0, 0, 0), 128);
+      widget->bitmap->vline(y, x, y + step - 1, makeRgb(0, 0, 0), 128);
+    }
+  }
+
+  int div = widget->w() / step;
+  int px = widget->var % div;
+  int py = widget->var / div;
+
+  int x = px * step;
+  int y = py * step;
+
+  widget->bitmap->rect(0, 0, w - 1, h - 1, makeRgb(0, 0, 0), 0);
+  widget->bitmap->rectfill(x, y, x + step - 1, y + step - 1,
+                           data[widget->var], 0);
+  widget->bitmap->rect(x, y, x + step - 1, y + step - 1, makeRgb(0, 0, 0), 0);
+  widget->bitmap->rect(x - 1, y - 1, x + step, y + step, makeRgb(0, 0, 0), 96);
+  widget->bitmap->rect(x - 2, y - 2, x + step + 1, y + step + 1,
+                       makeRgb(0, 0, 0), 160);
+  widget->bitmap->xorRect(x, y, x + step - 1, y + step - 1);
+
+  widget->redraw();
+}
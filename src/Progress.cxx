@@ -18,16 +18,7 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
-#include <cstdio>
-
-#include "FL/Fl_Box.H"
-#include "FL/Fl_Double_Window.H"
-#include "FL/Fl_Group.H"
-#include "FL/Fl_Progress.H"
-
-#include "Gui.H"
 #include "Progress.H"
-#include "View.H"
 
 // hack to externally enable/disable progress indicator
 // allows filters to be used internally
@@ -36,6 +27,11 @@ float Progress::value = 0;
 float Progress::step = 0;
 int Progress::interval = 100;
 
+void (*Progress::show_callback)() = 0;
+int (*Progress::update_callback)(const float, const bool) = 0;
+void (*Progress::hide_callback)() = 0;
+void (*Progress::info_callback)(const char *) = 0;
+
 void Progress::enable(bool state)
 {
   active = state;
@@ -43,27 +39,22 @@ void Progress::enable(bool state)
 
 void Progress::hide()
 {
-  if (active == false)
+  if (active == false || hide_callback == 0)
     return;
 
-  Gui::progress->value(0);
-  Gui::progress->copy_label("");
-  Gui::progress->redraw();
-  Gui::progress->hide();
-  Gui::view->rendering = false;
-  Gui::view->drawMain(true);
+  hide_callback();
 }
 
 // use default interval
 void Progress::show(float max)
 {
+  // nothing is shared while disabled, so batch jobs can run at once
   if (active == false)
     return;
 
   if (max == 0)
     max = .001;
 
-  Gui::view->rendering = true;
   value = 0;
   interval = max / 10;
 
@@ -71,10 +62,11 @@ void Progress::show(float max)
     interval = 1;
 
   step = 100.0 / (max / interval);
-  // keep progress bar on right side in case window was resized
-  Gui::progress->resize(Gui::getStatus()->x() + Gui::getWindow()->w() - 256 - 8,                        Gui::getStatus()->y() + 4, 256, 24);
 
-  Gui::progress->show();
+  if (show_callback == 0)
+    return;
+
+  show_callback();
 }
 
 // custom interval
@@ -89,40 +81,43 @@ void Progress::show(float max, int new_interval)
   if (new_interval < 1)
      new_interval = 1;
 
-  Gui::view->rendering = true;
   value = 0;
   interval = new_interval;
   step = 100.0 / (max / new_interval);
-  // keep progress bar on right side in case window was resized
-  Gui::progress->resize(Gui::getStatus()->x() + Gui::getWindow()->w() - 256 - 8,
-                        Gui::getStatus()->y() + 4, 256, 24);
-  Gui::progress->show();
-  Gui::view->drawMain(true);
+
+  if (show_callback == 0)
+    return;
+
+  show_callback();
 }
 
+// the bar moves once every interval, but the callback is asked about
+// cancelling every time
 int Progress::update(int y)
 {
-  if (active == false)
+  if (active == false || update_callback == 0)
     return 0;
 
+  const bool redraw = !(y % interval);
+
   // user cancelled operation
-  if (Fl::get_key(FL_Escape))
+  if (update_callback(value, redraw) < 0)
   {
     hide();
-    Gui::view->drawMain(true);
     return -1;
   }
 
-  if (!(y % interval))
-  {
-    Gui::progress->value(value);
-    char percent[16];
-    snprintf(percent, sizeof(percent), "%d%%", (int)value);
-    Gui::progress->copy_label(percent);
+  if (redraw)
     value += step;
-    Gui::view->drawMain(true);
-  }
 
   return 0;
 }
 
+// status text for long operations, 0 puts back what was shown before
+void Progress::info(const char *s)
+{
+  if (info_callback == 0)
+    return;
+
+  info_callback(s);
+}
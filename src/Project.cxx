@@ -23,11 +23,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Blend.H"
 #include "Bitmap.H"
 #include "Brush.H"
+#include "Clone.H"
 #include "Dialog.H"
 #include "Fill.H"
 #include "Gradient.H"
 #include "Inline.H"
 #include "Map.H"
+#include "Mipmap.H"
 #include "Offset.H"
 #include "Paint.H"
 #include "Palette.H"
@@ -41,6 +43,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 
 Bitmap *Project::bmp;
 Bitmap *Project::select_bmp;
+Mipmap *Project::mipmap;
 Map *Project::map;
 
 Brush *Project::brush;
@@ -58,6 +61,7 @@ int Project::current;
 int Project::last;
 int Project::mem_max;
 int Project::undo_max;
+bool Project::undo_compress = false;
   
 Paint *Project::paint;
 Picker *Project::picker;
@@ -81,10 +85,12 @@ void Project::init(int memory_limit, int undo_limit)
   bmp = 0;
   map = 0;
   select_bmp = new Bitmap(8, 8);
+  mipmap = new Mipmap();
 
   brush = new Brush();
   palette = new Palette();
   stroke = new Stroke();
+  Clone::stroke = stroke;
   undo = 0;
   last = 0;
 
@@ -188,6 +194,9 @@ int Project::newImage(int w, int h)
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
 
+  // a new bitmap can land at the old one's address
+  mipmap->invalidateAll();
+
   return 0;
 }
 
@@ -219,6 +228,8 @@ int Project::newImageFromBitmap(Bitmap *temp)
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
 
+  mipmap->invalidateAll();
+
   return 0;
 }
 
@@ -234,6 +245,8 @@ void Project::replaceImage(int w, int h)
   delete map;
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
+
+  mipmap->invalidateAll();
 }
 
 void Project::replaceImageFromBitmap(Bitmap *temp)
@@ -248,6 +261,8 @@ void Project::replaceImageFromBitmap(Bitmap *temp)
   delete map;
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
+
+  mipmap->invalidateAll();
 }
 
 void Project::resizeImage(int w, int h)
@@ -266,6 +281,8 @@ void Project::resizeImage(int w, int h)
   delete map;
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
+
+  mipmap->invalidateAll();
 }
 
 void Project::switchImage(int index)
@@ -281,6 +298,8 @@ void Project::switchImage(int index)
   delete map;
   map = new Map(bmp->w, bmp->h);
   map->clear(0);
+
+  mipmap->invalidateAll();
 }
 
 bool Project::removeImage()
@@ -306,6 +325,8 @@ bool Project::removeImage()
     delete map;
     map = new Map(bmp->w, bmp->h);
     map->clear(0);
+
+    mipmap->invalidateAll();
   }
     else
   {
@@ -371,22 +392,19 @@ double Project::getImageMemory()
     bytes += temp->w * temp->h * sizeof(int);
     bytes += temp->h * sizeof(int *);
 
-    for (int i = 0; i < undo_list[j]->levels; i++)
-    {
-      temp = undo_list[j]->undo_stack[i];
+    bytes += undo_list[j]->getMemory();
+  }
 
-      bytes += temp->w * temp->h * sizeof(int);
-      bytes += temp->h * sizeof(int *);
-    }
+  return bytes;
+}
 
-    for (int i = 0; i < undo_list[j]->levels; i++)
-    {
-      temp = undo_list[j]->redo_stack[i];
+// undo history moved to the scratch file, not part of the memory limit
+double Project::getSpilledMemory()
+{
+  double bytes = 0;
 
-      bytes += temp->w * temp->h * sizeof(int);
-      bytes += temp->h * sizeof(int *);
-    }
-  }
+  for (int j = 0; j < last; j++)
+    bytes += undo_list[j]->getSpilledMemory();
 
   return bytes;
 }
@@ -29,19 +29,19 @@ http://www.visgraf.impa.br/sibgrapi97/anais/pdf/art61.pdf
 #include <vector>
 #include <algorithm>
 #include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <queue>
 
 #include "Blend.H"
 #include "Bitmap.H"
-#include "Editor.H"
-#include "Gui.H"
 #include "Inline.H"
 #include "Palette.H"
 #include "Progress.H"
 #include "Quantize.H"
-
-#include "Project.H"
-#include "ImagesOptions.H"
-#include "Undo.H"
+#include "Threads.H"
 
 int Quantize::makeRgbShift(const int r, const int g, const int b, const int shift)
 {
@@ -208,45 +208,168 @@ int Quantize::limitColors(std::vector<color_type> &color_bin,
   return count;
 }
 
-// count colors in image
-int Quantize::countColors(Bitmap *src, std::bitset<16777216> &bits)
+// one pass over the image, marking which colors occur and summing squared
+// components into bins
+//
+// rows are split between threads, each with its own bits and bins which are
+// combined at the end; a stride above 1 takes one pixel from each
+// stride x stride block instead (at a fixed jittered position, so results
+// are repeatable)
+//
+// returns the number of distinct colors seen
+int Quantize::countColors(Bitmap *src, std::vector<uint32_t> &bits,
+                          std::vector<color_type> &bins,
+                          const int bin_shift, const int stride)
 {
+  const int blocks = (src->h + stride - 1) / stride;
+  const int chunks = std::min(std::min(Threads::count(), 8), blocks);
+
+  std::vector<std::vector<uint32_t> > chunk_bits(chunks);
+  std::vector<std::vector<color_type> > chunk_bins(chunks);
 
-  for (int y = 0; y < src->h; y++)
+  Threads::run(0, chunks - 1, [&](int chunk)
   {
-    for (int x = 0; x < src->w; x++)
+    std::vector<uint32_t> &b = chunk_bits[chunk];
+    std::vector<color_type> &bin = chunk_bins[chunk];
+
+    b.assign(bits.size(), 0);
+    bin.assign(bins.size(), color_type { 0, 0, 0, 0 });
+
+    const int by1 = (long long)blocks * chunk / chunks;
+    const int by2 = (long long)blocks * (chunk + 1) / chunks;
+
+    for (int by = by1; by < by2; by++)
     {
-      const int c = src->getpixel(x, y) & 0xffffff;
+      for (int bx = 0; bx < src->w; bx += stride)
+      {
+        int x = bx;
+        int y = by * stride;
+
+        if (stride > 1)
+        {
+          const unsigned int hash = (bx * 73856093u) ^ (by * 19349663u);
+
+          x = std::min(x + (int)(hash % stride), src->w - 1);
+          y = std::min(y + (int)((hash >> 16) % stride), src->h - 1);
+        }
+
+        const int c = src->row[y][x] & 0xffffff;
+        const int r = getr(c);
+        const int g = getg(c);
+        const int bl = getb(c);
+
+        b[c >> 5] |= 1u << (c & 31);
+
+        const int index = makeRgbShift(r >> (8 - bin_shift),
+                                       g >> (8 - bin_shift),
+                                       bl >> (8 - bin_shift), bin_shift);
 
-      bits[c] = 1;
+        color_type &dest = bin[index];
+
+        dest.r += r * r;
+        dest.g += g * g;
+        dest.b += bl * bl;
+        dest.freq += 1;
+      }
     }
-  }
+  });
+
+  // combine the results
+  const int words = bits.size();
+  const int num_bins = bins.size();
+
+  Threads::run(0, 63, [&](int slice)
+  {
+    const int w1 = (long long)words * slice / 64;
+    const int w2 = (long long)words * (slice + 1) / 64;
+
+    for (int i = w1; i < w2; i++)
+    {
+      uint32_t word = 0;
+
+      for (int j = 0; j < chunks; j++)
+        word |= chunk_bits[j][i];
+
+      bits[i] = word;
+    }
+
+    const int b1 = (long long)num_bins * slice / 64;
+    const int b2 = (long long)num_bins * (slice + 1) / 64;
 
-  return bits.count();
+    for (int i = b1; i < b2; i++)
+    {
+      for (int j = 0; j < chunks; j++)
+      {
+        bins[i].r += chunk_bins[j][i].r;
+        bins[i].g += chunk_bins[j][i].g;
+        bins[i].b += chunk_bins[j][i].b;
+        bins[i].freq += chunk_bins[j][i].freq;
+      }
+    }
+  });
+
+  int count = 0;
+
+  for (int i = 0; i < words; i++)
+    count += std::bitset<32>(bits[i]).count();
+
+  return count;
 }
 
-void Quantize::pca(Bitmap *src, Palette *pal, int size, int samples)
+void Quantize::pca(Bitmap *src, Palette *pal, int size, int samples,
+                   const bool sampled)
 {
-  std::bitset<16777216> color_bits;
   std::vector<color_type> colors(samples);
 
-  const int color_count = countColors(src, color_bits);
+  const int num_bins = size < 64 ? 32768 : 262144;
+  const int bin_size = std::cbrt(num_bins);
+  const int bin_step = 256 / bin_size;
+  const int bin_shift = std::log2(bin_size);
+
+  std::vector<uint32_t> color_bits(16777216 / 32);
+  std::vector<color_type> color_bin(num_bins, color_type { 0, 0, 0, 0 });
+
+  // about a million samples when sampling
+  int stride = 1;
+
+  if (sampled)
+    stride = std::max((int)std::sqrt((double)src->w * src->h / 1048576), 1);
+
+  int color_count = countColors(src, color_bits, color_bin,
+                                bin_shift, stride);
+
+  // a sample may have missed some colors, so check the whole image
+  // before using them as the palette
+  if (stride > 1 && color_count <= size)
+  {
+    stride = 1;
+    std::fill(color_bits.begin(), color_bits.end(), 0);
+    std::fill(color_bin.begin(), color_bin.end(), color_type { 0, 0, 0, 0 });
+    color_count = countColors(src, color_bits, color_bin,
+                              bin_shift, stride);
+  }
 
   // skip quantization if palette if image already has enough colors
   if (color_count <= size)
   {
     int index = 0;
 
-    for (int i = 0; i < 16777216; i++)
+    for (int i = 0; i < 16777216 / 32; i++)
     {
-      if (color_bits[i] == 1)
+      const uint32_t word = color_bits[i];
+
+      if (word == 0)
+        continue;
+
+      for (int j = 0; j < 32; j++)
       {
-        const int r = getr(i);
-        const int g = getg(i);
-        const int b = getb(i);
+        if (word & (1u << j))
+        {
+          const int c = i * 32 + j;
 
-        pal->data[index] = makeRgb(r, g, b);
-        index++;
+          pal->data[index] = makeRgb(getr(c), getg(c), getb(c));
+          index++;
+        }
       }
     }
 
@@ -254,48 +377,28 @@ void Quantize::pca(Bitmap *src, Palette *pal, int size, int samples)
     return;
   }
 
-  const int pixel_count = src->w * src->h;
-  const int num_bins = size < 64 ? 32768 : 262144;
-  const int bin_size = std::cbrt(num_bins);
-  const int bin_step = 256 / bin_size;
-  const int bin_shift = std::log2(bin_size);
-
-  Gui::saveStatusInfo();
-  Gui::statusInfo("Creating Color List...");
-
-  // average colors and place them into bins
-  std::vector<color_type> color_bin(num_bins);
+  const int pixel_count = ((src->w + stride - 1) / stride) *
+                          ((src->h + stride - 1) / stride);
 
-  for (int i = 0; i < num_bins; i++)
+  if (stride > 1)
   {
-    color_bin[i].r = 0;
-    color_bin[i].g = 0;
-    color_bin[i].b = 0;
-    color_bin[i].freq = 0;
+    // hoeffding bound on the share of pixels in any one bin,
+    // at 95% confidence
+    char s[256];
+    const double bound = std::sqrt(std::log(2.0 / 0.05) / (2.0 * pixel_count));
+
+    snprintf(s, sizeof(s),
+             "Creating Color List (1 in %d pixels, bin error < %.3f%%)...",
+             stride * stride, bound * 100);
+    Progress::info(s);
   }
-
-  const double weight = 1.0;
-  int count = 0;
-
-  for (int y = 0; y <= src->h; y++)
+    else
   {
-    for (int x = 0; x <= src->w; x++)
-    {
-      const int c = src->getpixel(x, y);
-      rgba_type rgba = getRgba(c);
-
-      const int rs = rgba.r >> (8 - bin_shift);
-      const int gs = rgba.g >> (8 - bin_shift);
-      const int bs = rgba.b >> (8 - bin_shift);
-      const int index = makeRgbShift(rs, gs, bs, bin_shift);
-
-      color_bin[index].r += rgba.r * rgba.r;
-      color_bin[index].g += rgba.g * rgba.g;
-      color_bin[index].b += rgba.b * rgba.b;
-      color_bin[index].freq += weight;
-    }
+    Progress::info("Creating Color List...");
   }
 
+  int count = 0;
+
   for (int b = 0; b < 256; b += bin_step)
   {
     for (int g = 0; g < 256; g += bin_step)
@@ -334,94 +437,106 @@ void Quantize::pca(Bitmap *src, Palette *pal, int size, int samples)
   if (max < size)
     size = max;
 
-  // init error matrix
-  std::vector<double> err_data(((max + 1) * max) / 2);
-
-  for (int j = 0; j < max; j++)
-  {
-    for (int i = 0; i < j; i++)
-    {
-      err_data[i + (j + 1) * j / 2] = error(colors[i], colors[j]);
-    }
-  }
-
-  // show progress bar
-  Progress::show(max - size);
-  Gui::statusInfo("Merging...");
-
-  // measure offset between array elements
-  const int freq_step = &(colors[1].freq) - &(colors[0].freq);
-
-  // bailout value
-  const double bailout = 512;
+  // nearest neighbor of each color, and a queue of candidate pairs
+  // ordered by error; queue entries are skipped once the color they
+  // belong to has merged or found a different neighbor
+  std::vector<int> nearest(max, -1);
+  std::vector<double> nearest_err(max);
+  std::vector<int> stamp(max, 0);
+  std::priority_queue<pair_type, std::vector<pair_type>,
+                      std::greater<pair_type>> queue;
 
-  // find minimum quantization error
-  while (count > size)
+  auto findNearest = [&](const int i)
   {
-    int ii = 0, jj = 0;
-    double *a = &(colors[0].freq);
-    double least_err = std::numeric_limits<double>::max();
+    int best = -1;
+    double best_err = std::numeric_limits<double>::max();
 
     for (int j = 0; j < max; j++)
     {
-      if (*a > 0)
+      if (j == i || colors[j].freq <= 0)
+        continue;
+
+      const double e = error(colors[i], colors[j]);
+
+      if (e < best_err)
       {
-        double *e = &err_data[(j + 1) * j / 2];
-        double *b = &(colors[0].freq);
+        best_err = e;
+        best = j;
+      }
+    }
 
-        for (int i = 0; i < j; i++)
-        {
-          if (*e < least_err && *b > 0)
-          {
-            least_err = *e;
+    nearest[i] = best;
+    nearest_err[i] = best_err;
+    stamp[i]++;
 
-            ii = i;
-            jj = j;
+    if (best >= 0)
+      queue.push(pair_type { best_err, i, best, stamp[i] });
+  };
 
-            if (least_err < bailout && ii != 0 && jj != 0)
-              goto found;
-          }
+  for (int i = 0; i < max; i++)
+    findNearest(i);
 
-          e++;
-          b += freq_step;
-        }
-      }
+  // show progress bar
+  Progress::show(max - size);
+  Progress::info("Merging...");
 
-      a += freq_step;
-    }
+  // merge the pair with the least quantization error until
+  // the palette is small enough
+  while (count > size && !queue.empty())
+  {
+    const pair_type pair = queue.top();
+    queue.pop();
+
+    if (colors[pair.i].freq <= 0 || pair.stamp != stamp[pair.i])
+      continue;
 
-    found:
+    // keep the lower index, like a palette sorted by popularity
+    const int ii = std::min(pair.i, pair.j);
+    const int jj = std::max(pair.i, pair.j);
 
     // merge pair
     merge(colors[ii], colors[jj]);
     colors[jj].freq = 0;
     count--;
 
-    // recompute error matrix
-    for (int j = ii; j < max; j++)
+    // the merged color changed, update neighbors that involve it
+    for (int k = 0; k < max; k++)
     {
-      if (colors[j].freq > 0)
+      if (k == ii || colors[k].freq <= 0)
+        continue;
+
+      if (nearest[k] == ii || nearest[k] == jj)
+      {
+        // might have moved away, so search again
+        findNearest(k);
+      }
+        else
       {
-        err_data[ii + (j + 1) * j / 2] = error(colors[ii], colors[j]);
+        const double e = error(colors[k], colors[ii]);
+
+        if (e < nearest_err[k] || (e == nearest_err[k] && ii < nearest[k]))
+        {
+          nearest[k] = ii;
+          nearest_err[k] = e;
+          stamp[k]++;
+          queue.push(pair_type { e, k, ii, stamp[k] });
+        }
       }
     }
 
+    findNearest(ii);
+
     // user cancelled operation
-    if (Fl::get_key(FL_Escape))
+    if (Progress::update(count) < 0)
     {
-      Progress::hide();
-      Gui::restoreStatusInfo();
+      Progress::info(0);
       return;
     }
-
-    Progress::update(count);
   }
 
   Progress::hide();
 
   // build palette
-  Editor::push();
-
   int index = 0;
 
   for (int i = 0; i < max; i++)
@@ -438,6 +553,6 @@ void Quantize::pca(Bitmap *src, Palette *pal, int size, int samples)
   }
 
   pal->max = index;
-  Gui::restoreStatusInfo();
+  Progress::info(0);
 }
 
@@ -19,7 +19,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "Blend.H"
@@ -27,51 +31,211 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Brush.H"
 #include "Fractal.H"
 #include "Gamma.H"
-#include "Gui.H"
 #include "Inline.H"
-#include "KDtree.H"
 #include "Map.H"
-#include "PaintOptions.H"
-#include "Project.H"
 #include "Render.H"
-#include "Stroke.H"
-#include "Tool.H"
-#include "Undo.H"
-#include "View.H"
 
-#include "FL/Fl_Choice.H"
+namespace
+{
+  // everything that goes into making a texture
+  struct texture_key_type
+  {
+    int w, h;
+    int turb;
+    int marb;
+    int seed;
+
+    bool operator==(const texture_key_type &other) const
+    {
+      return w == other.w && h == other.h &&
+             turb == other.turb && marb == other.marb &&
+             seed == other.seed;
+    }
+  };
+
+  typedef std::shared_future<std::shared_ptr<Map>> texture_type;
+  typedef std::promise<std::shared_ptr<Map>> texture_promise_type;
+
+  struct texture_entry_type
+  {
+    texture_key_type key;
+    texture_type texture;
+  };
+
+  // recently used textures, newest last
+  std::mutex texture_lock;
+  std::vector<texture_entry_type> textures;
+  const int texture_cache_size = 8;
+
+  // one texture is made at a time, and of the ones asked for meanwhile
+  // only the latest is kept, so a slider drag doesn't pile up threads
+  bool working = false;
+  bool pending = false;
+  texture_key_type pending_key;
+  std::future<void> worker;
+
+  // textures stay the same from one stroke to the next
+  const int texture_seed = 12345;
+
+  std::shared_ptr<Map> makeTexture(const texture_key_type key)
+  {
+    Map plasma(key.w, key.h);
+    Map marbx(key.w, key.h);
+    Map marby(key.w, key.h);
+    std::shared_ptr<Map> marble = std::make_shared<Map>(key.w, key.h);
+
+    Fractal::plasma(&plasma, (key.turb + 1) << 10, key.seed);
+    Fractal::plasma(&marbx, (key.turb + 1) << 10, key.seed + 1);
+    Fractal::plasma(&marby, (key.turb + 1) << 10, key.seed + 2);
+    Fractal::marble(&plasma, marble.get(), &marbx, &marby,
+                    key.marb << 2, 100, 0);
+
+    return marble;
+  }
+
+  // moves the entry for key to the end of the cache, false if not found
+  // (texture_lock must be held)
+  bool touchTexture(const texture_key_type &key)
+  {
+    for (int i = 0; i < (int)textures.size(); i++)
+    {
+      if (textures[i].key == key)
+      {
+        std::rotate(textures.begin() + i, textures.begin() + i + 1,
+                    textures.end());
+
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // adds an entry for key and returns the promise that fills it
+  // (texture_lock must be held)
+  texture_promise_type addTexture(const texture_key_type &key)
+  {
+    texture_promise_type promise;
+
+    textures.push_back(texture_entry_type
+    {
+      key, promise.get_future().share()
+    });
+
+    // only drop finished ones, waiting here would hold up the caller;
+    // at most one is being made, so there is always one to drop
+    for (int i = 0; i < (int)textures.size() - 1; i++)
+    {
+      if ((int)textures.size() <= texture_cache_size)
+        break;
+
+      if (textures[i].texture.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready)
+      {
+        textures.erase(textures.begin() + i);
+        i--;
+      }
+    }
+
+    return promise;
+  }
+
+  // worker thread, makes key and then whatever was asked for meanwhile
+  void makeTextures(texture_key_type key, texture_promise_type promise)
+  {
+    while (true)
+    {
+      promise.set_value(makeTexture(key));
+
+      std::lock_guard<std::mutex> guard(texture_lock);
+
+      if (!pending)
+      {
+        working = false;
+        return;
+      }
+
+      key = pending_key;
+      pending = false;
+      promise = addTexture(key);
+    }
+  }
+
+  // starts making the texture for these settings on another thread,
+  // or queues it behind the one being made
+  void requestTexture(const texture_key_type &key)
+  {
+    std::lock_guard<std::mutex> guard(texture_lock);
+
+    if (touchTexture(key))
+      return;
+
+    if (working)
+    {
+      pending = true;
+      pending_key = key;
+      return;
+    }
+
+    working = true;
+    worker = std::async(std::launch::async, makeTextures,
+                        key, addTexture(key));
+  }
+
+  // returns the texture for these settings, waiting only if it is
+  // still being made
+  std::shared_ptr<Map> findTexture(const texture_key_type &key)
+  {
+    texture_type found;
+
+    {
+      std::lock_guard<std::mutex> guard(texture_lock);
+
+      if (touchTexture(key))
+        found = textures.back().texture;
+
+      // not started yet, make it here rather than behind another one
+      else if (pending && pending_key == key)
+        pending = false;
+    }
+
+    if (found.valid())
+      return found.get();
+
+    std::shared_ptr<Map> texture = makeTexture(key);
+
+    std::lock_guard<std::mutex> guard(texture_lock);
+
+    if (!touchTexture(key))
+      addTexture(key).set_value(texture);
+
+    return texture;
+  }
+
+  texture_key_type textureKey(const Brush *brush)
+  {
+    return texture_key_type
+    {
+      256, 256, brush->texture_turb, brush->texture_marb, texture_seed
+    };
+  }
+}
 
 Bitmap *Render::bmp;
 Map *Render::map;
 Brush *Render::brush;
-Stroke *Render::stroke;
-View *Render::view;
 int Render::color;
 int Render::trans;
-
-// returns true if pixel is on a boundary
-bool Render::isEdge(Map *map, const int x, const int y)
-{
-  if (x < 1 || x >= map->w - 2 || y < 1 || y >= map->h - 2)
-    return 0;
-
-  if ( *(map->row[y - 1] + x) &&
-      *(map->row[y] + x - 1) &&
-      *(map->row[y] + x + 1) &&
-      *(map->row[y + 1] + x) )
-    return 0;
-  else
-    return 1;
-}
-
-// used by fine airbrush
-int Render::fineEdge(int x1, int y1, const int x2, const int y2,
-                     const int edge, const int trans)
+int Render::x1;
+int Render::y1;
+int Render::x2;
+int Render::y2;
+int (*Render::update_callback)(int) = 0;
+
+// used by fine airbrush, takes the squared distance to the nearest edge
+int Render::fineEdge(const int dist, const int edge, const int trans)
 {
-  x1 -= x2;
-  y1 -= y2;
-
-  const float d = std::sqrt(x1 * x1 + y1 * y1);
+  const float d = std::sqrt(dist);
   const int s = (float)(255 - trans) / (((3 << edge) >> 1) + 1);
   const int temp = 255 - s * d;
 
@@ -132,120 +296,88 @@ void Render::growBlock(unsigned char *s0, unsigned char *s1,
 }
 */
 
-// updates the viewport during rendering
+// lets the caller show the stroke as it is rendered, or cancel it
+// (see Paint.cxx), nothing happens without a callback
 int Render::update(int pos)
 {
-  // user cancelled operation
-  if (Fl::get_key(FL_Escape))
-  {
-    Gui::getView()->drawMain(true);
-    return -1;
-  }
+  if (update_callback == 0)
+    return 0;
 
-  if ((pos & 63) == 63)
-  {
-    view->drawMain(true);
-    Fl::check();
-  }
+  return update_callback(pos);
+}
+
+// blends one row of the stroke, using the map as coverage
+void Render::span(const int y, const int t, const bool antialiased)
+{
+  if (y < 0 || y >= map->h)
+    return;
 
-  return 0;
+  Blend::span(bmp, map->row[y], std::max(x1, 0),
+              std::min(x2, map->w - 1), y, color, t, antialiased);
 }
 
 // solid
 void Render::solid()
 {
-  for (int y = stroke->y1; y <= stroke->y2; y++)
-  {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
-    {
-      if (map->getpixel(x, y) > 0)
-        bmp->setpixel(x, y, color, trans);
-    }
-  }
+  for (int y = y1; y <= y2; y++)
+    span(y, trans, false);
 }
 
 // antialiased
 void Render::antialiased()
 {
-  for (int y = stroke->y1; y <= stroke->y2; y++)
-  {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
-    {
-      const int c = map->getpixel(x, y);
-
-      if (c > 0)
-        bmp->setpixel(x, y, color, scaleVal((255 - c), trans));
-    }
-  }
+  for (int y = y1; y <= y2; y++)
+    span(y, trans, true);
 }
 
 // coarse airbrush
+// the edge fades in steps, one for every pass of shrinking the map,
+// so the pass that clears each pixel picks its transparency
 void Render::coarse()
 {
   float soft_trans = 255;
   const int j = (3 << brush->coarse_edge);
-  float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
-  bool found = false;
+  const float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+  std::vector<int> level;
+  bool fill = false;
 
   for (int i = 0; i < j; i++)
   {
-    for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
-    {
-      for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
-      {
-        unsigned char *s0 = map->row[y] + x;
-        unsigned char *s1 = map->row[y] + x + 1;
-        unsigned char *s2 = map->row[y + 1] + x;
-        unsigned char *s3 = map->row[y + 1] + x + 1;
-
-        *s0 &= 1;
-        *s1 &= 1;
-        *s2 &= 1;
-        *s3 &= 1;
-
-        if (*s0 | *s1 | *s2 | *s3)
-          found = true;
-
-        const unsigned char d0 = *s0;
-        const unsigned char d1 = *s1;
-        const unsigned char d2 = *s2;
-        const unsigned char d3 = *s3;
-
-        map->shrinkBlock(s0, s1, s2, s3);
+    level.push_back(soft_trans);
+    soft_trans -= soft_step;
 
-        if (!*s0 && d0)
-          bmp->setpixel(x, y, color, soft_trans);
-        if (!*s1 && d1)
-          bmp->setpixel(x + 1, y, color, soft_trans);
-        if (!*s2 && d2)
-          bmp->setpixel(x, y + 1, color, soft_trans);
-        if (!*s3 && d3)
-          bmp->setpixel(x + 1, y + 1, color, soft_trans);
-      }
+    // whatever is left gets the brush transparency
+    if (soft_trans < trans)
+    {
+      fill = true;
+      break;
     }
+  }
 
-    if (!found)
-      break;
+  std::vector<int> depth;
 
-    soft_trans -= soft_step;
+  if (!map->shrinkDepth(depth, x1, y1,
+                        x2, y2, level.size()))
+  {
+    return;
+  }
 
-    if (soft_trans < trans)
-    {
-      soft_trans = trans;
+  const int w = (x2 - x1) + 1;
 
-      for (int y = stroke->y1; y <= stroke->y2; y++)
-      {
-        for (int x = stroke->x1; x <= stroke->x2; x++)
-        {
-          if (map->getpixel(x, y))
-            bmp->setpixel(x, y, color, soft_trans);
-        }
-      }
+  for (int y = y1; y <= y2; y++)
+  {
+    const int *d = &depth[(y - y1) * w];
 
-      return;
+    for (int x = x1; x <= x2; x++)
+    {
+      if (d[x - x1] >= 0)
+        bmp->setpixel(x, y, color, level[d[x - x1]]);
     }
 
-    if (update(i) < 0)
+    if (fill)
+      span(y, trans, false);
+
+    if (update(y) < 0)
       break;
   }
 }
@@ -253,58 +385,28 @@ void Render::coarse()
 // fine airbrush
 void Render::fine()
 {
-  int count = 0;
+  std::vector<int> dist;
 
-  for (int y = stroke->y1; y <= stroke->y2; y++)
-  {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
-    {
-      if (map->getpixel(x, y) && isEdge(map, x, y))
-      {
-        stroke->edge_x[count] = x;
-        stroke->edge_y[count] = y;
-        count++;
+  // pixels at the sides of the map are not edges, so strokes don't
+  // fade out where they touch the side of the image
+  map->distance(dist, x1, y1, x2, y2, true);
 
-        if (count > 0xfffff)
-          break;
-      }
-    }
-  }
-
-  if (count == 0)
+  // no edges
+  if (dist[0] < 0)
     return;
 
-  KDtree::node_type test_node;
-  KDtree::node_type *root, *found;
-  std::vector<KDtree::node_type> points(count);
-
-  int best_distance;
+  const int w = (x2 - x1) + 1;
 
-  for (int i = 0; i < count; i++)
+  for (int y = y1; y <= y2; y++)
   {
-    points[i].x[0] = stroke->edge_x[i];
-    points[i].x[1] = stroke->edge_y[i];
-    points[i].x[2] = 0;
-  }
-
-  root = KDtree::build(&points[0], count, 0);
+    const int *d = &dist[(y - y1) * w];
 
-  for (int y = stroke->y1; y <= stroke->y2; y++)
-  {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
+    for (int x = x1; x <= x2; x++)
     {
       if (map->getpixel(x, y) == 0)
         continue;
 
-      test_node.x[0] = x;
-      test_node.x[1] = y;
-      test_node.x[2] = 0;
-      found = 0;
-      KDtree::nearest(root, &test_node, &found, &best_distance, 0);
-
-      const int zx = found->x[0];
-      const int zy = found->x[1];
-      const int t = fineEdge(x, y, zx, zy, brush->fine_edge, trans);
+      const int t = fineEdge(d[x - x1], brush->fine_edge, trans);
 
       bmp->setpixel(x, y, color, t);
     }
@@ -317,93 +419,17 @@ void Render::fine()
 // gaussian blur
 void Render::blur()
 {
-  const int w = (stroke->x2 - stroke->x1) + 1;
-  const int h = (stroke->y2 - stroke->y1) + 1;
-
-  Map temp(w, h);
-  temp.clear(0);
-
   const int amount = (brush->blurry_edge + 2) * (brush->blurry_edge + 2) + 1;
 
-  std::vector<int> kernel(amount);
-  const int b = amount / 2;
-
-  for (int x = 0; x < amount; x++)
-  {
-    const int xb = x - b;
-
-    kernel[x] = 255 * std::exp(-((double)((xb) * (xb)) / ((b * b) / 2)));
-  }
-
-  // x direction
-  for (int y = 0; y < h; y++)
-  {
-    const int y1 = y + stroke->y1;
-
-    for (int x = -b; x < w + b; x++)
-    {
-      int xx = stroke->x1 + x - b;
-      int val = 0;
-      int div = 0;
-
-      for (int i = 0; i < amount; i++)
-      {
-        if (xx >= 0 && xx < map->w)
-        {
-          val += *(map->row[y1] + xx) * kernel[i];
-          div += kernel[i];
-        }
-
-        xx++;
-      }
-
-      if (div > 0)
-        val /= div;
-
-      temp.setpixel(x, y, val);
-    }
-  }
-
-  // y direction
-  for (int y = -b; y < h + b; y++)
-  {
-    for (int x = 0; x < w; x++)
-    {
-      int yy = y - b;
-      int val = 0;
-      int div = 0;
-
-      for (int i = 0; i < amount; i++)
-      {
-        if (yy >= 0 && yy < h)
-        {
-          val += *(temp.row[yy] + x) * kernel[i];
-          div += kernel[i];
-        }
-
-        yy++;
-      }
-
-      if (div > 0)
-        val /= div;
-
-      const int x1 = x + stroke->x1;
-      const int y1 = y + stroke->y1;
-
-      map->setpixel(x1, y1, val);
-    }
-  }
+  // the kernel used to be cut off at two deviations (amount / 2), which
+  // makes it narrower than the full gaussian
+  map->blur(x1, y1, x2, y2,
+            (amount / 2) * 0.44f);
 
   // render
-  for (int y = stroke->y1; y <= stroke->y2; y++)
+  for (int y = y1; y <= y2; y++)
   {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
-    {
-      const int c = map->getpixel(x, y);
-
-      if (c > 0)
-        bmp->setpixel(x, y, color, scaleVal((255 - c), trans));
-    }
+    span(y, trans, true);
 
     if (update(y) < 0)
       break;
@@ -411,97 +437,81 @@ void Render::blur()
 }
 
 // watercolor
+// the color bleeds outward, fading with the distance from the stroke;
+// the spread used to come from randomly grown 2x2 blocks, which took
+// about 1.2 passes per pixel of distance and got more ragged the further
+// out it went, so the same is done here with random offsets shared by
+// 2x4 blocks (giving the streaky edge) plus a little per pixel
 void Render::watercolor()
 {
   float soft_trans = trans;
   const int j = (2 << brush->watercolor_edge);
-  float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
-  bool found = false;
-  int inc = 0;
-
-  for (int y = stroke->y1; y <= stroke->y2; y++)
-  {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
-    {
-      if (map->getpixel(x, y))
-        bmp->setpixel(x, y, color, trans);
-    }
-  }
+  const float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+  std::vector<int> level;
 
   for (int i = 0; i < j; i++)
   {
-    inc++;
+    level.push_back(soft_trans);
+    soft_trans += soft_step;
 
-    for (int y = stroke->y1 + (inc & 1); y < stroke->y2 - 1; y += 2)
-    {
-      for (int x = stroke->x1 + (inc & 1); x < stroke->x2 - 1; x += 2)
-      {
-        int yy = y + !(rnd() & 3);
+    if (soft_trans > 255)
+      break;
+  }
 
-        unsigned char *s0 = map->row[yy] + x;
-        unsigned char *s1 = map->row[yy] + x + 1;
-        unsigned char *s2 = map->row[yy + 1] + x;
-        unsigned char *s3 = map->row[yy + 1] + x + 1;
+  for (int y = y1; y <= y2; y++)
+    span(y, trans, false);
 
-        *s0 &= 1;
-        *s1 &= 1;
-        *s2 &= 1;
-        *s3 &= 1;
+  std::vector<int> dist;
 
-        if (*s0 | *s1 | *s2 | *s3)
-          found = true;
+  map->distance(dist, x1, y1, x2, y2);
 
-        const unsigned char d0 = *s0;
-        const unsigned char d1 = *s1;
-        const unsigned char d2 = *s2;
-        const unsigned char d3 = *s3;
+  // no edges
+  if (dist[0] < 0)
+    return;
 
-        map->growBlock(s0, s1, s2, s3);
+  const int w = (x2 - x1) + 1;
+  std::vector<float> noise((w >> 1) + 1);
 
-        if (*s0 & (!(rnd() & 15)))
-        {
-          *s0 = 1;
-          *s1 = 1;
-          *s2 = 1;
-          *s3 = 1;
-          inc--;
-          inc--;
-        }
+  for (int y = y1; y <= y2; y++)
+  {
+    if (((y - y1) & 3) == 0)
+    {
+      for (float &n : noise)
+        n = (rnd() & 255) / 127.5f - 1.0f;
+    }
 
-        if (*s0 && !d0)
-          bmp->setpixel(x, yy, color, soft_trans);
+    const int *d = &dist[(y - y1) * w];
+    const unsigned char *p = map->row[y];
 
-        if (*s1 && !d1)
-          bmp->setpixel(x + 1, yy, color, soft_trans);
+    for (int x = x1; x <= x2; x++)
+    {
+      if (p[x])
+        continue;
 
-        if (*s2 && !d2)
-          bmp->setpixel(x, yy + 1, color, soft_trans);
+      const float dd = std::sqrt(d[x - x1]);
+      const float r = noise[(x - x1) >> 1] * 0.75f +
+                      ((rnd() & 255) / 127.5f - 1.0f) * 0.25f;
+      const int pass = dd * 1.2f + r * (0.6f + 0.25f * dd);
 
-        if (*s3 && !d3)
-          bmp->setpixel(x + 1, yy + 1, color, soft_trans);
-      }
+      if (pass < (int)level.size())
+        bmp->setpixel(x, y, color, level[std::max(pass, 0)]);
     }
 
-    if (!found)
-      break;
-
-    soft_trans += soft_step;
-
-    if (soft_trans > 255)
-      break;
-
-    if (update(i) < 0)
+    if (update(y) < 0)
       break;
   }
 }
 
 // chalk
+// same as the coarse airbrush, but every pixel gets a random transparency
+// around the value for its pass
 void Render::chalk()
 {
   float soft_trans = 255;
   int j = (3 << brush->chalk_edge);
-  float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
-  bool found = false;
+  const float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
+  std::vector<int> level;
+  bool fill = false;
 
   if (brush->chalk_edge == 0)
   {
@@ -511,122 +521,66 @@ void Render::chalk()
 
   for (int i = 0; i < j; i++)
   {
-    for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
-    {
-      for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
-      {
-        unsigned char *s0 = map->row[y] + x;
-        unsigned char *s1 = map->row[y] + x + 1;
-        unsigned char *s2 = map->row[y + 1] + x;
-        unsigned char *s3 = map->row[y + 1] + x + 1;
-
-        *s0 &= 1;
-        *s1 &= 1;
-        *s2 &= 1;
-        *s3 &= 1;
-
-        if (*s0 | *s1 | *s2 | *s3)
-          found = true;
-
-        unsigned char d0 = *s0;
-        unsigned char d1 = *s1;
-        unsigned char d2 = *s2;
-        unsigned char d3 = *s3;
-
-        map->shrinkBlock(s0, s1, s2, s3);
-
-        int t = 0;
-
-        if (!*s0 && d0)
-        {
-          t = (int)soft_trans + (rnd() & 63) - 32;
-
-          if (t < 0)
-            t = 0;
-
-          if (t > 255)
-            t = 255;
-
-          bmp->setpixel(x, y, color, t);
-        }
-
-        if (!*s1 && d1)
-        {
-          t = (int)soft_trans + (rnd() & 63) - 32;
-
-          if (t < 0)
-            t = 0;
-
-          if (t > 255)
-            t = 255;
-
-          bmp->setpixel(x + 1, y, color, t);
-        }
-
-        if (!*s2 && d2)
-        {
-          t = (int)soft_trans + (rnd() & 63) - 32;
-
-          if (t < 0)
-            t = 0;
-
-          if (t > 255)
-            t = 255;
-
-          bmp->setpixel(x, y + 1, color, t);
-        }
-
-        if (!*s3 && d3)
-        {
-          t = (int)soft_trans + (rnd() & 63) - 32;
+    level.push_back(soft_trans);
+    soft_trans -= soft_step;
 
-          if (t < 0)
-            t = 0;
+    // whatever is left gets the brush transparency
+    if (soft_trans < trans)
+    {
+      fill = true;
+      break;
+    }
+  }
 
-          if (t > 255)
-            t = 255;
+  std::vector<int> depth;
 
-          bmp->setpixel(x + 1, y + 1, color, t);
-        }
-      }
-    }
+  if (!map->shrinkDepth(depth, x1, y1,
+                        x2, y2, level.size()))
+  {
+    return;
+  }
 
-    if (!found)
-      break;
+  const int w = (x2 - x1) + 1;
 
-    soft_trans -= soft_step;
+  for (int y = y1; y <= y2; y++)
+  {
+    const int *d = &depth[(y - y1) * w];
+    const unsigned char *p = map->row[y];
 
-    if (soft_trans < trans)
+    for (int x = x1; x <= x2; x++)
     {
-      soft_trans = trans;
+      int t;
 
-      for (int y = stroke->y1; y <= stroke->y2; y++)
-      {
-        for (int x = stroke->x1; x <= stroke->x2; x++)
-        {
-          if (map->getpixel(x, y))
-          {
-            int t = (int)soft_trans + (rnd() & 63) - 32;
+      if (d[x - x1] >= 0)
+        t = level[d[x - x1]];
+      else if (fill && p[x])
+        t = trans;
+      else
+        continue;
 
-            if (t < 0)
-              t = 0;
+      t += (rnd() & 63) - 32;
 
-            if (t > 255)
-              t = 255;
+      if (t < 0)
+        t = 0;
 
-            bmp->setpixel(x, y, color, t);
-          }
-        }
-      }
+      if (t > 255)
+        t = 255;
 
-      return;
+      bmp->setpixel(x, y, color, t);
     }
 
-    if (update(i) < 0)
+    if (update(y) < 0)
       break;
   }
 }
 
+// start making the texture for the current brush settings in the
+// background, so it is ready by the time a stroke needs it
+void Render::prepareTexture(const Brush *b)
+{
+  requestTexture(textureKey(b));
+}
+
 // texture
 void Render::texture()
 {
@@ -634,20 +588,10 @@ void Render::texture()
   int j = (3 << brush->texture_edge);
   float soft_step = (float)(255 - trans) / ((j >> 1) + 1);
 
-  int w = 256;
-  int h = 256;
-
-  Map plasma(w, h);
-  Map marble(w, h);
-  Map marbx(w, h);
-  Map marby(w, h);
-
-  Fractal::plasma(&plasma, (brush->texture_turb + 1) << 10);
-  Fractal::plasma(&marbx, (brush->texture_turb + 1) << 10);
-  Fractal::plasma(&marby, (brush->texture_turb + 1) << 10);
-  Fractal::marble(&plasma, &marble, &marbx, &marby, brush->texture_marb << 2, 100, 0);
-
-  Map *src = &marble;
+  std::shared_ptr<Map> texture = findTexture(textureKey(brush));
+  Map *src = texture.get();
+  const int w = src->w;
+  const int h = src->h;
 
   if (brush->texture_edge == 0)
   {
@@ -667,9 +611,9 @@ void Render::texture()
 
     bool found = false;
 
-    for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
+    for (int y = y1 + (i & 1); y < y2; y += 2)
     {
-      for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
+      for (int x = x1 + (i & 1); x < x2; x += 2)
       {
         unsigned char *s0 = map->row[y] + x;
         unsigned char *s1 = map->row[y] + x + 1;
@@ -729,9 +673,9 @@ void Render::texture()
       break;
   }
 
-  for (int y = stroke->y1; y <= stroke->y2; y++)
+  for (int y = y1; y <= y2; y++)
   {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
+    for (int x = x1; x <= x2; x++)
     {
       if (map->getpixel(x, y))
       {
@@ -750,9 +694,9 @@ void Render::average()
   int b = 0;
   int count = 0;
 
-  for (int y = stroke->y1; y <= stroke->y2; y++)
+  for (int y = y1; y <= y2; y++)
   {
-    for (int x = stroke->x1; x <= stroke->x2; x++)
+    for (int x = x1; x <= x2; x++)
     {
       if (map->getpixel(x, y) > 0)
       {
@@ -789,9 +733,9 @@ void Render::average()
 
   for (int i = 0; i < j; i++)
   {
-    for (int y = stroke->y1 + (i & 1); y < stroke->y2; y += 2)
+    for (int y = y1 + (i & 1); y < y2; y += 2)
     {
-      for (int x = stroke->x1 + (i & 1); x < stroke->x2; x += 2)
+      for (int x = x1 + (i & 1); x < x2; x += 2)
       {
         unsigned char *s0 = map->row[y] + x;
         unsigned char *s1 = map->row[y] + x + 1;
@@ -836,9 +780,9 @@ void Render::average()
     {
       soft_trans = trans;
 
-      for (int y = stroke->y1; y <= stroke->y2; y++)
+      for (int y = y1; y <= y2; y++)
       {
-        for (int x = stroke->x1; x <= stroke->x2; x++)
+        for (int x = x1; x <= x2; x++)
         {
           if (map->getpixel(x, y))
             bmp->setpixel(x, y, average, soft_trans);
@@ -853,54 +797,11 @@ void Render::average()
   }
 }
 
-// start the rendering process
-void Render::begin()
+// renders the map onto the bitmap over x1, y1, x2, y2 in one of the
+// modes above, using the color, transparency and brush set beforehand
+void Render::draw(const int mode)
 {
-  view = Gui::getView();
-  bmp = Project::bmp;
-  map = Project::map;
-  brush = Project::brush;
-  stroke = Project::stroke;
-  color = brush->color;
-  trans = brush->trans;
-
-  int size = 1;
-
-  // for tools that grow outward
-//  switch (Gui::getPaintMode())
-  switch (Gui::paint->getMode())
-  {
-    case BLURRY:
-      size = (3 << brush->blurry_edge);
-      break;
-    case WATERCOLOR:
-      size = (3 << brush->watercolor_edge);
-      break;
-  }
-
-  stroke->x1 -= size;
-  stroke->y1 -= size;
-  stroke->x2 += size;
-  stroke->y2 += size;
-  stroke->clip();
-
-  stroke->makeBlitRect(stroke->x1, stroke->y1,
-                       stroke->x2, stroke->y2,
-                       view->ox, view->oy, 1, view->zoom);
-
-  const int x = stroke->x1;
-  const int y = stroke->y1;
-  const int w = (stroke->x2 - stroke->x1) + 1;
-  const int h = (stroke->y2 - stroke->y1) + 1;
-
-  if (w <= 0 || h <= 0)
-    return; 
-
-  Project::undo->push(x, y, w, h, 0);
-
-  view->rendering = true;
-
-  switch (Gui::paint->getMode())
+  switch (mode)
   {
     case SOLID:
       solid();
@@ -932,9 +833,11 @@ void Render::begin()
     default:
       break;
   }
-
-  Project::map->clear(0);
-  view->drawMain(true);
-  view->rendering = false;
 }
 
+// sets where the random edges of the watercolor and chalk modes start,
+// so a stroke can be rendered the same way twice
+void Render::seed(const int value)
+{
+  rnd_seed = value;
+}
@@ -251,6 +251,7 @@ void Selection::paste(View *view)
   }
 
   Blend::set(Blend::TRANS);
+  view->invalidate(x1, y1, x1 + w - 1, y1 + h - 1);
   view->drawMain(true);
 }
 
@@ -243,14 +243,8 @@ void Stroke::drawBrushLine(int x1, int y1, int x2, int y2, int c)
   Brush *brush = Project::brush;
   Map *map = Project::map;
 
-  drawBrush(x1, y1, c);
-  drawBrush(x2, y2, c);
-
-  for (int i = 0; i < brush->hollow_count; i++)
-  {
-    map->line(x1 + brush->hollowx[i], y1 + brush->hollowy[i],
-              x2 + brush->hollowx[i], y2 + brush->hollowy[i], c);
-  }
+  map->sweep(x1, y1, x2, y2, brush->spanx1, brush->spanx2,
+             brush->span_y, brush->span_count, c);
 }
 
 void Stroke::drawBrushRect(int x1, int y1, int x2, int y2, int c)
@@ -303,13 +297,8 @@ void Stroke::drawBrushLineAA(int x1, int y1, int x2, int y2, int c)
   Brush *brush = Project::brush;
   Map *map = Project::map;
 
-  for (int i = 0; i < brush->solid_count; i++)
-  {
-    map->lineAA(x1 + brush->solidx[i],
-                y1 + brush->solidy[i],
-                x2 + brush->solidx[i],
-                y2 + brush->solidy[i], c);
-  }
+  map->sweepAA(x1, y1, x2, y2, brush->spanx1, brush->spanx2,
+               brush->span_y, brush->span_count, c);
 }
 
 void Stroke::drawBrushRectAA(int x1, int y1, int x2, int y2, int c)
@@ -609,7 +598,7 @@ void Stroke::end(int x, int y)
   int w = 0, h = 0;
 
   map->thick_aa = 0;
-  Clone::refresh(x1, y1, x2, y2);
+  Clone::refresh(Project::bmp, x1, y1, x2, y2);
 
   if (brush->aa)
   {
@@ -65,7 +65,8 @@ void Text::push(View *view)
   move(view);
   Project::undo->push();
   Clone::move(view->imgx, view->imgy);
-  Clone::refresh(stroke->x1, stroke->y1, stroke->x2, stroke->y2);
+  Clone::refresh(Project::bmp,
+                 stroke->x1, stroke->y1, stroke->x2, stroke->y2);
 
   // write text string to FLTK's offscreen image
   int index = FontPreview::getFont();
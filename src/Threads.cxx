@@ -0,0 +1,316 @@
+/*
+Copyright (c) 2026 Joe Davisson.
+
+This file is part of Rendera.
+
+Rendera is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Rendera is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Rendera; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+// Row-band scheduler used by filters and other full-image operations.
+//
+// The rows of a job are split into bands. Each thread starts with its own
+// contiguous run of bands (so neighbouring rows stay on the same core) and
+// when that runs out it steals the back half of another thread's run.
+// The calling thread takes part in the work and is the only one that
+// touches the progress bar, so FLTK is never called from a worker.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Progress.H"
+#include "Threads.H"
+
+namespace
+{
+  struct range_type
+  {
+    std::mutex lock;
+    int begin { 0 };
+    int end { 0 };
+  };
+
+  // never destroyed, since workers may still be waiting on it at exit
+  struct pool_type
+  {
+    std::vector<std::thread> workers;
+    std::unique_ptr<range_type[]> ranges;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    int generation { 0 };
+    int active { 0 };
+  };
+
+  std::once_flag started;
+  pool_type *pool = 0;
+
+  // current job
+  const std::function<void (int)> *job_kernel = 0;
+  int job_top = 0;
+  int job_bottom = 0;
+  int job_band = 1;
+  std::atomic<int> rows_done(0);
+  std::atomic<bool> cancelled(false);
+  std::atomic<bool> busy(false);
+
+  thread_local bool is_worker = false;
+
+  // claim the next band from our own run, or steal from another thread
+  bool takeBand(const int self, int *band)
+  {
+    const int participants = pool->workers.size() + 1;
+
+    {
+      std::lock_guard<std::mutex> guard(pool->ranges[self].lock);
+
+      if (pool->ranges[self].begin < pool->ranges[self].end)
+      {
+        *band = pool->ranges[self].begin++;
+        return true;
+      }
+    }
+
+    for (int i = 1; i < participants; i++)
+    {
+      range_type &victim = pool->ranges[(self + i) % participants];
+      int begin, end;
+
+      {
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        const int remaining = victim.end - victim.begin;
+
+        if (remaining <= 0)
+          continue;
+
+        // take the back half, leaving the victim its front rows
+        begin = victim.end - (remaining + 1) / 2;
+        end = victim.end;
+        victim.end = begin;
+      }
+
+      std::lock_guard<std::mutex> guard(pool->ranges[self].lock);
+
+      *band = begin;
+      pool->ranges[self].begin = begin + 1;
+      pool->ranges[self].end = end;
+      return true;
+    }
+
+    return false;
+  }
+
+  void work(const int self)
+  {
+    int band;
+
+    while (!cancelled && takeBand(self, &band))
+    {
+      const int y1 = job_top + band * job_band;
+      const int y2 = std::min(y1 + job_band - 1, job_bottom);
+
+      for (int y = y1; y <= y2; y++)
+        (*job_kernel)(y);
+
+      rows_done += y2 - y1 + 1;
+    }
+  }
+
+  void workerLoop(const int self)
+  {
+    is_worker = true;
+
+    int seen = 0;
+
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> guard(pool->lock);
+        pool->wake.wait(guard, [&] { return pool->generation != seen; });
+        seen = pool->generation;
+      }
+
+      work(self);
+
+      {
+        std::lock_guard<std::mutex> guard(pool->lock);
+
+        if (--pool->active == 0)
+          pool->finished.notify_all();
+      }
+    }
+  }
+
+  void startWorkers()
+  {
+    int max = std::thread::hardware_concurrency();
+
+    // the calling thread is also used, so leave a core for it
+    max = std::clamp(max - 1, 0, 63);
+    pool = new pool_type;
+    pool->ranges.reset(new range_type[max + 1]);
+
+    for (int i = 0; i < max; i++)
+    {
+      // workers live for the whole session, OS cleans up on exit
+      pool->workers.emplace_back(workerLoop, i + 1);
+      pool->workers.back().detach();
+    }
+  }
+}
+
+// starts the worker threads (otherwise started on first use)
+void Threads::init()
+{
+  std::call_once(started, startWorkers);
+}
+
+// number of threads that take part in a job, including the caller
+int Threads::count()
+{
+  init();
+  return pool->workers.size() + 1;
+}
+
+// calls kernel(y) for each row from top to bottom (inclusive) in parallel,
+// updating the progress bar as rows finish
+// returns -1 if the user cancelled, in which case some rows may be undone
+int Threads::rows(const int top, const int bottom,
+                  const std::function<void (int)> &kernel)
+{
+  return schedule(top, bottom, kernel, true);
+}
+
+// same as above without progress or cancellation
+void Threads::run(const int top, const int bottom,
+                  const std::function<void (int)> &kernel)
+{
+  schedule(top, bottom, kernel, false);
+}
+
+int Threads::schedule(const int top, const int bottom,
+                      const std::function<void (int)> &kernel,
+                      const bool show_progress)
+{
+  if (bottom < top)
+    return 0;
+
+  init();
+
+  const int participants = pool->workers.size() + 1;
+  const int height = bottom - top + 1;
+
+  // nested calls and single-core systems run on the calling thread
+  if (is_worker || participants == 1 || height == 1 || busy.exchange(true))
+  {
+    for (int y = top; y <= bottom; y++)
+    {
+      kernel(y);
+
+      if (show_progress && Progress::update(y) < 0)
+        return -1;
+    }
+
+    return 0;
+  }
+
+  // several bands per thread so stealing can even out uneven rows
+  job_band = std::clamp(height / (participants * 8), 1, 64);
+  job_kernel = &kernel;
+  job_top = top;
+  job_bottom = bottom;
+  rows_done = 0;
+  cancelled = false;
+
+  const int bands = (height + job_band - 1) / job_band;
+
+  for (int i = 0; i < participants; i++)
+  {
+    std::lock_guard<std::mutex> guard(pool->ranges[i].lock);
+
+    pool->ranges[i].begin = (long long)bands * i / participants;
+    pool->ranges[i].end = (long long)bands * (i + 1) / participants;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(pool->lock);
+
+    pool->active = pool->workers.size();
+    pool->generation++;
+  }
+
+  pool->wake.notify_all();
+
+  int reported = 0;
+
+  // progress has to be reported from this thread
+  auto report = [&]()
+  {
+    if (!show_progress || cancelled)
+      return;
+
+    const int done = rows_done;
+
+    while (reported < done)
+    {
+      if (Progress::update(top + reported) < 0)
+      {
+        cancelled = true;
+        return;
+      }
+
+      reported++;
+    }
+  };
+
+  int band;
+
+  while (!cancelled && takeBand(0, &band))
+  {
+    const int y1 = top + band * job_band;
+    const int y2 = std::min(y1 + job_band - 1, bottom);
+
+    for (int y = y1; y <= y2; y++)
+      kernel(y);
+
+    rows_done += y2 - y1 + 1;
+    report();
+  }
+
+  {
+    std::unique_lock<std::mutex> guard(pool->lock);
+
+    while (pool->active > 0)
+    {
+      pool->finished.wait_for(guard, std::chrono::milliseconds(10));
+      guard.unlock();
+      report();
+      guard.lock();
+    }
+  }
+
+  report();
+  job_kernel = 0;
+  busy = false;
+
+  return cancelled ? -1 : 0;
+}
+
@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "InputFloat.H"
 #include "InputInt.H"
 #include "Map.H"
+#include "Progress.H"
 #include "Project.H"
 #include "Transform.H"
 #include "Undo.H"
@@ -177,7 +178,12 @@ namespace Scale
 
   void do_blur(Bitmap *bmp, float blur_size, float blur_blend)
   {
-    GaussianBlur::apply(bmp, blur_size, blur_blend, 0);
+    GaussianBlur::params_type params;
+
+    params.size = blur_size;
+    params.blend = blur_blend;
+    params.mode = 0;
+    GaussianBlur::apply(*bmp, *bmp, params);
   }
 
   float cubic(const float f[4], const float t)
@@ -205,238 +211,16 @@ namespace Scale
 
   void apply(const int dw, const int dh, const bool wrap_edges)
   {
-    Bitmap *bmp = Project::bmp;
-    const int sx = 0;
-    const int sy = 0;
-    const int sw = bmp->cw;
-    const int sh = bmp->ch;
-    const int dx = 0;
-    const int dy = 0;
-
-    if (sw < 1 || sh < 1)
-      return;
-
-    if (dw < 1 || dh < 1)
-      return;
-
     // check memory
     if (Project::enoughMemory(dw, dh) == false)
       return;
 
-    Bitmap *temp = new Bitmap(dw, dh);
-
-    const float ax = ((float)sw / dw);
-    const float ay = ((float)sh / dh);
-
-    float scale_x = 0, scale_y = 0;
-
-    if (dw < sw)
-      scale_x = (float)sw / dw;
-
-    if (dh < sh)
-      scale_y = (float)sh / dh;
-
-    float scale = scale_x > scale_y ? scale_x : scale_y;
-
-    float s = 0.5 - std::sqrt(scale);
-    float blur_size = std::sqrt(4.0 * (s * s) + 1);
-    float blur_blend = 0;
-
-    if (blur_size < 2)
-    {
-      const float frac = blur_size - (int)blur_size;
-
-      blur_blend = 255 - frac * 255;
-    }
-
-    bool blur = false;
-
-    if (blur_size > 1.0 && (dw < sw || dh < sh))
-      blur = true;
-
-    if (Items::mode->value() == 0)
-    {
-      // nearest
-      for (int y = 0; y < dh; y++) 
-      {
-        int *d = temp->row[dy + y] + dx;
-        const int yy = y * ay;
-
-        for (int x = 0; x < dw; x++) 
-        {
-          const int xx = x * ax;
-
-          *d++ = *(bmp->row[yy + sy] + xx + sx);
-        }
-      }
-    }
-    else if (Items::mode->value() == 1)
-    {
-      // bilinear
-      if (blur)
-        do_blur(bmp, blur_size, blur_blend);
-
-      Progress::show(dh);
-
-      for (int y = 0; y < dh; y++) 
-      {
-        int *d = temp->row[dy + y] + dx;
-        const float vv = (y * ay);
-        const int v1 = vv;
-        const float v = vv - v1;
-
-        if (sy + v1 >= bmp->h - 1)
-          break;
-
-        int v2 = v1 + 1;
-
-        if (v2 >= sh)
-        {
-          if (wrap_edges)
-            v2 -= sh;
-          else
-            v2--;
-        }
-
-        int *c[4];
-
-        c[0] = c[1] = bmp->row[sy + v1] + sx;
-        c[2] = c[3] = bmp->row[sy + v2] + sx;
-
-        for (int x = 0; x < dw; x++) 
-        {
-          const float uu = (x * ax);
-          const int u1 = uu;
-          const float u = uu - u1;
-
-          if (sx + u1 >= bmp->w - 1)
-            break;
-
-          int u2 = u1 + 1;
-
-          if (u2 >= sw)
-          {
-            if (wrap_edges)
-              u2 -= sw;
-            else
-              u2--;
-          }
+    Bitmap *temp = Transform::scaleImage(Project::bmp, dw, dh,
+                                         Items::mode->value(), wrap_edges);
 
-          c[0] += u1;
-          c[1] += u2;
-          c[2] += u1;
-          c[3] += u2;
-
-          float f[4];
-
-          f[0] = (1.0f - u) * (1.0f - v);
-          f[1] = u * (1.0f - v);
-          f[2] = (1.0f - u) * v;
-          f[3] = u * v;
-
-          float r = 0, g = 0, b = 0, a = 0;
-
-          for (int i = 0; i < 4; i++)
-          {
-            rgba_type rgba = getRgba(*c[i]);
-            r += (float)Gamma::fix(rgba.r) * f[i];
-            g += (float)Gamma::fix(rgba.g) * f[i];
-            b += (float)Gamma::fix(rgba.b) * f[i];
-            a += rgba.a * f[i];
-          }
-
-          r = Gamma::unfix((int)r);
-          g = Gamma::unfix((int)g);
-          b = Gamma::unfix((int)b);
-
-          *d++ = makeRgba((int)r, (int)g, (int)b, (int)a);
-
-          c[0] -= u1;
-          c[1] -= u2;
-          c[2] -= u1;
-          c[3] -= u2;
-        }
-
-        if (Progress::update(y) < 0)
-          break;
-      }
-    }
-    else if (Items::mode->value() == 2)
-    {
-      if (blur)
-        do_blur(bmp, blur_size, blur_blend);
-
-      // bicubic
-      float r[4][4];
-      float g[4][4];
-      float b[4][4];
-      float a[4][4];
-
-      Progress::show(dh);
-
-      for (int y = 0; y < dh; y++) 
-      {
-        int *d = temp->row[dy + y] + dx;
-
-        const float vv = (y * ay);
-        const int v1 = vv;
-        const float v = vv - v1;
-
-        for (int x = 0; x < dw; x++) 
-        {
-          const float uu = (x * ax);
-          const int u1 = uu;
-          const float u = uu - u1;
-
-          for (int j = 0; j < 4; j++)
-          {
-            int yy = v1 + j - 1;
-
-            if (wrap_edges)
-            {
-              if (yy >= sh)
-                yy -= sh;
-            }
-
-            if (yy > sh - 1)
-              yy = sh - 1;
-
-            for (int i = 0; i < 4; i++)
-            {
-              int xx = u1 + i - 1;
-
-              if (wrap_edges)
-              {
-                if (xx >= sw)
-                  xx -= sw;
-              }
-
-              if (xx > sw - 1)
-                xx = sw - 1;
-
-              rgba_type rgba = getRgba(bmp->getpixel(sx + xx, sy + yy));
-
-              r[i][j] = Gamma::fix(rgba.r);
-              g[i][j] = Gamma::fix(rgba.g);
-              b[i][j] = Gamma::fix(rgba.b);
-              a[i][j] = Gamma::fix(rgba.a);
-            }
-          }
-
-          const int rr = Gamma::unfix(clamp(bicubic(r, u, v), 65535));
-          const int gg = Gamma::unfix(clamp(bicubic(g, u, v), 65535));
-          const int bb = Gamma::unfix(clamp(bicubic(b, u, v), 65535));
-          const int aa = Gamma::unfix(clamp(bicubic(a, u, v), 65535));
-
-          *d++ = makeRgba(rr, gg, bb, aa);
-        }
-
-        if (Progress::update(y) < 0)
-          break;
-      }
-    }
+    if (!temp)
+      return;
 
-    Progress::hide();
     Project::replaceImageFromBitmap(temp);
 
     Gui::getView()->ox = 0;
@@ -444,6 +228,7 @@ namespace Scale
     Gui::getView()->drawMain(true);
   }
 
+
   void begin()
   {
     Items::width->value(Project::bmp->cw);
@@ -755,6 +540,242 @@ namespace RotateArbitrary
   }
 }
 
+// scale to a new bitmap (0 = nearest, 1 = bilinear, 2 = bicubic), when
+// shrinking the source is blurred first so it must be writable
+Bitmap *Transform::scaleImage(Bitmap *bmp, const int dw, const int dh,
+                              const int mode, const bool wrap_edges)
+{
+  const int sx = 0;
+  const int sy = 0;
+  const int sw = bmp->cw;
+  const int sh = bmp->ch;
+  const int dx = 0;
+  const int dy = 0;
+
+  if (sw < 1 || sh < 1)
+    return 0;
+
+  if (dw < 1 || dh < 1)
+    return 0;
+
+  Bitmap *temp = new Bitmap(dw, dh);
+
+  const float ax = ((float)sw / dw);
+  const float ay = ((float)sh / dh);
+
+  float scale_x = 0, scale_y = 0;
+
+  if (dw < sw)
+    scale_x = (float)sw / dw;
+
+  if (dh < sh)
+    scale_y = (float)sh / dh;
+
+  float scale = scale_x > scale_y ? scale_x : scale_y;
+
+  float s = 0.5 - std::sqrt(scale);
+  float blur_size = std::sqrt(4.0 * (s * s) + 1);
+  float blur_blend = 0;
+
+  if (blur_size < 2)
+  {
+    const float frac = blur_size - (int)blur_size;
+
+    blur_blend = 255 - frac * 255;
+  }
+
+  bool blur = false;
+
+  if (blur_size > 1.0 && (dw < sw || dh < sh))
+    blur = true;
+
+  if (mode == 0)
+  {
+    // nearest
+    for (int y = 0; y < dh; y++) 
+    {
+      int *d = temp->row[dy + y] + dx;
+      const int yy = y * ay;
+
+      for (int x = 0; x < dw; x++) 
+      {
+        const int xx = x * ax;
+
+        *d++ = *(bmp->row[yy + sy] + xx + sx);
+      }
+    }
+  }
+  else if (mode == 1)
+  {
+    // bilinear
+    if (blur)
+      Scale::do_blur(bmp, blur_size, blur_blend);
+
+    Progress::show(dh);
+
+    for (int y = 0; y < dh; y++) 
+    {
+      int *d = temp->row[dy + y] + dx;
+      const float vv = (y * ay);
+      const int v1 = vv;
+      const float v = vv - v1;
+
+      if (sy + v1 >= bmp->h - 1)
+        break;
+
+      int v2 = v1 + 1;
+
+      if (v2 >= sh)
+      {
+        if (wrap_edges)
+          v2 -= sh;
+        else
+          v2--;
+      }
+
+      int *c[4];
+
+      c[0] = c[1] = bmp->row[sy + v1] + sx;
+      c[2] = c[3] = bmp->row[sy + v2] + sx;
+
+      for (int x = 0; x < dw; x++) 
+      {
+        const float uu = (x * ax);
+        const int u1 = uu;
+        const float u = uu - u1;
+
+        if (sx + u1 >= bmp->w - 1)
+          break;
+
+        int u2 = u1 + 1;
+
+        if (u2 >= sw)
+        {
+          if (wrap_edges)
+            u2 -= sw;
+          else
+            u2--;
+        }
+
+        c[0] += u1;
+        c[1] += u2;
+        c[2] += u1;
+        c[3] += u2;
+
+        float f[4];
+
+        f[0] = (1.0f - u) * (1.0f - v);
+        f[1] = u * (1.0f - v);
+        f[2] = (1.0f - u) * v;
+        f[3] = u * v;
+
+        float r = 0, g = 0, b = 0, a = 0;
+
+        for (int i = 0; i < 4; i++)
+        {
+          rgba_type rgba = getRgba(*c[i]);
+          r += (float)Gamma::fix(rgba.r) * f[i];
+          g += (float)Gamma::fix(rgba.g) * f[i];
+          b += (float)Gamma::fix(rgba.b) * f[i];
+          a += rgba.a * f[i];
+        }
+
+        r = Gamma::unfix((int)r);
+        g = Gamma::unfix((int)g);
+        b = Gamma::unfix((int)b);
+
+        *d++ = makeRgba((int)r, (int)g, (int)b, (int)a);
+
+        c[0] -= u1;
+        c[1] -= u2;
+        c[2] -= u1;
+        c[3] -= u2;
+      }
+
+      if (Progress::update(y) < 0)
+        break;
+    }
+  }
+  else if (mode == 2)
+  {
+    if (blur)
+      Scale::do_blur(bmp, blur_size, blur_blend);
+
+    // bicubic
+    float r[4][4];
+    float g[4][4];
+    float b[4][4];
+    float a[4][4];
+
+    Progress::show(dh);
+
+    for (int y = 0; y < dh; y++) 
+    {
+      int *d = temp->row[dy + y] + dx;
+
+      const float vv = (y * ay);
+      const int v1 = vv;
+      const float v = vv - v1;
+
+      for (int x = 0; x < dw; x++) 
+      {
+        const float uu = (x * ax);
+        const int u1 = uu;
+        const float u = uu - u1;
+
+        for (int j = 0; j < 4; j++)
+        {
+          int yy = v1 + j - 1;
+
+          if (wrap_edges)
+          {
+            if (yy >= sh)
+              yy -= sh;
+          }
+
+          if (yy > sh - 1)
+            yy = sh - 1;
+
+          for (int i = 0; i < 4; i++)
+          {
+            int xx = u1 + i - 1;
+
+            if (wrap_edges)
+            {
+              if (xx >= sw)
+                xx -= sw;
+            }
+
+            if (xx > sw - 1)
+              xx = sw - 1;
+
+            rgba_type rgba = getRgba(bmp->getpixel(sx + xx, sy + yy));
+
+            r[i][j] = Gamma::fix(rgba.r);
+            g[i][j] = Gamma::fix(rgba.g);
+            b[i][j] = Gamma::fix(rgba.b);
+            a[i][j] = Gamma::fix(rgba.a);
+          }
+        }
+
+        const int rr = Gamma::unfix(clamp(Scale::bicubic(r, u, v), 65535));
+        const int gg = Gamma::unfix(clamp(Scale::bicubic(g, u, v), 65535));
+        const int bb = Gamma::unfix(clamp(Scale::bicubic(b, u, v), 65535));
+        const int aa = Gamma::unfix(clamp(Scale::bicubic(a, u, v), 65535));
+
+        *d++ = makeRgba(rr, gg, bb, aa);
+      }
+
+      if (Progress::update(y) < 0)
+        break;
+    }
+  }
+
+  Progress::hide();
+
+  return temp;
+}
+
 void Transform::init()
 {
   Resize::init();
@@ -766,6 +787,7 @@ void Transform::flipHorizontal()
 {
   Project::undo->push(Undo::FLIP_HORIZONTAL);
   Project::bmp->flipHorizontal();
+  Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
   Gui::getView()->drawMain(true);
 }
 
@@ -773,6 +795,7 @@ void Transform::flipVertical()
 {
   Project::undo->push(Undo::FLIP_VERTICAL);
   Project::bmp->flipVertical();
+  Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
   Gui::getView()->drawMain(true);
 }
 
@@ -796,6 +819,7 @@ void Transform::rotate90()
   Project::undo->push(Undo::ROTATE_90);
   Project::bmp->rotate90(false);
   Project::map->resize(Project::bmp->w, Project::bmp->h);
+  Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
   Gui::getView()->drawMain(true);
 }
 
@@ -803,6 +827,7 @@ void Transform::rotate180()
 {
   Project::undo->push(Undo::ROTATE_180);
   Project::bmp->rotate180();
+  Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
   Gui::getView()->drawMain(true);
 }
 
@@ -18,6 +18,19 @@ along with Rendera; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
 #include "Bitmap.H"
 #include "Gui.H"
 #include "Map.H"
@@ -25,44 +38,64 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Undo.H"
 #include "View.H"
 
+namespace
+{
+  // background compression of stored tiles, recycled tile records
+  // and the scratch file older tiles are spilled to
+  // never destroyed, since the thread may still be waiting on it at exit
+  struct store_type
+  {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<Undo::tile_type *> queue;
+    bool started = false;
+
+    std::vector<Undo::tile_type *> free_tiles;
+    std::vector<int *> free_data;
+
+    char *spill_base = 0;
+    int spill_slots = 0;
+    int spill_used = 0;
+    std::vector<int> free_slots;
+  };
+
+  store_type *store = new store_type;
+
+  // limits for recycled tiles, full-size buffers are 16K each
+  const int max_free_tiles = 4096;
+  const int max_free_data = 256;
+
+  // each spilled tile takes one slot, large enough for a raw tile
+  const int slot_size = Undo::TILE_SIZE * Undo::TILE_SIZE * sizeof(int);
+}
+
 // for debugging
 void Undo::printStacks()
 {
   printf("Undo Stack:\n");
 
-  for (int i = 0; i < levels; i++)
+  for (int i = 0; i < undo_count; i++)
   {
-    int x2 = undo_stack[i]->x;
-    int y2 = undo_stack[i]->y;
-    int w2 = undo_stack[i]->w;
-    int h2 = undo_stack[i]->h;
-
-    printf("%d: x2 = %d, y2 = %d, w2 = %d, h2 = %d ", i, x2, y2, w2, h2);
+    const level_type *level = undo_stack[(undo_head + i) % levels];
 
-    if (i == undo_current)
-      printf("<");
-
-    printf("\n");
+    printf("%d: x2 = %d, y2 = %d, w2 = %d, h2 = %d, tiles = %d\n",
+           i, level->x, level->y, level->w, level->h,
+           (int)level->tiles.size());
   }
 
   printf("\n");
   printf("Redo Stack:\n");
 
-  for (int i = 0; i < levels; i++)
+  for (int i = 0; i < redo_count; i++)
   {
-    int x2 = redo_stack[i]->x;
-    int y2 = redo_stack[i]->y;
-    int w2 = redo_stack[i]->w;
-    int h2 = redo_stack[i]->h;
+    const level_type *level = redo_stack[(redo_head + i) % levels];
 
-    printf("%d: x2 = %d, y2 = %d, w2 = %d, h2 = %d ", i, x2, y2, w2, h2);
-
-    if (i == redo_current)
-      printf("<");
-
-    printf("\n");
+    printf("%d: x2 = %d, y2 = %d, w2 = %d, h2 = %d, tiles = %d\n",
+           i, level->x, level->y, level->w, level->h,
+           (int)level->tiles.size());
   }
 
+  printf("tile memory = %.0lf, spilled = %.0lf\n", bytes, spilled);
   printf("--------------------------------------\n\n");
 }
 
@@ -70,15 +103,19 @@ Undo::Undo()
 {
   levels = Project::undo_max;
 
-  undo_stack = new Bitmap *[levels];
-  redo_stack = new Bitmap *[levels];
+  undo_stack = new level_type *[levels];
+  redo_stack = new level_type *[levels];
 
   for (int i = 0; i < levels; i++)
   {
-    undo_stack[i] = 0;
-    redo_stack[i] = 0;
+    undo_stack[i] = new level_type;
+    redo_stack[i] = new level_type;
+    clear(undo_stack[i]);
+    clear(redo_stack[i]);
   }
 
+  scratch.resize(TILE_SIZE * TILE_SIZE);
+
   reset();
 }
 
@@ -86,307 +123,782 @@ Undo::~Undo()
 {
   for (int i = 0; i < levels; i++)
   {
+    clear(undo_stack[i]);
+    clear(redo_stack[i]);
+
     delete undo_stack[i];
     delete redo_stack[i];
   }
+
+  delete[] undo_stack;
+  delete[] redo_stack;
 }
 
-void Undo::reset()
+// modes that are undone by reversing the operation instead of storing pixels
+bool Undo::isOperation(const int undo_mode)
 {
-  for (int i = 0; i < levels; i++)
-  {
-    delete undo_stack[i];
-    delete redo_stack[i];
+  return undo_mode == Undo::OFFSET || undo_mode == Undo::FLIP_HORIZONTAL ||
+         undo_mode == Undo::FLIP_VERTICAL || undo_mode == Undo::ROTATE_90 ||
+         undo_mode == Undo::ROTATE_180;
+}
 
-    undo_stack[i] = new Bitmap(8, 8);
-    redo_stack[i] = new Bitmap(8, 8);
+// must be called with the store locked
+void Undo::release(tile_type *tile)
+{
+  if (--tile->refs > 0)
+    return;
+
+  if (tile->index < (int)latest.size() && latest[tile->index] == tile)
+    latest[tile->index] = 0;
+
+  if (tile->slot >= 0)
+    spilled -= tile->size;
+  else
+    bytes -= tile->size;
+
+  // the compressor thread frees it when it gets to it
+  if (tile->queued)
+  {
+    tile->dead = true;
+    return;
   }
 
-  undo_current = levels - 1;
-  redo_current = levels - 1;
+  freeTile(tile);
 }
 
-void Undo::doPush(const int x, const int y, const int w, const int h,
-                  const int undo_mode)
+// tile records and full-size pixel buffers are recycled,
+// so pushing a level normally doesn't allocate
+// must be called with the store locked
+Undo::tile_type *Undo::newTile(const int w, const int h)
 {
-  if (undo_current < 0)
+  tile_type *tile;
+
+  if (store->free_tiles.empty())
   {
-    undo_current = 0;
+    tile = new tile_type;
+  }
+    else
+  {
+    tile = store->free_tiles.back();
+    store->free_tiles.pop_back();
+  }
 
-    Bitmap *temp_bmp = undo_stack[levels - 1];
+  if (w == TILE_SIZE && h == TILE_SIZE && !store->free_data.empty())
+  {
+    tile->data = store->free_data.back();
+    store->free_data.pop_back();
+  }
+    else
+  {
+    tile->data = new int[w * h];
+  }
 
-    for (int i = levels - 1; i > 0; i--)
-      undo_stack[i] = undo_stack[i - 1];
+  tile->refs = 0;
+  tile->w = w;
+  tile->h = h;
+  tile->packed = 0;
+  tile->size = w * h * sizeof(int) + sizeof(tile_type);
+  tile->queued = false;
+  tile->dead = false;
+  tile->slot = -1;
+  tile->owner = 0;
+
+  return tile;
+}
 
-    undo_stack[0] = temp_bmp;
+// returns a pixel buffer to the pool, or deletes it if the pool is full
+// must be called with the store locked
+void Undo::freeData(tile_type *tile)
+{
+  if (tile->w == TILE_SIZE && tile->h == TILE_SIZE &&
+      (int)store->free_data.size() < max_free_data)
+  {
+    store->free_data.push_back(tile->data);
   }
+    else
+  {
+    delete[] tile->data;
+  }
+
+  tile->data = 0;
+}
 
-  if (undo_mode == Undo::OFFSET || undo_mode == Undo::FLIP_HORIZONTAL ||
-      undo_mode == Undo::FLIP_VERTICAL || undo_mode == Undo::FLIP_VERTICAL ||
-      undo_mode == Undo::ROTATE_90 || undo_mode == Undo::ROTATE_180)
+// must be called with the store locked
+void Undo::freeTile(tile_type *tile)
+{
+  if (tile->slot >= 0)
   {
-    delete undo_stack[undo_current];
-    undo_stack[undo_current] = new Bitmap(8, 8);
+    // data lives in the scratch file
+    store->free_slots.push_back(tile->slot);
+    tile->data = 0;
+    tile->packed = 0;
   }
-   else
+    else if (tile->data)
   {
-    if (Project::enoughMemory(w, h) == false)
-      return;
+    freeData(tile);
+  }
+
+  delete[] tile->packed;
+
+  if ((int)store->free_tiles.size() < max_free_tiles)
+    store->free_tiles.push_back(tile);
+  else
+    delete tile;
+}
+
+// run-length encodes pixels, returns the encoded size in ints
+// a positive count is followed by that many literal pixels,
+// a negative count by one pixel repeated that many times
+int Undo::pack(const int *src, const int count, int *dest)
+{
+  int size = 0;
+  int i = 0;
+
+  while (i < count)
+  {
+    int run = 1;
 
-    delete undo_stack[undo_current];
-    undo_stack[undo_current] = new Bitmap(w, h);
+    while (i + run < count && src[i + run] == src[i])
+      run++;
 
-    Project::bmp->blit(undo_stack[undo_current], x, y, 0, 0, w, h);
+    if (run >= 3)
+    {
+      dest[size++] = -run;
+      dest[size++] = src[i];
+      i += run;
+      continue;
+    }
+
+    // literals continue until a run of at least three starts
+    const int start = i;
+
+    while (i < count)
+    {
+      if (i + 2 < count && src[i] == src[i + 1] && src[i] == src[i + 2])
+        break;
+
+      i++;
+    }
+
+    dest[size++] = i - start;
+    std::memcpy(dest + size, src + start, (i - start) * sizeof(int));
+    size += i - start;
   }
 
-  undo_stack[undo_current]->x = x;
-  undo_stack[undo_current]->y = y;
-  undo_stack[undo_current]->undo_mode = undo_mode;
-  undo_current--;
+  return size;
 }
 
-void Undo::push()
+void Undo::unpack(const int *src, const int count, int *dest)
 {
-  const int x = 0;
-  const int y = 0;
-  const int w = Project::bmp->w;
-  const int h = Project::bmp->h;
-  const int undo_mode = Undo::FULL;
+  int i = 0;
 
-  push(x, y, w, h, undo_mode);
+  while (i < count)
+  {
+    const int n = *src++;
+
+    if (n < 0)
+    {
+      std::fill(dest + i, dest + i - n, *src++);
+      i -= n;
+    }
+      else
+    {
+      std::memcpy(dest + i, src, n * sizeof(int));
+      src += n;
+      i += n;
+    }
+  }
 }
 
-void Undo::push(const int undo_mode)
+// returns a tile's pixels, decompressing into temp if needed
+// must be called with the store locked
+const int *Undo::pixels(const tile_type *tile, int *temp)
 {
-  const int x = 0;
-  const int y = 0;
-  const int w = Project::bmp->w;
-  const int h = Project::bmp->h;
+  if (tile->data)
+    return tile->data;
 
-  push(x, y, w, h, undo_mode);
+  unpack(tile->packed, tile->w * tile->h, temp);
+
+  return temp;
 }
 
-void Undo::push(const int x, const int y, const int w, const int h,
-                const int undo_mode)
+// creates the scratch file used to hold older undo levels
+// the file is unlinked right away, so it goes away with the program
+bool Undo::initSpill(const char *dir, const int max_mb)
 {
-  doPush(x, y, w, h, undo_mode);
+#ifdef WIN32
+  (void)dir;
+  (void)max_mb;
 
-  // reset redo list since user performed some action
-  for (int i = 0; i < levels; i++)
+  return false;
+#else
+  char path[4096];
+
+  snprintf(path, sizeof(path), "%s/rendera-undo-XXXXXX", dir);
+
+  const int fd = mkstemp(path);
+
+  if (fd < 0)
+    return false;
+
+  unlink(path);
+
+  const int slots = ((long long)max_mb * 1000000) / slot_size;
+  const off_t file_size = (off_t)slots * slot_size;
+
+  if (slots < 1 || ftruncate(fd, file_size) != 0)
   {
-    delete redo_stack[i];
-    redo_stack[i] = new Bitmap(8, 8);
+    close(fd);
+    return false;
   }
 
-  redo_current = levels - 1;
+  void *base = mmap(0, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
-  // printStacks();
+  close(fd);
+
+  if (base == MAP_FAILED)
+    return false;
+
+  std::lock_guard<std::mutex> guard(store->lock);
+
+  store->spill_base = (char *)base;
+  store->spill_slots = slots;
+
+  return true;
+#endif
 }
 
-void Undo::pop()
+// moves a tile's data into the scratch file, it's paged back in
+// by the system when the tile is read
+// must be called with the store locked
+bool Undo::spillTile(tile_type *tile)
 {
-  if (undo_current >= levels - 1)
-    return;
+  if (tile->slot >= 0 || tile->queued)
+    return false;
 
-  int x = undo_stack[undo_current + 1]->x;
-  int y = undo_stack[undo_current + 1]->y;
-  int w = undo_stack[undo_current + 1]->w;
-  int h = undo_stack[undo_current + 1]->h;
-  int undo_mode = undo_stack[undo_current + 1]->undo_mode;
+  int slot;
 
-  if (undo_mode == Undo::OFFSET)
+  if (!store->free_slots.empty())
   {
-    Project::bmp->offset(x, y, true);
-    undo_current++;
-    Gui::getView()->drawMain(true);
-    pushRedo(x, y, w, h, undo_mode);
-    return;
+    slot = store->free_slots.back();
+    store->free_slots.pop_back();
   }
-  else if (undo_mode == Undo::FLIP_HORIZONTAL)
+    else if (store->spill_used < store->spill_slots)
   {
-    Project::bmp->flipHorizontal();
-    undo_current++;
-    Gui::getView()->drawMain(true);
-    pushRedo(x, y, w, h, undo_mode);
-    return;
+    slot = store->spill_used++;
   }
-  else if (undo_mode == Undo::FLIP_VERTICAL)
+    else
   {
-    Project::bmp->flipVertical();
-    undo_current++;
-    Gui::getView()->drawMain(true);
-    pushRedo(x, y, w, h, undo_mode);
-    return;
+    return false;
   }
-  else if (undo_mode == Undo::ROTATE_90)
+
+  int *dest = (int *)(store->spill_base + (size_t)slot * slot_size);
+
+  if (tile->data)
   {
-    Project::bmp->rotate90(true);
-    Project::map->resize(Project::bmp->w, Project::bmp->h);
-    undo_current++;
-    Gui::getView()->drawMain(true);
-    pushRedo(x, y, w, h, undo_mode);
+    std::memcpy(dest, tile->data, tile->w * tile->h * sizeof(int));
+    freeData(tile);
+    tile->data = dest;
+  }
+    else
+  {
+    const int length = (tile->size - sizeof(tile_type)) / sizeof(int);
+
+    std::memcpy(dest, tile->packed, length * sizeof(int));
+    delete[] tile->packed;
+    tile->packed = dest;
+  }
+
+  tile->slot = slot;
+  tile->owner->bytes -= tile->size;
+  tile->owner->spilled += tile->size;
+
+  return true;
+}
+
+// spills the tiles of a level, except ones that new levels
+// are still compared against
+void Undo::spillLevel(level_type *level)
+{
+  std::lock_guard<std::mutex> guard(store->lock);
+
+  if (store->spill_base == 0)
     return;
+
+  for (size_t i = 0; i < level->tiles.size(); i++)
+  {
+    tile_type *tile = level->tiles[i];
+
+    if (tile->index < (int)latest.size() && latest[tile->index] == tile)
+      continue;
+
+    if (spillTile(tile) == false && tile->slot < 0 && !tile->queued)
+      return;
   }
-  else if (undo_mode == Undo::ROTATE_180)
+}
+
+// compressor thread, replaces raw tile data with packed data
+// when that saves memory
+void Undo::compressTiles()
+{
+  std::vector<int> temp(TILE_SIZE * TILE_SIZE * 2);
+
+  while (true)
   {
-    Project::bmp->rotate180();
-    undo_current++;
-    Gui::getView()->drawMain(true);
-    pushRedo(x, y, w, h, undo_mode);
+    tile_type *tile;
+    bool dead;
+
+    {
+      std::unique_lock<std::mutex> guard(store->lock);
+
+      store->wake.wait(guard, []{ return !store->queue.empty(); });
+      tile = store->queue.front();
+      store->queue.pop_front();
+      dead = tile->dead;
+    }
+
+    // the tile stays queued while packing, so it can't be deleted,
+    // and its raw data is never modified while it exists
+    int size = 0;
+
+    if (!dead)
+      size = pack(tile->data, tile->w * tile->h, &temp[0]);
+
+    std::lock_guard<std::mutex> guard(store->lock);
+
+    tile->queued = false;
+
+    if (tile->dead)
+    {
+      freeTile(tile);
+      continue;
+    }
+
+    if (size >= (tile->w * tile->h * 3) / 4)
+      continue;
+
+    tile->packed = new int[size];
+    std::memcpy(tile->packed, &temp[0], size * sizeof(int));
+    freeData(tile);
+
+    const int new_size = size * sizeof(int) + sizeof(tile_type);
+
+    tile->owner->bytes += new_size - tile->size;
+    tile->size = new_size;
+  }
+}
+
+void Undo::clear(level_type *level)
+{
+  std::lock_guard<std::mutex> guard(store->lock);
+
+  for (size_t i = 0; i < level->tiles.size(); i++)
+    release(level->tiles[i]);
+
+  level->tiles.clear();
+  level->x = 0;
+  level->y = 0;
+  level->w = 0;
+  level->h = 0;
+  level->undo_mode = PARTIAL;
+  level->image_w = 0;
+  level->image_h = 0;
+  level->tx1 = 0;
+  level->ty1 = 0;
+  level->tx2 = -1;
+  level->ty2 = -1;
+}
+
+// stores the tiles covering an image region
+// a tile that is identical to the last one stored at the same position
+// is shared instead of copied, so memory only grows with what changed
+void Undo::capture(level_type *level, const int x, const int y,
+                   const int w, const int h, const int undo_mode)
+{
+  Bitmap *bmp = Project::bmp;
+
+  clear(level);
+
+  level->x = x;
+  level->y = y;
+  level->w = w;
+  level->h = h;
+  level->undo_mode = undo_mode;
+  level->image_w = bmp->w;
+  level->image_h = bmp->h;
+
+  if (isOperation(undo_mode))
     return;
+
+  const int x1 = std::max(x, 0);
+  const int y1 = std::max(y, 0);
+  const int x2 = std::min(x + w - 1, bmp->w - 1);
+  const int y2 = std::min(y + h - 1, bmp->h - 1);
+
+  if (x2 < x1 || y2 < y1)
+    return;
+
+  std::lock_guard<std::mutex> guard(store->lock);
+  const int cols = (bmp->w + TILE_SIZE - 1) >> TILE_BITS;
+  const int rows = (bmp->h + TILE_SIZE - 1) >> TILE_BITS;
+
+  // image size changed, old tiles can't be matched by position anymore
+  if (cols != latest_cols || rows != latest_rows)
+  {
+    latest.assign(cols * rows, 0);
+    latest_cols = cols;
+    latest_rows = rows;
   }
-  else if (undo_mode == Undo::FULL)
+
+  level->tx1 = x1 >> TILE_BITS;
+  level->ty1 = y1 >> TILE_BITS;
+  level->tx2 = x2 >> TILE_BITS;
+  level->ty2 = y2 >> TILE_BITS;
+  level->tiles.reserve((level->tx2 - level->tx1 + 1) *
+                       (level->ty2 - level->ty1 + 1));
+
+  for (int ty = level->ty1; ty <= level->ty2; ty++)
   {
-    pushRedo(0, 0, Project::bmp->w, Project::bmp->h, undo_mode);
+    const int py = ty << TILE_BITS;
+    const int th = std::min((int)TILE_SIZE, bmp->h - py);
+
+    for (int tx = level->tx1; tx <= level->tx2; tx++)
+    {
+      const int px = tx << TILE_BITS;
+      const int tw = std::min((int)TILE_SIZE, bmp->w - px);
+      const int index = ty * cols + tx;
+
+      tile_type *tile = latest[index];
+      bool same = (tile != 0 && tile->w == tw && tile->h == th);
+      const int *data = same ? pixels(tile, &scratch[0]) : 0;
+
+      for (int j = 0; same && j < th; j++)
+      {
+        same = std::memcmp(data + j * tw, bmp->row[py + j] + px,
+                           tw * sizeof(int)) == 0;
+      }
+
+      if (!same)
+      {
+        tile = newTile(tw, th);
+        tile->index = index;
+        tile->owner = this;
+
+        for (int j = 0; j < th; j++)
+        {
+          std::memcpy(tile->data + j * tw, bmp->row[py + j] + px,
+                      tw * sizeof(int));
+        }
+
+        bytes += tile->size;
+        latest[index] = tile;
+
+        if (Project::undo_compress)
+        {
+          tile->queued = true;
+          store->queue.push_back(tile);
+        }
+      }
+
+      tile->refs++;
+      level->tiles.push_back(tile);
+    }
   }
-    else
+
+  if (Project::undo_compress && !store->queue.empty())
   {
-    pushRedo(x, y, w, h, undo_mode);
+    if (!store->started)
+    {
+      store->started = true;
+      std::thread(compressTiles).detach();
+    }
+
+    store->wake.notify_one();
+  }
+}
+
+// copies a level's tiles back into the image
+void Undo::restore(level_type *level)
+{
+  if (level->undo_mode == Undo::FULL &&
+      (Project::bmp->w != level->image_w || Project::bmp->h != level->image_h))
+  {
+    Project::replaceImage(level->image_w, level->image_h);
   }
 
-  if (undo_current >= 0)
+  std::lock_guard<std::mutex> guard(store->lock);
+  Bitmap *bmp = Project::bmp;
+  int i = 0;
+
+  for (int ty = level->ty1; ty <= level->ty2; ty++)
   {
-    delete undo_stack[undo_current];
-    undo_stack[undo_current] = new Bitmap(8, 8);
+    for (int tx = level->tx1; tx <= level->tx2; tx++)
+    {
+      const tile_type *tile = level->tiles[i++];
+      const int px = tx << TILE_BITS;
+      const int py = ty << TILE_BITS;
+      const int tw = std::min(tile->w, bmp->w - px);
+      const int th = std::min(tile->h, bmp->h - py);
+
+      if (tw < 1 || th < 1)
+        continue;
+
+      const int *data = pixels(tile, &scratch[0]);
+
+      for (int j = 0; j < th; j++)
+      {
+        std::memcpy(bmp->row[py + j] + px, data + j * tile->w,
+                    tw * sizeof(int));
+      }
+    }
   }
+}
+
+// memory used by stored tiles, compressed tiles count their packed size
+double Undo::getMemory()
+{
+  std::lock_guard<std::mutex> guard(store->lock);
+
+  return bytes;
+}
 
-  undo_current++;
+// size of tiles moved to the scratch file, not counted by getMemory()
+double Undo::getSpilledMemory()
+{
+  std::lock_guard<std::mutex> guard(store->lock);
 
-  x = undo_stack[undo_current]->x;
-  y = undo_stack[undo_current]->y;
-  w = undo_stack[undo_current]->w;
-  h = undo_stack[undo_current]->h;
-  undo_mode = undo_stack[undo_current]->undo_mode;
+  return spilled;
+}
 
-  if(undo_mode == Undo::FULL)
-    Project::replaceImage(w, h);
+void Undo::reset()
+{
+  for (int i = 0; i < undo_count; i++)
+    clear(undo_stack[(undo_head + i) % levels]);
 
-  undo_stack[undo_current]->blit(Project::bmp, 0, 0, x, y, w, h);
-  Gui::getView()->drawMain(true);
+  for (int i = 0; i < redo_count; i++)
+    clear(redo_stack[(redo_head + i) % levels]);
 
-  // printStacks();
+  latest.clear();
+  latest_cols = 0;
+  latest_rows = 0;
+
+  undo_head = 0;
+  undo_count = 0;
+  redo_head = 0;
+  redo_count = 0;
 }
 
-void Undo::pushRedo(const int x, const int y, const int w, const int h,
-                    const int undo_mode)
+// returns the slot for a new level on a ring buffer stack,
+// when the stack is full the oldest level is dropped and its slot reused
+Undo::level_type *Undo::nextLevel(level_type **stack, int *head, int *count)
 {
-  if (redo_current < 0)
-  {
-    redo_current = 0;
+  if (*count < levels)
+    return stack[(*head + *count) % levels];
 
-    Bitmap *temp_bmp = redo_stack[levels - 1];
+  level_type *level = stack[*head];
 
-    for (int i = levels - 1; i > 0; i--)
-      redo_stack[i] = redo_stack[i - 1];
+  *head = (*head + 1) % levels;
+  *count -= 1;
 
-    redo_stack[0] = temp_bmp;
-  }
+  return level;
+}
 
-  if (undo_mode == Undo::OFFSET || undo_mode == Undo::FLIP_HORIZONTAL ||
-      undo_mode == Undo::FLIP_VERTICAL || undo_mode == Undo::FLIP_VERTICAL ||
-      undo_mode == Undo::ROTATE_90 || undo_mode == Undo::ROTATE_180)
+void Undo::doPush(const int x, const int y, const int w, const int h,
+                  const int undo_mode)
+{
+  level_type *level = nextLevel(undo_stack, &undo_head, &undo_count);
+
+  capture(level, x, y, w, h, undo_mode);
+
+  // only new tiles count against the limit
+  if (Project::enoughMemory(0, 0) == false)
   {
-    delete redo_stack[redo_current];
-    redo_stack[redo_current] = new Bitmap(8, 8);
+    clear(level);
+    return;
   }
-   else
-  {
-    if (Project::enoughMemory(w, h) == false)
-      return;
 
-    delete redo_stack[redo_current];
-    redo_stack[redo_current] = new Bitmap(w, h);
+  undo_count++;
 
-    Project::bmp->blit(redo_stack[redo_current], x, y, 0, 0, w, h);
+  // the newest levels stay in memory
+  if (undo_count > RESIDENT_LEVELS)
+  {
+    spillLevel(undo_stack[(undo_head + undo_count - 1 - RESIDENT_LEVELS) %
+                          levels]);
   }
+}
 
-  redo_stack[redo_current]->x = x;
-  redo_stack[redo_current]->y = y;
-  redo_stack[redo_current]->undo_mode = undo_mode;
-  redo_current--;
+void Undo::push()
+{
+  const int x = 0;
+  const int y = 0;
+  const int w = Project::bmp->w;
+  const int h = Project::bmp->h;
+  const int undo_mode = Undo::FULL;
+
+  push(x, y, w, h, undo_mode);
 }
 
-void Undo::popRedo()
+void Undo::push(const int undo_mode)
+{
+  const int x = 0;
+  const int y = 0;
+  const int w = Project::bmp->w;
+  const int h = Project::bmp->h;
+
+  push(x, y, w, h, undo_mode);
+}
+
+void Undo::push(const int x, const int y, const int w, const int h,
+                const int undo_mode)
 {
-  if (redo_current >= levels - 1)
+  doPush(x, y, w, h, undo_mode);
+
+  // reset redo list since user performed some action
+  for (int i = 0; i < redo_count; i++)
+    clear(redo_stack[(redo_head + i) % levels]);
+
+  redo_head = 0;
+  redo_count = 0;
+
+  // printStacks();
+}
+
+void Undo::pop()
+{
+  if (undo_count == 0)
     return;
 
-  int x = redo_stack[redo_current + 1]->x;
-  int y = redo_stack[redo_current + 1]->y;
-  int w = redo_stack[redo_current + 1]->w;
-  int h = redo_stack[redo_current + 1]->h;
-  int undo_mode = redo_stack[redo_current + 1]->undo_mode;
+  level_type *level = undo_stack[(undo_head + undo_count - 1) % levels];
 
-  if (undo_mode == Undo::OFFSET)
+  const int x = level->x;
+  const int y = level->y;
+  const int w = level->w;
+  const int h = level->h;
+  const int undo_mode = level->undo_mode;
+
+  if (isOperation(undo_mode))
   {
-    Project::bmp->offset(x, y, false);
-    redo_current++;
+    if (undo_mode == Undo::OFFSET)
+    {
+      Project::bmp->offset(x, y, true);
+    }
+    else if (undo_mode == Undo::FLIP_HORIZONTAL)
+    {
+      Project::bmp->flipHorizontal();
+    }
+    else if (undo_mode == Undo::FLIP_VERTICAL)
+    {
+      Project::bmp->flipVertical();
+    }
+    else if (undo_mode == Undo::ROTATE_90)
+    {
+      Project::bmp->rotate90(true);
+      Project::map->resize(Project::bmp->w, Project::bmp->h);
+    }
+    else if (undo_mode == Undo::ROTATE_180)
+    {
+      Project::bmp->rotate180();
+    }
+
+    undo_count--;
+    clear(level);
+    Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
     Gui::getView()->drawMain(true);
-    doPush(x, y, w, h, undo_mode);
+    pushRedo(x, y, w, h, undo_mode);
     return;
   }
-  else if (undo_mode == Undo::FLIP_HORIZONTAL)
+  else if (undo_mode == Undo::FULL)
   {
-    Project::bmp->flipHorizontal();
-    redo_current++;
-    Gui::getView()->drawMain(true);
-    doPush(x, y, w, h, undo_mode);
-    return;
+    pushRedo(0, 0, Project::bmp->w, Project::bmp->h, undo_mode);
   }
-  else if (undo_mode == Undo::FLIP_VERTICAL)
+    else
   {
-    Project::bmp->flipVertical();
-    redo_current++;
-    Gui::getView()->drawMain(true);
-    doPush(x, y, w, h, undo_mode);
-    return;
+    pushRedo(x, y, w, h, undo_mode);
   }
-  else if (undo_mode == Undo::ROTATE_90)
+
+  undo_count--;
+  restore(level);
+  clear(level);
+  Gui::getView()->invalidate(x, y, x + w - 1, y + h - 1);
+  Gui::getView()->drawDirty(true);
+
+  // printStacks();
+}
+
+void Undo::pushRedo(const int x, const int y, const int w, const int h,
+                    const int undo_mode)
+{
+  level_type *level = nextLevel(redo_stack, &redo_head, &redo_count);
+
+  capture(level, x, y, w, h, undo_mode);
+
+  if (Project::enoughMemory(0, 0) == false)
   {
-    Project::bmp->rotate90(false);
-    Project::map->resize(Project::bmp->w, Project::bmp->h);
-    redo_current++;
-    Gui::getView()->drawMain(true);
-    doPush(x, y, w, h, undo_mode);
+    clear(level);
     return;
   }
-  else if (undo_mode == Undo::ROTATE_180)
+
+  redo_count++;
+}
+
+void Undo::popRedo()
+{
+  if (redo_count == 0)
+    return;
+
+  level_type *level = redo_stack[(redo_head + redo_count - 1) % levels];
+
+  const int x = level->x;
+  const int y = level->y;
+  const int w = level->w;
+  const int h = level->h;
+  const int undo_mode = level->undo_mode;
+
+  if (isOperation(undo_mode))
   {
-    Project::bmp->rotate180();
-    redo_current++;
+    if (undo_mode == Undo::OFFSET)
+    {
+      Project::bmp->offset(x, y, false);
+    }
+    else if (undo_mode == Undo::FLIP_HORIZONTAL)
+    {
+      Project::bmp->flipHorizontal();
+    }
+    else if (undo_mode == Undo::FLIP_VERTICAL)
+    {
+      Project::bmp->flipVertical();
+    }
+    else if (undo_mode == Undo::ROTATE_90)
+    {
+      Project::bmp->rotate90(false);
+      Project::map->resize(Project::bmp->w, Project::bmp->h);
+    }
+    else if (undo_mode == Undo::ROTATE_180)
+    {
+      Project::bmp->rotate180();
+    }
+
+    redo_count--;
+    clear(level);
+    Gui::getView()->invalidate(0, 0, Project::bmp->w - 1, Project::bmp->h - 1);
     Gui::getView()->drawMain(true);
     doPush(x, y, w, h, undo_mode);
     return;
   }
   else if (undo_mode == Undo::FULL)
   {
-    doPush(0, 0, Project::bmp->w, Project::bmp->h, 1);
+    doPush(0, 0, Project::bmp->w, Project::bmp->h, undo_mode);
   }
-   else
+    else
   {
     doPush(x, y, w, h, undo_mode);
   }
 
-  if (redo_current >= 0)
-  {
-    delete redo_stack[redo_current];
-    redo_stack[redo_current] = new Bitmap(8, 8);
-  }
-
-  redo_current++;
-
-  x = redo_stack[redo_current]->x;
-  y = redo_stack[redo_current]->y;
-  w = redo_stack[redo_current]->w;
-  h = redo_stack[redo_current]->h;
-  undo_mode = redo_stack[redo_current]->undo_mode;
-
-  if (undo_mode == Undo::FULL)
-    Project::replaceImage(w, h);
-
-  redo_stack[redo_current]->blit(Project::bmp, 0, 0, x, y, w, h);
-
-  Gui::getView()->drawMain(true);
+  redo_count--;
+  restore(level);
+  clear(level);
+  Gui::getView()->invalidate(x, y, x + w - 1, y + h - 1);
+  Gui::getView()->drawDirty(true);
 
   // printStacks();
 }
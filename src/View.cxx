@@ -19,6 +19,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 */
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 #include <FL/fl_draw.H>
 
@@ -34,9 +36,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 #include "Images.H"
 #include "Inline.H"
 #include "Map.H"
+#include "Mipmap.H"
 #include "Palette.H"
 #include "Project.H"
 #include "Stroke.H"
+#include "Threads.H"
 #include "Tool.H"
 #include "ToggleButton.H"
 #include "ToolOptions.H"
@@ -205,6 +209,11 @@ View::View(Fl_Group *g, int x, int y, int w, int h, const char *label)
   bgr_order = false;
   backbuf = 0;
   dnd = false;
+  display = 0;
+  display_valid = false;
+  scrolling = false;
+  dirty = false;
+  partial = false;
 
   resize(group->x() + x, group->y() + y, w, h);
 }
@@ -392,7 +401,10 @@ int View::handle(int event)
           oy = (h() - 1 - (mousey / ay)) / zoom - last_oy; 
 
           clipOrigin();
+
+          scrolling = true;
           Project::tool->redraw(this);
+          scrolling = false;
 
           saveCoords();
           break;
@@ -519,6 +531,9 @@ void View::resize(int x, int y, int w, int h)
 
   delete backbuf;
   backbuf = new Bitmap(new_width, new_height);
+  delete display;
+  display = new Bitmap(new_width, new_height);
+  display_valid = false;
   wimage = new Fl_RGB_Image((unsigned char *)backbuf->data,
                              new_width, new_height, 4, 0);
   wimage->scale(w, h, 0, 1);
@@ -553,44 +568,254 @@ void View::changeAspect(int new_aspect)
   drawMain(true);
 }
 
-void View::drawMain(bool refresh)
+// marks part of the image as changed for the next drawDirty()
+void View::invalidate(int x1, int y1, int x2, int y2)
 {
-  int sw = w() / zoom;
-  int sh = h() / zoom;
+  if (x1 > x2)
+    std::swap(x1, x2);
 
-  int dw = sw * zoom;
-  int dh = sh * zoom;
+  if (y1 > y2)
+    std::swap(y1, y2);
 
-  backbuf->clear(getFltkColor(FL_BACKGROUND2_COLOR));
+  if (dirty == false)
+  {
+    dirty_x1 = x1;
+    dirty_y1 = y1;
+    dirty_x2 = x2;
+    dirty_y2 = y2;
+    dirty = true;
+  }
+    else
+  {
+    dirty_x1 = std::min(dirty_x1, x1);
+    dirty_y1 = std::min(dirty_y1, y1);
+    dirty_x2 = std::max(dirty_x2, x2);
+    dirty_y2 = std::max(dirty_y2, y2);
+  }
 
-  int offx = 0;
-  int offy = 0;
+  Project::mipmap->invalidate(x1, y1, x2, y2);
+}
 
-  if (ox < 0)
-    offx = -ox;
+// redraws the whole image
+void View::drawMain(bool refresh)
+{
+  // the image is unchanged while scrolling, so what's already
+  // in the display can be moved instead of redrawn
+  if (scrolling == false)
+    display_valid = false;
 
-  if (oy < 0)
-    offy = -oy;
+  drawDirty(refresh);
+}
 
+// redraws only the parts of the image marked by invalidate(),
+// unless the image or viewport changed since the last update
+void View::drawDirty(bool refresh)
+{
   Bitmap *bmp = Project::bmp;
 
-  bmp->pointStretch(backbuf,
-                    ox, oy,
-                    sw - offx, sh - offy,
-                    offx * zoom, offy * zoom,
-                    dw - offx * zoom, dh - offy * zoom,
-                    bgr_order);
+  const int dw = display->w;
+  const int dh = display->h;
+
+  partial = false;
+
+  if (display_valid == false || display_bmp != bmp ||
+      display_bmp_w != bmp->w || display_bmp_h != bmp->h ||
+      display_zoom != zoom || display_bgr_order != bgr_order)
+  {
+    display_valid = false;
+  }
+    else if (display_ox != ox || display_oy != oy)
+  {
+    display_valid = dirty == false && shiftDisplay();
+  }
+    else if (dirty)
+  {
+    // viewport area covering the changed pixels
+    const int x1 = std::max((int)std::floor((dirty_x1 - ox) * zoom), 0);
+    const int y1 = std::max((int)std::floor((dirty_y1 - oy) * zoom), 0);
+    const int x2 = std::min((int)std::ceil((dirty_x2 + 1 - ox) * zoom), dw) - 1;
+    const int y2 = std::min((int)std::ceil((dirty_y2 + 1 - oy) * zoom), dh) - 1;
+
+    if (x1 <= x2 && y1 <= y2)
+    {
+      stretch(x1, y1, x2, y2);
+
+      // nothing else is drawn over the image while rendering,
+      // so only the changed area has to be sent to the screen
+      if (refresh && rendering && aspect == ASPECT_NORMAL)
+      {
+        partial = true;
+        partial_x = x1;
+        partial_y = y1;
+        partial_w = x2 - x1 + 1;
+        partial_h = y2 - y1 + 1;
+      }
+    }
+  }
+
+  if (display_valid == false)
+  {
+    display->clear(getFltkColor(FL_BACKGROUND2_COLOR));
+    stretch(0, 0, dw - 1, dh - 1);
+
+    display_valid = true;
+    display_bmp = bmp;
+    display_bmp_w = bmp->w;
+    display_bmp_h = bmp->h;
+    display_ox = ox;
+    display_oy = oy;
+    display_zoom = zoom;
+    display_bgr_order = bgr_order;
+  }
+
+  dirty = false;
+
+  std::copy(display->data, display->data + display->w * display->h,
+            backbuf->data);
 
   if (grid)
     drawGrid();
 
   if (refresh)
   {
-    resized = true;
+    if (partial == false)
+      resized = true;
+
     redraw();
   }
 }
 
+// moves the display contents after a scroll and renders the parts
+// that scrolled into view, returns false if a full redraw is needed
+bool View::shiftDisplay()
+{
+  // only whole-pixel moves keep the sampling and checkerboard aligned
+  const float old_x = display_ox * zoom;
+  const float old_y = display_oy * zoom;
+  const float new_x = ox * zoom;
+  const float new_y = oy * zoom;
+
+  if (old_x != (int)old_x || old_y != (int)old_y ||
+      new_x != (int)new_x || new_y != (int)new_y)
+  {
+    return false;
+  }
+
+  const int dw = display->w;
+  const int dh = display->h;
+  const int sx = old_x - new_x;
+  const int sy = old_y - new_y;
+
+  if (std::abs(sx) >= dw || std::abs(sy) >= dh)
+    return false;
+
+  const int bg = getFltkColor(FL_BACKGROUND2_COLOR);
+  const int count = dw - std::abs(sx);
+  const int dest_x = std::max(sx, 0);
+  const int src_x = std::max(-sx, 0);
+
+  // move rows in an order that doesn't overwrite rows not yet moved
+  for (int i = 0; i < dh; i++)
+  {
+    const int y = sy > 0 ? dh - 1 - i : i;
+    const int src_y = y - sy;
+    int *d = display->row[y];
+
+    if (src_y < 0 || src_y >= dh)
+    {
+      std::fill(d, d + dw, bg);
+      continue;
+    }
+
+    std::memmove(d + dest_x, display->row[src_y] + src_x,
+                 count * sizeof(int));
+
+    if (sx > 0)
+      std::fill(d, d + sx, bg);
+    else
+      std::fill(d + count, d + dw, bg);
+  }
+
+  display_ox = ox;
+  display_oy = oy;
+
+  // fill in the uncovered strips
+  if (sy > 0)
+    stretch(0, 0, dw - 1, sy - 1);
+  else if (sy < 0)
+    stretch(0, dh + sy, dw - 1, dh - 1);
+
+  if (sx > 0)
+    stretch(0, 0, sx - 1, dh - 1);
+  else if (sx < 0)
+    stretch(dw + sx, 0, dw - 1, dh - 1);
+
+  return true;
+}
+
+// renders part of the viewport (in viewport coordinates) into the display
+void View::stretch(int x1, int y1, int x2, int y2)
+{
+  const Bitmap *bmp = Project::bmp;
+
+  // keep inside the image
+  x1 = std::max(x1, (int)std::ceil(-ox * zoom));
+  y1 = std::max(y1, (int)std::ceil(-oy * zoom));
+  x2 = std::min(x2, (int)std::ceil((bmp->w - ox) * zoom) - 1);
+  y2 = std::min(y2, (int)std::ceil((bmp->h - oy) * zoom) - 1);
+
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  // image pixels per viewport pixel, 16.16 fixed point
+  const int64_t step = 65536 / zoom;
+
+  // when zoomed out, read from a reduced copy of the image so every
+  // image pixel contributes, except while rendering where the
+  // copy would have to be rebuilt for each update
+  const Bitmap *src = bmp;
+  int level = 0;
+
+  if (rendering == false)
+  {
+    while (level < Mipmap::MAX_LEVELS && zoom * (2 << level) <= 1)
+      level++;
+
+    if (level > 0)
+      src = Project::mipmap->getLevel(bmp, level);
+  }
+
+  // alpha checkerboard placement
+  const int checker_offset_x = ox * zoom;
+  const int checker_offset_y = oy * zoom;
+
+  auto row = [&](const int y)
+  {
+    const int *s = src->row[(oy + ((y * step) >> 16)) >> level];
+    const int checker_y = (y + checker_offset_y) >> 3;
+    int *d = display->row[y] + x1;
+
+    for (int x = x1; x <= x2; x++)
+    {
+      const int c = s[(ox + ((x * step) >> 16)) >> level];
+
+      // opaque pixels don't show the checkerboard
+      if (geta(c) == 255)
+      {
+        *d++ = convertFormat(c, bgr_order);
+        continue;
+      }
+
+      const int checker_x = (x + checker_offset_x) >> 3;
+      const int checker = (checker_x ^ checker_y) & 1 ? 0x989898 : 0x686868;
+
+      *d++ = convertFormat(blendFast(checker, c, 255 - geta(c)), bgr_order);
+    }
+  };
+
+  Threads::run(y1, y2, row);
+}
+
 void View::drawGrid()
 {
   int x1, y1, x2, y2, t, i;
@@ -838,7 +1063,10 @@ void View::scroll(int dir, int amount)
   }
 
   saveCoords();
+
+  scrolling = true;
   Project::tool->redraw(this);
+  scrolling = false;
 }
 
 void View::clipOrigin()
@@ -881,7 +1109,22 @@ void View::draw()
       break;
   }
 
-  if (Project::tool->isActive() && resized == false)
+  if (partial && resized == false)
+  {
+    float scale = getScale();
+
+    const int x1 = partial_x / scale;
+    const int y1 = partial_y / scale;
+
+    updateView(x1, y1, x() + x1, y() + y1,
+               partial_w / scale + 1, partial_h / scale + 1);
+
+    if (Clone::active)
+      drawCloneCursor();
+
+    partial = false;
+  }
+    else if (Project::tool->isActive() && resized == false)
   {
     float scale = getScale();
 